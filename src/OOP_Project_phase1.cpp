@@ -1,5 +1,6 @@
 #include <bits/stdc++.h>
 #include <filesystem>
+#include "symboltable.h"
 namespace fs = std::filesystem;
 using namespace std;
 
@@ -72,14 +73,54 @@ public:
     }
 };
 
+// stod with from_chars: the longest number at the front, invalid_argument or out_of_range when there is none
+double toDouble(string_view s)
+{
+    size_t i = 0;
+    while (i < s.size() && isspace((unsigned char)s[i]))
+        i++;
+    bool negative = false;
+    if (i < s.size() && (s[i] == '+' || s[i] == '-'))
+    {
+        negative = s[i] == '-';
+        i++;
+        if (i < s.size() && (s[i] == '+' || s[i] == '-'))
+            throw invalid_argument("stod");
+    }
+    double value;
+    auto result = from_chars(s.data() + i, s.data() + s.size(), value);
+    if (result.ec == errc::invalid_argument)
+        throw invalid_argument("stod");
+    if (result.ec == errc::result_out_of_range)
+        throw out_of_range("stod");
+    return negative ? -value : value;
+}
+
 double parseRes(const string& valueStr)
 {
-    regex valRegex(R"(^([0-9.]+)(e[+-]?[0-9]+)?(k|K|Meg|M)?$)");
-    smatch match;
-    if (!regex_match(valueStr, match, valRegex))
+    // <digits and dots>[e[+-]<digits>][k|K|Meg|M]
+    string_view s = valueStr;
+    size_t i = 0;
+    while (i < s.size() && (isdigit((unsigned char)s[i]) || s[i] == '.'))
+        i++;
+    if (i == 0)
         throw SyntaxError("Error: Invalid resistance value format");
-    double value = stod(match[1].str() + (match[2].matched ? match[2].str() : ""));
-    string suffix = match[3].matched ? match[3].str() : "";
+    size_t number = i;
+    if (i < s.size() && s[i] == 'e')
+    {
+        size_t j = i + 1;
+        if (j < s.size() && (s[j] == '+' || s[j] == '-'))
+            j++;
+        size_t digits = j;
+        while (j < s.size() && isdigit((unsigned char)s[j]))
+            j++;
+        if (j > digits)
+            number = i = j;
+    }
+    string_view suffix = s.substr(i);
+    if (!suffix.empty() && suffix != "k" && suffix != "K" && suffix != "Meg" && suffix != "M")
+        throw SyntaxError("Error: Invalid resistance value format");
+    double value = toDouble(s.substr(0, number));
     if (suffix == "k" || suffix == "K")
         value *= 1e3;
     else if (suffix == "M" || suffix == "Meg")
@@ -90,29 +131,29 @@ double parseRes(const string& valueStr)
 }
 
 double parseVoltage(const string& s) {
-    return stod(s);
+    return toDouble(s);
 }
 
 double parseFrequency(const string& s) {
-    return stod(s);
+    return toDouble(s);
 }
 
 double parsePhase(const string& s) {
-    return stod(s);
+    return toDouble(s);
 }
 
 double parseCapValue(const string& val)
 {
-    double num;
-    char suffix = val.back();
+    string_view s = val;
+    char suffix = s.back();
     try {
         if (suffix == 'u' || suffix == 'U')
-            return stod(val.substr(0, val.size() - 1)) * 1e-6;
+            return toDouble(s.substr(0, s.size() - 1)) * 1e-6;
         if (suffix == 'n' || suffix == 'N')
-            return stod(val.substr(0, val.size() - 1)) * 1e-9;
+            return toDouble(s.substr(0, s.size() - 1)) * 1e-9;
         if (suffix == 'f' || suffix == 'F')
-            return stod(val.substr(0, val.size() - 1));
-        return stod(val);
+            return toDouble(s.substr(0, s.size() - 1));
+        return toDouble(s);
     }
     catch (...)
     {
@@ -120,18 +161,18 @@ double parseCapValue(const string& val)
     }
 }
 
-double parseInductance(const string& s)
+double parseInductance(const string& val)
 {
-    double num;
+    string_view s = val;
     char suffix = s.back();
     try {
         if (suffix == 'u' || suffix == 'U')
-            return stod(s.substr(0, s.size() - 1)) * 1e-6;
+            return toDouble(s.substr(0, s.size() - 1)) * 1e-6;
         if (suffix == 'n' || suffix == 'N')
-            return stod(s.substr(0, s.size() - 1)) * 1e-9;
+            return toDouble(s.substr(0, s.size() - 1)) * 1e-9;
         if (suffix == 'f' || suffix == 'F')
-            return stod(s.substr(0, s.size() - 1));
-        return stod(s);
+            return toDouble(s.substr(0, s.size() - 1));
+        return toDouble(s);
     }
     catch (...)
     {
@@ -410,12 +451,59 @@ class Circuit
 
     vector<Node*> nodes;
 
+    // node and component names share one table, the lookups below are by name id
+    SymbolTable<string> names;
+    vector<Node*> nodeByName;           // nullptr when no node has the name
+    vector<int> componentsByName;       // components whose getName() is the name
+
+    int nameID(const string& name)
+    {
+        int id = names.intern(name);
+        if (id >= (int)nodeByName.size())
+        {
+            nodeByName.resize(id + 1, nullptr);
+            componentsByName.resize(id + 1, 0);
+        }
+        return id;
+    }
+
+    Node* findNode(const string& name) const
+    {
+        int id = names.find(name);
+        return id < 0 ? nullptr : nodeByName[id];
+    }
+
+    bool hasComponent(const string& name) const
+    {
+        int id = names.find(name);
+        return id >= 0 && componentsByName[id] > 0;
+    }
+
+    void insertComponent(Component* c)
+    {
+        components.push_back(c);
+        componentsByName[nameID(c->getName())]++;
+    }
+
+    void eraseComponent(int i)
+    {
+        componentsByName[nameID(components[i]->getName())]--;
+        delete components[i];
+        components.erase(components.begin() + i);
+    }
+
+    Node* insertNode(const string& id)
+    {
+        Node* node = new Node(id);
+        nodes.push_back(node);
+        nodeByName[nameID(id)] = node;
+        return node;
+    }
+
     void ensureNodeExists(const string& id)
     {
-        for (auto node : nodes)
-            if (node->getID() == id)
-                return;
-        nodes.push_back(new Node(id));
+        if (!findNode(id))
+            insertNode(id);
     }
 
 public:
@@ -430,21 +518,20 @@ public:
     }
     void addVoltageSource(const string& name, const string& node1, const string& node2, double value)
     {
-        components.push_back(new VoltageSource(name, node1, node2, value));
+        insertComponent(new VoltageSource(name, node1, node2, value));
         cout << "Voltage Source " << name << " added.\n";
     }
 
     void addCurrentSource(const string& name, const string& node1, const string& node2, double value)
     {
-        components.push_back(new CurrentSource(name, node1, node2, value));
+        insertComponent(new CurrentSource(name, node1, node2, value));
         cout << "Current Source " << name << " added.\n";
     }
 
     void addResistor(string& name, string& node1, string& node2, string& valueStr)
     {
-        for (const auto& c : components)
-            if (c->getName() == name)
-                throw DuplicateElementR(name);
+        if (hasComponent(name))
+            throw DuplicateElementR(name);
         if (name.empty() || name[0] != 'R')
             throw ElementNotFound(name);
 
@@ -452,7 +539,7 @@ public:
         ensureNodeExists(node1);
         ensureNodeExists(node2);
 
-        components.push_back(new Resistor(name, node1, node2, value));
+        insertComponent(new Resistor(name, node1, node2, value));
     }
 
     void deleteResistor(string& name)
@@ -461,8 +548,7 @@ public:
         {
             if (components[i]->getName() == name)
             {
-                delete components[i];
-                components.erase(components.begin() + i);
+                eraseComponent(i);
                 return;
             }
         }
@@ -474,9 +560,8 @@ public:
         if (name.empty() || name[0] != 'C')
             throw ElementNotFound(name);
 
-        for (const auto& c : components)
-            if (c->getName() == name)
-                throw DuplicateElementC(name);
+        if (hasComponent(name))
+            throw DuplicateElementC(name);
 
         double value = parseCapValue(valueStr);
         if (value <= 0)
@@ -485,7 +570,7 @@ public:
         ensureNodeExists(node1);
         ensureNodeExists(node2);
 
-        components.push_back(new Capacitor(name, node1, node2, value));
+        insertComponent(new Capacitor(name, node1, node2, value));
     }
 
     void deleteCapacitor(const string& name)
@@ -496,8 +581,7 @@ public:
             {
                 if (dynamic_cast<Capacitor*>(components[i]))
                 {
-                    delete components[i];
-                    components.erase(components.begin() + i);
+                    eraseComponent(i);
                     return;
                 }
             }
@@ -508,14 +592,13 @@ public:
     void addSineVoltage(const string& name, const string& node1, const string& node2, double offset, double amplitude, double frequency)
     {
 
-        for (const auto& c : components)
-            if (c->getName() == name)
-                throw DuplicateElementI(name);
+        if (hasComponent(name))
+            throw DuplicateElementI(name);
 
         ensureNodeExists(node1);
         ensureNodeExists(node2);
 
-        components.push_back(new SineVoltageSource(name, node1, node2, offset, amplitude, frequency));
+        insertComponent(new SineVoltageSource(name, node1, node2, offset, amplitude, frequency));
     }
 
     void addInductor(string& name, string& node1, string& node2, string& valueStr)
@@ -523,9 +606,8 @@ public:
         if (name.empty() || name[0] != 'L')
             throw runtime_error("Error: Element " + name + " not found in library");
 
-        for (const auto& c : components)
-            if (c->getName() == name)
-                throw DuplicateElementI(name);
+        if (hasComponent(name))
+            throw DuplicateElementI(name);
 
         double value = parseInductance(valueStr);
         if (value <= 0)
@@ -534,7 +616,7 @@ public:
         ensureNodeExists(node1);
         ensureNodeExists(node2);
 
-        components.push_back(new Inductor(name, node1, node2, value));
+        insertComponent(new Inductor(name, node1, node2, value));
     }
 
     void deleteInductor(const string& name)
@@ -545,8 +627,7 @@ public:
             {
                 if (dynamic_cast<Inductor*>(components[i]))
                 {
-                    delete components[i];
-                    components.erase(components.begin() + i);
+                    eraseComponent(i);
                     return;
                 }
             }
@@ -559,9 +640,8 @@ public:
         if (name.empty() || name[0] != 'D')
             throw ElementNotFound(name);
 
-        for (const auto& c : components)
-            if (c->getName() == name)
-                throw runtime_error("Error: diode " + name + " already exists in the circuit");
+        if (hasComponent(name))
+            throw runtime_error("Error: diode " + name + " already exists in the circuit");
 
         if (model != "D" && model != "Z")
             throw runtime_error("Error: Model " + model + " not found in library");
@@ -569,7 +649,7 @@ public:
         ensureNodeExists(node1);
         ensureNodeExists(node2);
 
-        components.push_back(new Diode(name, node1, node2, model));
+        insertComponent(new Diode(name, node1, node2, model));
     }
 
     void deleteDiode(const string& name)
@@ -580,8 +660,7 @@ public:
             {
                 if (dynamic_cast<Diode*>(components[i]))
                 {
-                    delete components[i];
-                    components.erase(components.begin() + i);
+                    eraseComponent(i);
                     return;
                 }
             }
@@ -591,14 +670,8 @@ public:
 
     Node* getOrCreateNode(const string& id)
     {
-        for (Node* node : nodes)
-        {
-            if (node->getID() == id)
-                return node;
-        }
-        Node* newNode = new Node(id);
-        nodes.push_back(newNode);
-        return newNode;
+        Node* node = findNode(id);
+        return node ? node : insertNode(id);
     }
 
     void addGround(const string& name)
@@ -609,14 +682,11 @@ public:
     }
     void deleteGround(const string& nodeName)
     {
-        for (Node* node : nodes)
+        if (Node* node = findNode(nodeName))
         {
-            if (node->getID() == nodeName)
-            {
-                node->setGrounded(false);
-                cout << "Ground removed from node " << nodeName << " successfully." << endl;
-                return;
-            }
+            node->setGrounded(false);
+            cout << "Ground removed from node " << nodeName << " successfully." << endl;
+            return;
         }
         throw runtime_error("Node does not exist");
     }
@@ -662,37 +732,25 @@ public:
         if (nodeExists(newName))
             throw runtime_error("ERROR: Node name " + newName + " already exists");
 
-        for (Node* node : nodes)
-        {
-            if (node->getID() == oldName)
-            {
-                node->setID(newName);
-                return;
-            }
-        }
+        Node* node = findNode(oldName);
+        node->setID(newName);
+        nodeByName[nameID(newName)] = node;
+        nodeByName[nameID(oldName)] = nullptr;
     }
 
 
     bool nodeExists(const string& name) const
     {
-        for (const Node* node : nodes)
-        {
-            if (node->getID() == name)
-                return true;
-        }
-        return false;
+        return findNode(name) != nullptr;
     }
 
     bool gndExists = false;
 
     void addNode(const string& nodeName)
     {
-        for (auto node : nodes)
-        {
-            if (node->getID() == nodeName)
-                return;
-        }
-        nodes.push_back(new Node(nodeName));
+        if (findNode(nodeName))
+            return;
+        insertNode(nodeName);
         if (nodeName == "GND")
             gndExists = true;
     }
@@ -734,7 +792,7 @@ public:
 
     void addComponent(Component* c)
     {
-        components.push_back(c);
+        insertComponent(c);
         cout << "[ADDED] " << c->getInfo() << endl;
     }
 
@@ -753,175 +811,341 @@ bool isValVertexID(const string& s)
     return true;
 }
 
-void handler(Circuit& circuit, string& input)
+// single pass command parser: the line is split once at blank runs and the command is picked by its first character
+// the rules below accept exactly what the old per line regexes accepted, in the same order
+
+bool isBlank(char c)
 {
-    smatch match;
-    regex sineVoltageRegex(R"(^add\s+VoltageSource\s+(\w+)\s+(\w+)\s+(\w+)\s+SIN\(\s*([+-]?\d*\.?\d+)\s+([+-]?\d*\.?\d+)\s+([+-]?\d*\.?\d+)\s*\)$)");
-    if (regex_match(input, match, sineVoltageRegex))
-    {
-        string name = match[1].str();
-        string node1 = match[2].str();
-        string node2 = match[3].str();
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
 
-        double offset = stod(match[4].str());
-        double amplitude = stod(match[5].str());
-        double frequency = stod(match[6].str());
+bool isWordChar(char c)
+{
+    return isalnum((unsigned char)c) || c == '_';
+}
 
-        circuit.addSineVoltage(name, node1, node2, offset, amplitude, frequency);
-        cout << "Sine voltage source " << name << " added successfully." << endl;
-        return;
-    }
-    regex voltageRegex(R"(^add\s+VoltageSource\s+(\w+)\s+(\w+)\s+(\w+)\s+([+-]?\d*\.?\d+(?:[eE][+-]?\d+)?))");
-    regex currentRegex(R"(^add\s+CurrentSource\s+(\w+)\s+(\w+)\s+(\w+)\s+([+-]?\d*\.?\d+(?:[eE][+-]?\d+)?))");
+bool isWord(string_view s)
+{
+    if (s.empty())
+        return false;
+    for (char c : s)
+        if (!isWordChar(c))
+            return false;
+    return true;
+}
 
-    if (regex_match(input, match, voltageRegex))
+bool isNodeName(string_view s)
+{
+    if (s.empty())
+        return false;
+    for (char c : s)
+        if (!isWordChar(c) && c != ':')
+            return false;
+    return true;
+}
+
+// a letter from first followed by at least one word character, like R1 or r_load
+bool isElementName(string_view s, string_view first)
+{
+    return s.size() > 1 && first.find(s[0]) != string_view::npos && isWord(s.substr(1));
+}
+
+// [+-]?\d*\.?\d+ with an optional [eE][+-]?\d+
+bool isDecimal(string_view s, bool exponent)
+{
+    size_t i = 0;
+    if (i < s.size() && (s[i] == '+' || s[i] == '-'))
+        i++;
+    size_t digits = 0;
+    while (i < s.size() && isdigit((unsigned char)s[i]))
+        i++, digits++;
+    if (i < s.size() && s[i] == '.')
     {
-        string name = match[1];
-        string n1 = match[2];
-        string n2 = match[3];
-        double value = stod(match[4]);
-        circuit.addVoltageSource(name, n1, n2, value);
-        return;
+        i++;
+        digits = 0;
+        while (i < s.size() && isdigit((unsigned char)s[i]))
+            i++, digits++;
     }
-    else if (regex_match(input, match, currentRegex))
+    if (digits == 0)
+        return false;
+    if (exponent && i < s.size() && (s[i] == 'e' || s[i] == 'E'))
     {
-        string name = match[1];
-        string n1 = match[2];
-        string n2 = match[3];
-        double value = stod(match[4]);
-        circuit.addCurrentSource(name, n1, n2, value);
-        return;
-    }
-    else if (input.find("add VoltageSource") == 0) {
-        cout << "ERROR: Invalid syntax - correct format:\nadd VoltageSource <Name> <Node1> <Node2> <Value>\n";
-    }
-    else if (input.find("add CurrentSource") == 0) {
-        cout << "ERROR: Invalid syntax - correct format:\nadd CurrentSource <Name> <Node1> <Node2> <Value>\n";
+        i++;
+        if (i < s.size() && (s[i] == '+' || s[i] == '-'))
+            i++;
+        size_t power = i;
+        while (i < s.size() && isdigit((unsigned char)s[i]))
+            i++;
+        if (i == power)
+            return false;
     }
-    regex addResRegex(R"(^add\s+([Rr][A-Za-z0-9_]+)\s+([A-Za-z0-9_:]+)\s+([A-Za-z0-9_:]+)\s+([0-9.eE+-]+[kK]?|[0-9.eE+-]+(Meg|M)?)$)");
-    if (regex_match(input, match, addResRegex))
+    return i == s.size();
+}
+
+// [0-9.eE+-]+ followed by one of the suffixes or nothing
+bool isValue(string_view s, initializer_list<string_view> suffixes)
+{
+    for (string_view suffix : suffixes)
     {
-        string name = match[1].str();
-        if (!isupper(name[0]))
-            throw ElementNotFound(name);
-        string node1 = match[2].str();
-        string node2 = match[3].str();
-        string value = match[4].str();
-        circuit.addResistor(name, node1, node2, value);
-        cout << "Resistor " << name << " added successfully.\n";
-        return;
+        if (s.size() > suffix.size() && s.substr(s.size() - suffix.size()) == suffix)
+        {
+            s.remove_suffix(suffix.size());
+            break;
+        }
     }
-    regex delResRegex(R"(^delete\s+([Rr][A-Za-z0-9_]+)$)");
-    if (regex_match(input, match, delResRegex))
+    if (s.empty())
+        return false;
+    for (char c : s)
+        if (!isdigit((unsigned char)c) && c != '.' && c != 'e' && c != 'E' && c != '+' && c != '-')
+            return false;
+    return true;
+}
+
+struct LineTokens
+{
+    static const int capacity = 8;
+    string_view token[capacity];
+    int count = 0;          // every token, also the ones past capacity
+    bool padded = false;    // leading or trailing blanks, no command allows them
+};
+
+LineTokens tokenize(string_view line)
+{
+    LineTokens t;
+    size_t i = 0;
+    t.padded = !line.empty() && (isBlank(line.front()) || isBlank(line.back()));
+    while (i < line.size())
     {
-        string name = match[1].str();
-        if (!isupper(name[0]))
-            throw ElementNotFound(name);
-        circuit.deleteResistor(name);
-        cout << "Resistor " << name << " deleted successfully." << endl;
-        return;
+        while (i < line.size() && isBlank(line[i]))
+            i++;
+        size_t begin = i;
+        while (i < line.size() && !isBlank(line[i]))
+            i++;
+        if (i > begin)
+        {
+            if (t.count < LineTokens::capacity)
+                t.token[t.count] = line.substr(begin, i - begin);
+            t.count++;
+        }
     }
-    regex addCapRegex(R"(^add\s+([Cc][A-Za-z0-9_]+)\s+([A-Za-z0-9_:]+)\s+([A-Za-z0-9_:]+)\s+([0-9.eE+-]+[uUnnFf]?)$)");
-    if (regex_match(input, match, addCapRegex))
+    return t;
+}
+
+// SIN(\s*<offset>\s+<amplitude>\s+<frequency>\s*)
+bool parseSineTail(string_view s, string_view value[3])
+{
+    if (s.substr(0, 4) != "SIN(")
+        return false;
+    size_t i = 4;
+    for (int k = 0; k < 3; k++)
     {
-        string name = match[1].str();
-        if (!isupper(name[0]))
-            throw ElementNotFound(name);
-        string node1 = match[2].str();
-        string node2 = match[3].str();
-        string value = match[4].str();
-        circuit.addCapacitor(name, node1, node2, value);
-        cout << "Capacitor " << name << " added successfully." << endl;
-        return;
+        size_t blanks = i;
+        while (i < s.size() && isBlank(s[i]))
+            i++;
+        if (k > 0 && i == blanks)
+            return false;
+        size_t begin = i;
+        while (i < s.size() && (isdigit((unsigned char)s[i]) || s[i] == '.' || s[i] == '+' || s[i] == '-'))
+            i++;
+        value[k] = s.substr(begin, i - begin);
+        if (!isDecimal(value[k], false))
+            return false;
     }
+    while (i < s.size() && isBlank(s[i]))
+        i++;
+    return i + 1 == s.size() && s[i] == ')';
+}
 
-    regex delCapRegex(R"(^delete\s+([Cc][A-Za-z0-9_]+)$)");
-    if (regex_match(input, match, delCapRegex))
+enum class CommandKind
+{
+    None, AddSineVoltage, AddVoltage, AddCurrent,
+    AddResistor, DeleteResistor, AddCapacitor, DeleteCapacitor, AddInductor, DeleteInductor, AddDiode, DeleteDiode,
+    AddGround, DeleteGround, ListNodes, List, RenameNode,
+    AddVCVS, AddVCCS, AddCCVS, AddCCCS, NewFile
+};
+
+struct Command
+{
+    CommandKind kind = CommandKind::None;
+    const char* usage = nullptr;    // printed before the command runs
+    string_view field[6];
+    int fields = 0;
+};
+
+Command parseCommand(string_view line)
+{
+    Command cmd;
+    if (line.empty())
+        return cmd;
+    LineTokens t = tokenize(line);
+    const string_view* tok = t.token;
+    int n = t.count;
+    bool clean = !t.padded;
+    auto take = [&](CommandKind kind, initializer_list<string_view> fields) {
+        cmd.kind = kind;
+        cmd.fields = 0;
+        for (string_view f : fields)
+            cmd.field[cmd.fields++] = f;
+        return cmd;
+    };
+
+    switch (line[0])
     {
-        string name = match[1].str();
-        if (!isupper(name[0]))
-            throw ElementNotFound(name);
-        circuit.deleteCapacitor(name);
-        cout << "Capacitor " << name << " deleted successfully." << endl;
-        return;
-    }
-    regex addIndRegex(R"(^add\s+([Ll][A-Za-z0-9_]+)\s+([A-Za-z0-9_:]+)\s+([A-Za-z0-9_:]+)\s+([0-9.eE+-]+(u|U|µ|m|M|H)?)$)");
-    if (regex_match(input, match, addIndRegex))
+    case 'a':
+        if (!clean || tok[0] != "add")
+            break;
+        if (n >= 6 && tok[1] == "VoltageSource" && isWord(tok[2]) && isWord(tok[3]) && isWord(tok[4]))
+        {
+            string_view sine[3];
+            if (parseSineTail(line.substr(tok[5].data() - line.data()), sine))
+                return take(CommandKind::AddSineVoltage, {tok[2], tok[3], tok[4], sine[0], sine[1], sine[2]});
+        }
+        if (n == 6 && (tok[1] == "VoltageSource" || tok[1] == "CurrentSource") && isWord(tok[2]) && isWord(tok[3]) && isWord(tok[4]) && isDecimal(tok[5], true))
+            return take(tok[1][0] == 'V' ? CommandKind::AddVoltage : CommandKind::AddCurrent, {tok[2], tok[3], tok[4], tok[5]});
+        break;
+    case 'd':
+        if (!clean || tok[0] != "delete")
+            break;
+        if (n == 2 && isElementName(tok[1], "Rr"))
+            return take(CommandKind::DeleteResistor, {tok[1]});
+        if (n == 2 && isElementName(tok[1], "Cc"))
+            return take(CommandKind::DeleteCapacitor, {tok[1]});
+        if (n == 2 && isElementName(tok[1], "Ll"))
+            return take(CommandKind::DeleteInductor, {tok[1]});
+        if (n == 2 && isElementName(tok[1], "D"))
+            return take(CommandKind::DeleteDiode, {tok[1]});
+        if (n == 3 && isWord(tok[1]) && isWord(tok[2]))
+            return take(CommandKind::DeleteGround, {tok[1], tok[2]});
+        return cmd;
+    case '.':
+        if (line == ".nodes")
+            return take(CommandKind::ListNodes, {});
+        if (clean && tok[0] == ".list" && (n == 1 || (n == 2 && isWord(tok[1]))))
+            return take(CommandKind::List, {n == 2 ? tok[1] : string_view()});
+        if (clean && n == 4 && tok[0] == ".rename" && tok[1] == "node" && isWord(tok[2]) && isWord(tok[3]))
+            return take(CommandKind::RenameNode, {tok[2], tok[3]});
+        return cmd;
+    case 'N':
+        if (line.substr(0, 8) == "NewFile ")
+            return take(CommandKind::NewFile, {line.substr(8)});
+        return cmd;
+    default:
+        return cmd;
+    }
+
+    // a broken source line reports its syntax and still goes through the element rules
+    if (line.substr(0, 17) == "add VoltageSource")
+        cmd.usage = "ERROR: Invalid syntax - correct format:\nadd VoltageSource <Name> <Node1> <Node2> <Value>\n";
+    else if (line.substr(0, 17) == "add CurrentSource")
+        cmd.usage = "ERROR: Invalid syntax - correct format:\nadd CurrentSource <Name> <Node1> <Node2> <Value>\n";
+    if (!clean || tok[0] != "add")
+        return cmd;
+    if (n == 5 && isNodeName(tok[2]) && isNodeName(tok[3]))
     {
-        string name = match[1].str();
-        if (!isupper(name[0]))
-            throw ElementNotFound(name);
-        string node1 = match[2].str();
-        string node2 = match[3].str();
-        string value = match[4].str();
-        circuit.addInductor(name, node1, node2, value);
-        cout << "Inductor " << name << " added successfully." << endl;
-        return;
-    }
-    regex delIndRegex(R"(^delete\s+([Ll][A-Za-z0-9_]+)$)");
-    if (regex_match(input, match, delIndRegex))
+        if (isElementName(tok[1], "Rr") && isValue(tok[4], {"Meg", "M", "k", "K"}))
+            return take(CommandKind::AddResistor, {tok[1], tok[2], tok[3], tok[4]});
+        if (isElementName(tok[1], "Cc") && isValue(tok[4], {"u", "U", "n", "F", "f"}))
+            return take(CommandKind::AddCapacitor, {tok[1], tok[2], tok[3], tok[4]});
+        if (isElementName(tok[1], "Ll") && isValue(tok[4], {"u", "U", "\xC2\xB5", "m", "M", "H"}))
+            return take(CommandKind::AddInductor, {tok[1], tok[2], tok[3], tok[4]});
+        if (isElementName(tok[1], "Dd") && isWord(tok[4]))
+            return take(CommandKind::AddDiode, {tok[1], tok[2], tok[3], tok[4]});
+    }
+    if (n == 3 && isWord(tok[1]) && isWord(tok[2]))
+        return take(CommandKind::AddGround, {tok[1], tok[2]});
+    if (n == 7 && isElementName(tok[1], "EG") && isWord(tok[2]) && isWord(tok[3]) && isWord(tok[4]) && isWord(tok[5]) && isDecimal(tok[6], false))
+        return take(tok[1][0] == 'E' ? CommandKind::AddVCVS : CommandKind::AddVCCS, {tok[1].substr(1), tok[2], tok[3], tok[4], tok[5], tok[6]});
+    if (n == 6 && isElementName(tok[1], "HF") && isWord(tok[2]) && isWord(tok[3]) && isWord(tok[4]) && isDecimal(tok[5], false))
+        return take(tok[1][0] == 'H' ? CommandKind::AddCCVS : CommandKind::AddCCCS, {tok[1].substr(1), tok[2], tok[3], tok[4], tok[5]});
+    return cmd;
+}
+
+void handler(Circuit& circuit, string& input)
+{
+    Command cmd = parseCommand(input);
+    if (cmd.usage)
+        cout << cmd.usage;
+    string f[6];
+    for (int i = 0; i < cmd.fields; i++)
+        f[i] = string(cmd.field[i]);
+
+    switch (cmd.kind)
     {
-        string name = match[1].str();
-        if (!isupper(name[0]))
-            throw ElementNotFound(name);
-        circuit.deleteInductor(name);
-        cout << "Inductor " << name << " deleted successfully." << endl;
-        return;
-    }
-    regex addDiodeRegex(R"(^add\s+([Dd][A-Za-z0-9_]+)\s+([A-Za-z0-9_:]+)\s+([A-Za-z0-9_:]+)\s+([A-Za-z0-9_]+)$)");
-    if (regex_match(input, match, addDiodeRegex))
+    case CommandKind::AddSineVoltage:
     {
-        string name = match[1].str();
-        string node1 = match[2].str();
-        string node2 = match[3].str();
-        string model = match[4].str();
-        if (!isupper(name[0]))
-            throw ElementNotFound(name);
-        if (model != "D" && model != "Z")
-            throw runtime_error("Error: Model " + model + " not found in library");
-        circuit.addDiode(name, node1, node2, model);
-        cout << "Diode " << name << " added successfully.\n";
+        double offset = toDouble(f[3]);
+        double amplitude = toDouble(f[4]);
+        double frequency = toDouble(f[5]);
+        circuit.addSineVoltage(f[0], f[1], f[2], offset, amplitude, frequency);
+        cout << "Sine voltage source " << f[0] << " added successfully." << endl;
         return;
     }
-    regex delDiodeRegex(R"(^delete\s+(D[A-Za-z0-9_]+)$)");
-    if (regex_match(input, match, delDiodeRegex))
-    {
-        string name = match[1].str();
-        if (!isupper(name[0]))
-            throw ElementNotFound(name);
-        circuit.deleteDiode(name);
-        cout << "Diode " << name << " deleted successfully." << endl;
+    case CommandKind::AddVoltage:
+        circuit.addVoltageSource(f[0], f[1], f[2], toDouble(f[3]));
         return;
-    }
-    regex addGNDRegex(R"(^add\s+([A-Za-z0-9_]+)\s+([A-Za-z0-9_]+)$)");
-    if (regex_match(input, match, addGNDRegex))
-    {
-        string elementType = match[1].str();
-        string node = match[2].str();
-        if (elementType != "GND")
-        {
-            throw runtime_error("Error: Element " + elementType + " not found in library");
-        }
-        if (!isValVertexID(node))
-            throw SyntaxError("Error: Syntax error");
-        circuit.addGround(node);
+    case CommandKind::AddCurrent:
+        circuit.addCurrentSource(f[0], f[1], f[2], toDouble(f[3]));
         return;
-    }
-    regex delGNDRegex(R"(^delete\s+([A-Za-z0-9_]+)\s+([A-Za-z0-9_]+)$)");
-    if (regex_match(input, match, delGNDRegex))
-    {
-        string elementType = match[1].str();
-        string node = match[2].str();
-        if (elementType != "GND")
-        {
-            throw runtime_error("Error: Element " + elementType + " not found in library");
-        }
-        if (!isValVertexID(node))
+    case CommandKind::AddResistor:
+        if (!isupper(f[0][0]))
+            throw ElementNotFound(f[0]);
+        circuit.addResistor(f[0], f[1], f[2], f[3]);
+        cout << "Resistor " << f[0] << " added successfully.\n";
+        return;
+    case CommandKind::DeleteResistor:
+        if (!isupper(f[0][0]))
+            throw ElementNotFound(f[0]);
+        circuit.deleteResistor(f[0]);
+        cout << "Resistor " << f[0] << " deleted successfully." << endl;
+        return;
+    case CommandKind::AddCapacitor:
+        if (!isupper(f[0][0]))
+            throw ElementNotFound(f[0]);
+        circuit.addCapacitor(f[0], f[1], f[2], f[3]);
+        cout << "Capacitor " << f[0] << " added successfully." << endl;
+        return;
+    case CommandKind::DeleteCapacitor:
+        if (!isupper(f[0][0]))
+            throw ElementNotFound(f[0]);
+        circuit.deleteCapacitor(f[0]);
+        cout << "Capacitor " << f[0] << " deleted successfully." << endl;
+        return;
+    case CommandKind::AddInductor:
+        if (!isupper(f[0][0]))
+            throw ElementNotFound(f[0]);
+        circuit.addInductor(f[0], f[1], f[2], f[3]);
+        cout << "Inductor " << f[0] << " added successfully." << endl;
+        return;
+    case CommandKind::DeleteInductor:
+        if (!isupper(f[0][0]))
+            throw ElementNotFound(f[0]);
+        circuit.deleteInductor(f[0]);
+        cout << "Inductor " << f[0] << " deleted successfully." << endl;
+        return;
+    case CommandKind::AddDiode:
+        if (!isupper(f[0][0]))
+            throw ElementNotFound(f[0]);
+        if (f[3] != "D" && f[3] != "Z")
+            throw runtime_error("Error: Model " + f[3] + " not found in library");
+        circuit.addDiode(f[0], f[1], f[2], f[3]);
+        cout << "Diode " << f[0] << " added successfully.\n";
+        return;
+    case CommandKind::DeleteDiode:
+        circuit.deleteDiode(f[0]);
+        cout << "Diode " << f[0] << " deleted successfully." << endl;
+        return;
+    case CommandKind::AddGround:
+    case CommandKind::DeleteGround:
+        if (f[0] != "GND")
+            throw runtime_error("Error: Element " + f[0] + " not found in library");
+        if (!isValVertexID(f[1]))
             throw SyntaxError("Error: Syntax error");
-        circuit.deleteGround(node);
+        if (cmd.kind == CommandKind::AddGround)
+            circuit.addGround(f[1]);
+        else
+            circuit.deleteGround(f[1]);
         return;
-    }
-    if (input == ".nodes")
+    case CommandKind::ListNodes:
     {
         vector<string> nodeList = circuit.getAllNodeNames();
         if (circuit.hasGND() && find(nodeList.begin(), nodeList.end(), "GND") == nodeList.end())
@@ -946,74 +1170,40 @@ void handler(Circuit& circuit, string& input)
         }
         return;
     }
-
-    regex listRegex(R"(^\.list(?:\s+([A-Za-z0-9_]+))?$)");
-    if (regex_match(input, match, listRegex))
-    {
-        if (match[1].matched)
-        {
-            string type = match[1].str();
-            circuit.printComponentsOfType(type);
-        }
+    case CommandKind::List:
+        if (!f[0].empty())
+            circuit.printComponentsOfType(f[0]);
         else
-        {
             circuit.printAllComponents();
-        }
         return;
-    }
-    regex renameNodeRegex(R"(^\.rename\s+node\s+([A-Za-z0-9_]+)\s+([A-Za-z0-9_]+)$)");
-    if (regex_match(input, match, renameNodeRegex))
-    {
-        string oldName = match[1].str();
-        string newName = match[2].str();
-        if (!isValVertexID(oldName) || !isValVertexID(newName))
+    case CommandKind::RenameNode:
+        if (!isValVertexID(f[0]) || !isValVertexID(f[1]))
             throw SyntaxError("ERROR: Invalid syntax - correct format:\n.rename node <old_name> <new_name>");
         try
         {
-            circuit.renameNode(oldName, newName);
-            cout << "SUCCESS: Node renamed from " << oldName << " to " << newName << endl;
+            circuit.renameNode(f[0], f[1]);
+            cout << "SUCCESS: Node renamed from " << f[0] << " to " << f[1] << endl;
         }
         catch (const runtime_error& e)
         {
             cerr << e.what() << endl;
         }
         return;
-    }
-    regex vcvsRegex(R"(^add\s+E([A-Za-z0-9_]+)\s+(\w+)\s+(\w+)\s+(\w+)\s+(\w+)\s+([+-]?\d*\.?\d+)$)");
-    if (regex_match(input, match, vcvsRegex)) {
-        string id = match[1], n1 = match[2], n2 = match[3], c1 = match[4], c2 = match[5];
-        double gain = stod(match[6]);
-        circuit.addComponent(new VCVS(id, n1, n2, c1, c2, gain));
+    case CommandKind::AddVCVS:
+        circuit.addComponent(new VCVS(f[0], f[1], f[2], f[3], f[4], toDouble(f[5])));
         return;
-    }
-
-
-    regex vccsRegex(R"(^add\s+G([A-Za-z0-9_]+)\s+(\w+)\s+(\w+)\s+(\w+)\s+(\w+)\s+([+-]?\d*\.?\d+)$)");
-    if (regex_match(input, match, vccsRegex)) {
-        string id = match[1], n1 = match[2], n2 = match[3], c1 = match[4], c2 = match[5];
-        double gain = stod(match[6]);
-        circuit.addComponent(new VCCS(id, n1, n2, c1, c2, gain));
+    case CommandKind::AddVCCS:
+        circuit.addComponent(new VCCS(f[0], f[1], f[2], f[3], f[4], toDouble(f[5])));
         return;
-    }
-
-    regex ccvsRegex(R"(^add\s+H([A-Za-z0-9_]+)\s+(\w+)\s+(\w+)\s+(\w+)\s+([+-]?\d*\.?\d+)$)");
-    if (regex_match(input, match, ccvsRegex)) {
-        string id = match[1], n1 = match[2], n2 = match[3], vname = match[4];
-        double gain = stod(match[5]);
-        circuit.addComponent(new CCVS(id, n1, n2, vname, gain));
+    case CommandKind::AddCCVS:
+        circuit.addComponent(new CCVS(f[0], f[1], f[2], f[3], toDouble(f[4])));
         return;
-    }
-
-    regex cccsRegex(R"(^add\s+F([A-Za-z0-9_]+)\s+(\w+)\s+(\w+)\s+(\w+)\s+([+-]?\d*\.?\d+)$)");
-    if (regex_match(input, match, cccsRegex)) {
-        string id = match[1], n1 = match[2], n2 = match[3], vname = match[4];
-        double gain = stod(match[5]);
-        circuit.addComponent(new CCCS(id, n1, n2, vname, gain));
+    case CommandKind::AddCCCS:
+        circuit.addComponent(new CCCS(f[0], f[1], f[2], f[3], toDouble(f[4])));
         return;
-    }
-    else if (input.substr(0, 8) == "NewFile ")
+    case CommandKind::NewFile:
     {
-        string path = input.substr(8);
+        string path = f[0];
         path.erase(0, path.find_first_not_of(" \t\n\r"));
         path.erase(path.find_last_not_of(" \t\n\r") + 1);
 
@@ -1026,6 +1216,9 @@ void handler(Circuit& circuit, string& input)
         }
         return;
     }
+    case CommandKind::None:
+        break;
+    }
 
     throw SyntaxError();
 }
@@ -1069,13 +1262,10 @@ bool isNumber(const string& s) {
 }
 
 string convertToCommand(const string& line) {
-    istringstream iss(line);
-    string first;
-    iss >> first;
-
-    if (first.empty()) return line;
+    size_t first = line.find_first_not_of(" \t\n\v\f\r");
+    if (first == string::npos) return line;
 
-    char c = toupper(first[0]);
+    char c = toupper(line[first]);
     if (c == 'R' || c == 'C' || c == 'L' || c == 'V' || c == 'I' || c == 'D') {
         return "add " + line;
     }
@@ -1274,8 +1464,63 @@ void showExistingSchematics() {
     }
 }
 
-int main()
+// parser and handler throughput on a generated netlist, in lines per second
+void runBenchmark(int lines)
 {
+    vector<string> netlist;
+    netlist.reserve(lines);
+    for (int i = 0; (int)netlist.size() < lines; i++)
+    {
+        string a = "n" + to_string(i % 1000), b = "n" + to_string((i + 1) % 1000), k = to_string(i);
+        switch (i % 10)
+        {
+        case 0: netlist.push_back("add R" + k + " " + a + " " + b + " 1.5k"); break;
+        case 1: netlist.push_back("add C" + k + " " + a + " " + b + " 10u"); break;
+        case 2: netlist.push_back("add L" + k + " " + a + " " + b + " 2.2m"); break;
+        case 3: netlist.push_back("add D" + k + " " + a + " " + b + " D"); break;
+        case 4: netlist.push_back("add VoltageSource V" + k + " " + a + " " + b + " 5"); break;
+        case 5: netlist.push_back("add VoltageSource S" + k + " " + a + " " + b + " SIN(0 1 50)"); break;
+        case 6: netlist.push_back("add CurrentSource I" + k + " " + a + " " + b + " 1e-3"); break;
+        case 7: netlist.push_back("add E" + k + " " + a + " " + b + " " + b + " " + a + " 2"); break;
+        case 8: netlist.push_back("add H" + k + " " + a + " " + b + " V" + to_string(i - 4) + " 0.5"); break;
+        case 9: netlist.push_back("add GND " + a); break;
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    size_t matched = 0;
+    for (const string& line : netlist)
+        matched += parseCommand(line).kind != CommandKind::None;
+    double parseSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // the whole netlist goes into one circuit, name lookups do not grow with it
+    streambuf* out = cout.rdbuf(nullptr);
+    start = chrono::steady_clock::now();
+    {
+        Circuit circuit;
+        for (const string& text : netlist)
+        {
+            string line = text;
+            handler(circuit, line);
+        }
+    }
+    double handlerSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout.rdbuf(out);
+    cout.clear();
+
+    cout << lines << " lines, " << matched << " parsed\n";
+    cout << "parseCommand: " << lines / parseSeconds << " lines/s\n";
+    cout << "handler:      " << lines / handlerSeconds << " lines/s" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && string(argv[1]) == "--benchmark")
+    {
+        runBenchmark(argc > 2 ? stoi(argv[2]) : 100000);
+        return 0;
+    }
+
     vector<bool> circuitValidity;
     Circuit currentCircuit;
     string line;
@@ -0,0 +1,240 @@
+//l2spice_batch: runs a netlist without the gui, for regression scripts
+//
+//  l2spice_batch netlist [-o output] [-j threads] [-v] [.op] [.tran step stop] [.dc source start stop step]
+//
+//directives on the command line replace the ones in the netlist, .op runs when there are none
+//the output (netlist.bin by default) is host endian:
+//  char[8] "L2SPICE1", uint32 datasets
+//  every dataset: uint32 analysis (0 op, 1 tran, 2 dc), uint32 variables, uint32 points,
+//  variables names as uint32 length + utf-8 ("time", the swept source or "op" first, then V(node) and I(source)),
+//  points x variables doubles, one point after another
+#include <QDebug>
+#include <QString>
+#include <QVector>
+#include <QElapsedTimer>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <cctype>
+#include <string>
+#include <vector>
+#include "circuit.h"
+#include "netlist.h"
+#include "voltage_source.h"
+
+enum batch_exit{
+    exit_ok = 0,
+    exit_usage,
+    exit_netlist,//unreadable file or a bad card
+    exit_circuit,//no ground, nothing to simulate, a dangling control or structurally singular
+    exit_analysis,//an analysis did not converge, the datasets before it are written
+    exit_output,
+};
+struct dataset{
+    int analysis;
+    std::vector<std::string> names;
+    std::vector<double> values;
+};
+
+static bool verbose = false;
+static void message_handler(QtMsgType type,const QMessageLogContext &,const QString &msg)
+{
+    if(verbose || type==QtFatalMsg)
+        std::fprintf(stderr,"%s\n",msg.toStdString().c_str());
+}
+static int usage()
+{
+    std::fprintf(stderr,"usage: l2spice_batch netlist [-o output] [-j threads] [-v] [.op] [.tran step stop] [.dc source start stop step]\n");
+    return exit_usage;
+}
+//.op, .tran or .dc in any case, lower cased, empty for anything else such as ./rc.cir
+static std::string directive_name(const std::string &arg)
+{
+    std::string name;
+    for(char c:arg)
+        name += std::tolower((unsigned char)c);
+    return name==".op" || name==".tran" || name==".dc" ? name : std::string();
+}
+static void put_u32(std::FILE* f,uint32_t v)
+{
+    std::fwrite(&v,sizeof(v),1,f);
+}
+static bool write_output(const std::string &path,const std::vector<dataset> &sets)
+{
+    std::FILE* f = std::fopen(path.c_str(),"wb");
+    if(!f)
+        return false;
+    std::fwrite("L2SPICE1",1,8,f);
+    put_u32(f,sets.size());
+    for(auto &s:sets){
+        put_u32(f,s.analysis);
+        put_u32(f,s.names.size());
+        put_u32(f,s.values.size()/s.names.size());
+        for(auto &n:s.names){
+            put_u32(f,n.size());
+            std::fwrite(n.data(),1,n.size(),f);
+        }
+        std::fwrite(s.values.data(),sizeof(double),s.values.size(),f);
+    }
+    bool ok = !std::ferror(f);
+    return std::fclose(f)==0 && ok;
+}
+
+int main(int argc,char *argv[])
+{
+    //no QCoreApplication: nothing here needs an event loop and startup stays in the millisecond range
+    QElapsedTimer clock;
+    clock.start();
+    qInstallMessageHandler(message_handler);
+    std::string netlist_path;
+    std::string output_path;
+    int threads = 1;
+    QVector<netlist_directive> directives;
+    for(int i=1;i<argc;i++){
+        std::string arg = argv[i];
+        std::string name = directive_name(arg);
+        if(arg=="-v"){
+            verbose = true;
+        }else if(arg=="-o" && i+1<argc){
+            output_path = argv[++i];
+        }else if(arg=="-j" && i+1<argc){
+            threads = std::atoi(argv[++i]);
+        }else if(!name.empty()){
+            int operands = name==".tran" ? 2 : name==".dc" ? 4 : 0;
+            if(i+operands>=argc)
+                return usage();
+            std::vector<std::string> tokens(argv+i,argv+i+operands+1);
+            i += operands;
+            netlist_directive d;
+            QString error;
+            if(!Netlist::parse_directive(tokens,d,error)){
+                std::fprintf(stderr,"%s\n",error.toStdString().c_str());
+                return exit_usage;
+            }
+            directives.push_back(d);
+        }else if(arg[0]!='-' && netlist_path.empty()){
+            netlist_path = arg;
+        }else{
+            return usage();
+        }
+    }
+    if(netlist_path.empty())
+        return usage();
+    if(output_path.empty()){
+        //only an extension of the file name itself, runs.v2/net gives runs.v2/net.bin
+        size_t slash = netlist_path.find_last_of("/\\");
+        size_t dot = netlist_path.rfind('.');
+        if(dot==std::string::npos || (slash!=std::string::npos && dot<slash))
+            dot = netlist_path.size();
+        output_path = netlist_path.substr(0,dot)+".bin";
+    }
+
+    Circuit circuit;
+    circuit.set_assembly_threads(threads);
+    Netlist netlist;
+    if(!netlist.read_file(QString::fromStdString(netlist_path),circuit)){
+        std::fprintf(stderr,"%s: %s\n",netlist_path.c_str(),netlist.get_error().toStdString().c_str());
+        return exit_netlist;
+    }
+    switch(circuit.get_circuit_state()){
+        case ok:
+            break;
+        case no_component:
+            std::fprintf(stderr,"%s: no elements\n",netlist_path.c_str());
+            return exit_circuit;
+        case no_ground:
+            std::fprintf(stderr,"%s: no element is connected to ground\n",netlist_path.c_str());
+            return exit_circuit;
+        case unresolved_control:
+            std::fprintf(stderr,"%s: controlled source refers to %s, which is not in the circuit\n",netlist_path.c_str(),circuit.get_unresolved_control().toStdString().c_str());
+            return exit_circuit;
+        default:{
+            const structure_report &r = circuit.get_structure_report();
+            const QVector<QString> &node_names = netlist.get_node_names();
+            if(r.rank<r.unknowns){
+                std::string where;
+                for(int n:r.nodes)
+                    where += " "+node_names[n].toStdString();
+                for(auto &c:r.components)
+                    where += " "+c.toStdString();
+                std::fprintf(stderr,"%s: structurally singular (rank %d of %d):%s\n",netlist_path.c_str(),r.rank,r.unknowns,where.c_str());
+            }
+            if(!r.floating_nodes.isEmpty()){
+                std::string where;
+                for(int n:r.floating_nodes)
+                    where += " "+node_names[n].toStdString();
+                std::fprintf(stderr,"%s: no path to ground:%s\n",netlist_path.c_str(),where.c_str());
+            }
+            return exit_circuit;
+        }
+    }
+    if(directives.isEmpty())
+        directives = netlist.get_directives();
+    if(directives.isEmpty())
+        directives.push_back(netlist_directive());
+
+    //unknowns are the node voltages, then the voltage source currents in netlist order
+    const QVector<QString> &node_names = netlist.get_node_names();
+    std::vector<std::string> names(1);
+    std::vector<int> rows;
+    for(int i=1;i<node_names.size();i++){
+        names.push_back("V("+node_names[i].toStdString()+")");
+        rows.push_back(i-1);
+    }
+    for(auto c:circuit.getAllComponent()){
+        voltage_source* vs = dynamic_cast<voltage_source*>(c);
+        if(!vs)
+            continue;
+        names.push_back("I("+vs->getname().toStdString()+")");
+        rows.push_back(node_names.size()-1+vs->get_num());
+    }
+    auto record = [&](dataset &s,double scale,const Matrix &x){
+        s.values.push_back(scale);
+        for(int r:rows)
+            s.values.push_back(x(r,0));
+    };
+
+    std::vector<dataset> sets;
+    int status = exit_ok;
+    for(auto &d:directives){
+        dataset s;
+        s.analysis = d.analysis;
+        s.names = names;
+        bool done = false;
+        if(d.analysis==netlist_op){
+            s.names[0] = "op";
+            Matrix x = circuit.dc_analysis();
+            done = circuit.get_dc_report().stage!=dc_failed;
+            if(done)
+                record(s,0,x);
+        }else if(d.analysis==netlist_tran){
+            s.names[0] = "time";
+            circuit.analysis(d.stop,d.step);
+            const QVector< QPair<Matrix,double> > &solutions = circuit.get_solutions();
+            done = circuit.get_dc_report().stage!=dc_failed && !solutions.isEmpty() && solutions.back().second>=d.stop*(1-1e-9);
+            for(int i=0;done && i<solutions.size();i++)
+                record(s,solutions[i].second,solutions[i].first);
+        }else{
+            s.names[0] = d.source.toStdString();
+            int points = std::lround((d.stop-d.start)/d.step)+1;
+            done = points>=2 && circuit.dc_sweep(d.source,d.start,d.start+(points-1)*d.step,points);
+            const QVector< QPair<Matrix,double> > &sweep = circuit.get_dc_sweep();
+            for(int i=0;done && i<sweep.size();i++)
+                record(s,sweep[i].second,sweep[i].first);
+        }
+        if(!done){
+            static const char* analysis_names[] = {".op",".tran",".dc"};
+            std::fprintf(stderr,"%s: %s failed\n",netlist_path.c_str(),analysis_names[d.analysis]);
+            status = exit_analysis;
+            break;
+        }
+        sets.push_back(s);
+    }
+    if(!write_output(output_path,sets)){
+        std::fprintf(stderr,"cannot write %s\n",output_path.c_str());
+        return exit_output;
+    }
+    if(verbose)
+        std::fprintf(stderr,"%d datasets in %s, %.3f ms\n",(int)sets.size(),output_path.c_str(),clock.nsecsElapsed()/1e6);
+    return status;
+}
@@ -5,7 +5,7 @@ Capacitor::Capacitor()
 
 }
 
-Capacitor::Capacitor(const QString &s,QRect &r,QGraphicsScene *sc):RLCComponent(s,r,sc)
+Capacitor::Capacitor(ComponentView *view,QRect &r):RLCComponent(view,r)
 {
     bool find = false;
     for(int i=0;i<num_list.size();i++){
@@ -23,8 +23,6 @@ Capacitor::Capacitor(const QString &s,QRect &r,QGraphicsScene *sc):RLCComponent(
 
     setName(QString("C")+QString::number(num+1));
     image->setCharacteristic(QString("C"));
-    capacitordialog = new Capacitordialog();
-    capacitordialog->setModal(true);
 }
 void Capacitor::Delete()
 {
@@ -34,12 +32,25 @@ double Capacitor::get_capacitance()
 {
     return capacitance;
 }
-void Capacitor::InputValue()
+void Capacitor::set_capacitance(double value)
 {
-    capacitordialog->exec();
-    capacitance = unit_transformer::transform(capacitordialog->getInput());
-    image->setCharacteristic(capacitordialog->getInput());
-    image->setInput(false);
+    capacitance = value;
+}
+Capacitor* Capacitor::solver_copy()const
+{
+    Capacitor* c = new Capacitor();
+    c->setName(getname());
+    c->capacitance = capacitance;
+    c->num = num;
+    for(int i=0;i<nodes.size();i++)
+        c->nodes[i]->setNodeIndex(nodes[i]->getNodeIndex());
+    return c;
+}
+void Capacitor::setInputValue(const QString &input)
+{
+    capacitance = unit_transformer::transform(input);
+    if(image)
+        image->setCharacteristic(input);
     qDebug() << capacitance;
 }
 bool Capacitor::isDependant()
@@ -48,6 +59,5 @@ bool Capacitor::isDependant()
 }
 Capacitor::~Capacitor()
 {
-    delete capacitordialog;
 }
 QVector<bool> Capacitor::num_list;
@@ -2,21 +2,21 @@
 #define CAPACITOR_H
 
 #include "rlccomponent.h"
-#include "Capacitordialog.h"
 class Capacitor:public RLCComponent
 {
     private:
         double capacitance;
         int num;
         static QVector<bool> num_list; //1 for exist 0 for not
-        Capacitordialog *capacitordialog;
     public:
         Capacitor();
-        Capacitor(const QString &s,QRect &r,QGraphicsScene *sc);
+        Capacitor(ComponentView *view,QRect &r);
         void Delete();
-        void InputValue();
+        void setInputValue(const QString &input);//value as typed, unit suffixes allowed
         bool isDependant();
         double get_capacitance();
+        void set_capacitance(double value);
+        Capacitor* solver_copy()const;//value and node indices only, for runs on another thread
         ~Capacitor();
 };
 
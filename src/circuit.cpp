@@ -1,10 +1,36 @@
 #include "circuit.h"
+#include "fast_exp.h"
 #include <QStack>
 #include <QList>
+static const long long kept_jacobian_limit = 1<<24;//doubles of forward factors a sensitivity run may keep, 128 MB
 Circuit::Circuit()
 {
     nowSelectedItem.clear();
     state = idle;
+    newton = full_newton;
+    chord_contraction = 0.5;
+    newton_accuracy = 1e-1;
+    jacobian_timestep = 0;
+    keep_jacobians = false;
+    schur_reduction = false;
+    dc_stage_budget = 2000;
+    predictor_order = 2;
+    device_bypass = true;
+    bypass_tolerance = 1e-6;
+    //no pool until asked for: the gui circuit and every solver copy run serially
+    pool = nullptr;
+    assembly_threads = 1;
+    exponential_stepping = false;
+    structured_solver = true;
+    shared_structure = nullptr;
+    equilibration = true;
+    refinement_steps = 0;
+    owns_components = true;
+    component_index_stale = true;
+    relaxation_resistance = 1e5;
+    relaxation_mode = gauss_seidel_sweep;
+    reduction_moments = 0;
+    reduction_max_size = -1;
 }
 
 QVector<Component *> Circuit::getAllComponent()
@@ -20,7 +46,7 @@ QVector<Ground* > Circuit::getAllground()
 {
     return allGround;
 }
-QVector<LineNodeitem *> Circuit::getAllLine()
+QVector<NodeLine *> Circuit::getAllLine()
 {
     return allLine;
 }
@@ -36,6 +62,7 @@ void Circuit::updatedelete()
             delete allComponent[i];
             allComponent.erase(allComponent.begin()+i);
             i--;
+            component_index_stale = true;
         }
     }
     for(int i=0;i<allGround.size();i++){
@@ -53,15 +80,6 @@ void Circuit::updatedelete()
         }
     }
 }
-void Circuit::Input()
-{
-    for(int i=0;i<allComponent.size();i++){
-        if(allComponent[i]->getInput()){
-            allComponent[i]->InputValue();
-
-        }
-    }
-}
 void Circuit::find_initial_condition()
 {
     initial_condition.clear();
@@ -112,7 +130,7 @@ void Circuit::analysis_circuit_connection()
                 }
         }
 
-        QStack<LineNodeitem*> line_stack;
+        QStack<NodeLine*> line_stack;
 
         for(int i=0;i<allLine.size();i++){
             if(allLine[i]->on_the_line(*current_ground)&&allLine[i]->getNodeindex()==-1){
@@ -121,10 +139,10 @@ void Circuit::analysis_circuit_connection()
             }
         }
 
-        QList<LineNodeitem*> working_line;
+        QList<NodeLine*> working_line;
 
         while(line_stack.size()){
-            LineNodeitem* current_line = line_stack.top();
+            NodeLine* current_line = line_stack.top();
             line_stack.pop();
             if(!working_line.contains(current_line))
                 working_line.append(current_line);
@@ -180,7 +198,7 @@ void Circuit::analysis_circuit_connection()
                 }
         }
 
-        QStack<LineNodeitem*> line_stack;
+        QStack<NodeLine*> line_stack;
 
         for(int i=0;i<allLine.size();i++){
             if(allLine[i]->on_the_line(*current_component)&&allLine[i]->getNodeindex()==-1){
@@ -189,10 +207,10 @@ void Circuit::analysis_circuit_connection()
             }
         }
 
-        QList<LineNodeitem*> working_line;
+        QList<NodeLine*> working_line;
 
         while(line_stack.size()){
-            LineNodeitem* current_line = line_stack.top();
+            NodeLine* current_line = line_stack.top();
             line_stack.pop();
             if(!working_line.contains(current_line))
                 working_line.append(current_line);
@@ -228,6 +246,27 @@ void Circuit::analysis_circuit_connection()
     total_numofNode = node_num;
     //qDebug()<<total_numofNode;
 }
+void Circuit::netlist_connection(int node_count)
+{
+    //terminals already carry their node indices, 0 is ground
+    if(allComponent.size()==0){
+        state = no_component;
+        qDebug()<<"There is no component";
+        return;
+    }
+    bool grounded = false;
+    for(auto c:allComponent)
+        for(auto n:c->getNodes())
+            if(n->getNodeIndex()==0)
+                grounded = true;
+    if(!grounded){
+        state = no_ground;
+        qDebug()<<"no ground :(";
+        return;
+    }
+    state = ok;
+    total_numofNode = node_count;
+}
 
 void Circuit::ini_sys()
 {
@@ -250,6 +289,30 @@ void Circuit::ini_sys()
     sys.A = new Matrix(num_of_unknown,num_of_unknown,0);
     sys.b = new Matrix(num_of_unknown,1,0);
     sys.ini = true;
+    jacobian_lu.singular = true;
+    schur_cache.clear();
+    structure_cache.clear();
+    lu_cache.clear();
+    diodes = diode_batch();
+    for(int i=0;i<allDiode.size();i++){
+        diodes.node1.push_back(allDiode[i]->getNodeindex1()-1); // 1 --|>-- 2
+        diodes.node2.push_back(allDiode[i]->getNodeindex2()-1);
+        diodes.Isat.push_back(allDiode[i]->get_Isat());
+    }
+    int num_of_diode = allDiode.size();
+    diodes.Id.assign(num_of_diode,0);
+    diodes.G.assign(num_of_diode,0);
+    diodes.cached.assign(num_of_diode,0);
+    diodes.Vd0.assign(num_of_diode,0);
+    diodes.Id0.assign(num_of_diode,0);
+    diodes.G0.assign(num_of_diode,0);
+    diode_colors = color_footprints(diodes.node1,diodes.node2,total_numofNode-1);
+    std::vector<int> source_node1,source_node2;
+    for(int i=0;i<allCurrent_source.size();i++){
+        source_node1.push_back(allCurrent_source[i]->getNodeindex1()-1);
+        source_node2.push_back(allCurrent_source[i]->getNodeindex2()-1);
+    }
+    current_source_colors = color_footprints(source_node1,source_node2,total_numofNode-1);
 
     //resistor stamps
 
@@ -300,8 +363,8 @@ void Circuit::ini_sys()
             sys.A->add_ij(matrix_offset+i,node2,1);
             sys.A->add_ij(node2,matrix_offset+i,1);
         }else if(node2<0){
-            sys.A->add_ij(matrix_offset+i,node2,1);
-            sys.A->add_ij(node2,matrix_offset+i,1);
+            sys.A->add_ij(matrix_offset+i,node1,1);
+            sys.A->add_ij(node1,matrix_offset+i,1);
         }else{
             sys.A->add_ij(matrix_offset+i,node2,1);
             sys.A->add_ij(node2,matrix_offset+i,1);
@@ -490,163 +553,94 @@ void Circuit::ini_sys()
         }
         sys.ini_A.add_ij(matrix_offset+i,matrix_offsetCCVS+vs_num,-A);
     }
+    rom = reduced_model();
+    reduction_stat = reduction_report();
+    if(reduction_moments>0)
+        build_reduced_model();
 
 }
-int dick = 1;
-Matrix Circuit::update_sys(const Matrix& last_state,double timestep,double current_time)
+Matrix Circuit::update_sys(const Matrix& last_state,double timestep,double current_time,const Matrix* guess)
 {
     if(sys.ini == false){
         qDebug()<<"non initialization";
         return Matrix();
     }
-    int matrix_offset=0;
-    (*sys.A) = sys.ini_A;
-
-    sys.b->setall(0);
-    //current_source stamps
-    for(int i=0;i<allCurrent_source.size();i++){
-        int node1 = allCurrent_source[i]->getNodeindex1()-1; // 1->2
-        int node2 = allCurrent_source[i]->getNodeindex2()-1;
-        double current = allCurrent_source[i]->get_current(current_time);
-        if(node1<0&&node2<0){
-            continue;
-        }else if(node1<0){
-            sys.b->add_ij(node2,0,current);
-        }else if(node2<0){
-            sys.b->add_ij(node1,0,current);
-        }else{
-            sys.b->add_ij(node1,0,current);
-            sys.b->add_ij(node2,0,-current);
-        }
-    }
-    //voltage_source stamps
-    matrix_offset = total_numofNode-1;
-    for(int i=0;i<allVoltage_source.size();i++){
-        int node1 = allVoltage_source[i]->getNodeindex1()-1; //-
-        int node2 = allVoltage_source[i]->getNodeindex2()-1; //+
-        double voltage = allVoltage_source[i]->get_voltage(current_time);
-        if(node1<0&&node2<0){
-            continue;
-        }else if(node1<0){
-            sys.b->add_ij(matrix_offset+i,0,voltage);
-        }else if(node2<0){
-            sys.b->add_ij(matrix_offset+i,0,-voltage);
-        }else{
-            sys.b->add_ij(matrix_offset+i,0,voltage);
-        }
-    }
-    //capacitor stamps
-    matrix_offset = total_numofNode-1+allVoltage_source.size();
-    for(int i=0;i<allCapacitor.size();i++){
-        int node1 = allCapacitor[i]->getNodeindex1()-1;
-        int node2 = allCapacitor[i]->getNodeindex2()-1;
-        double capacitance = allCapacitor[i]->get_capacitance();
-        if(node1<0&&node2<0){
-            continue;
-        }else if(node1<0){
-            sys.A->add_ij(matrix_offset+i,node2,-capacitance/timestep);
-            sys.b->add_ij(matrix_offset+i,0, capacitance * (-last_state(node2,0)) /timestep);
-        }else if(node2<0){
-            sys.A->add_ij(matrix_offset+i,node1,capacitance/timestep);
-            sys.b->add_ij(matrix_offset+i,0,capacitance * (last_state(node1,0)) /timestep);
-        }else{
-            sys.A->add_ij(matrix_offset+i,node1,capacitance/timestep);
-            sys.A->add_ij(matrix_offset+i,node2,-capacitance/timestep);
-            sys.b->add_ij(matrix_offset+i,0,capacitance*(last_state(node1,0)-last_state(node2,0))/timestep);
-        }
-
-
-    }
-    //inductor stamps
-    matrix_offset = total_numofNode-1+allVoltage_source.size()+allCapacitor.size();
-    for(int i=0;i<allInductor.size();i++){
-        int node1 = allInductor[i]->getNodeindex1()-1;
-        int node2 = allInductor[i]->getNodeindex2()-1;
-        double inductance = allInductor[i]->getInductance();
-        if(node1<0&&node2<0){
-            continue;
-        }else if(node1<0){
-            sys.A->add_ij(matrix_offset+i,matrix_offset+i,-inductance/timestep);
-            sys.b->add_ij(matrix_offset+i,0,-inductance*last_state(matrix_offset+i,0)/timestep);
-
-        }else if(node2<0){
-            sys.A->add_ij(matrix_offset+i,matrix_offset+i,-inductance/timestep);
-            sys.b->add_ij(matrix_offset+i,0,-inductance*last_state(matrix_offset+i,0)/timestep);
-
-        }else{
-            sys.A->add_ij(matrix_offset+i,matrix_offset+i,-inductance/timestep);
-            sys.b->add_ij(matrix_offset+i,0,-inductance*last_state(matrix_offset+i,0)/timestep);
-        }
-    }
-    //qDebug()<<"diode enter";
-
+    if(rom.valid)
+        return update_reduced(last_state,timestep,current_time,guess);
+    update_A_b(*sys.A,*sys.b,last_state,timestep,current_time);
     if(allDiode.size()==0){
-        Matrix  ans = sys.A->solve_gauss_elimination(*sys.b);
+        Matrix  ans = solve_linear(*sys.A,*sys.b,timestep);
+        newton_stat.factorizations++;
         //sys.A->debug();
         //sys.b->debug();
         //ans.debug();
         return ans;
     }
-    Matrix non_linear = *sys.b;
-    non_linear.setall(0);
-    QVector<QPair<int,int>> diodes_v;
-    for(int i=0;i<allDiode.size();i++){
-        int node1 = allDiode[i]->getNodeindex1()-1; // 1 --|>-- 2
-        int node2 = allDiode[i]->getNodeindex2()-1;
-
-        diodes_v.push_back(qMakePair(node1,node2));
-    }
     double diff = 100;
-    double accuracy = 1e-1;
+    double last_diff = -1;
+    double accuracy = newton_accuracy;
+    //a predicted guess that does not converge quickly is dropped
+    const int predictor_max_iterations = 10;
+    int iterations = 0;
     Matrix next_iter;
-    Matrix curr_iter = last_state;
+    Matrix curr_iter = guess ? *guess : last_state;
     Matrix f;
-    Matrix A = *sys.A;
-    Matrix b = *sys.b;
+    //linear part only depends on the previous time point
+    Matrix& A = *sys.A;
+    Matrix& b = *sys.b;
+    Matrix non_linear = b;
     Matrix Jacobian;
+    newton_stat.solves++;
+    if(schur_reduction){
+        if(guess){
+            if(solve_schur(A,b,*guess,timestep,curr_iter,predictor_max_iterations))
+                return curr_iter;
+            newton_stat.rejected_predictions++;
+            guess = nullptr;
+        }
+        if(solve_schur(A,b,last_state,timestep,curr_iter))
+            return curr_iter;
+        curr_iter = last_state;
+    }
+    bool refactor = jacobian_lu.singular || jacobian_timestep!=timestep;
     //NR iteration
-    int count=0;
     while(diff>accuracy)
     {
-
-        update_A_b(A,b,curr_iter,timestep,current_time);
-        Jacobian = get_jacobian(curr_iter,timestep);
-        //qDebug()<<"diode out";
-        for(int i=0;i<allDiode.size();i++){
-            int node1 = allDiode[i]->getNodeindex1()-1; // 1 --|>-- 2
-            int node2 = allDiode[i]->getNodeindex2()-1;
-            double Isat = allDiode[i]->get_Isat();
-            double Vd = curr_iter(node1,0)-curr_iter(node2,0);
-            if(Vd<=0)
-                continue;
-            double Id = Isat*(exp(40*Vd)-1);
-            if(!isnormal(Id))
-                continue;
-            //double Io = (exp(40*Vd)-1) - G*Vd;
-            if(node1<0&&node2<0){
-                continue;
-            }else if(node1<0){
-                non_linear.add_ij(node2,0,-Id);
-                //b.add_ij(node2,0,Io);
-
-            }else if(node2<0){
-                non_linear.add_ij(node1,0,Id);
-                //b.add_ij(node1,0,-Io);
-            }else{
-                non_linear.add_ij(node1,0,Id);
-                non_linear.add_ij(node2,0,-Id);
-               // b.add_ij(node1,0,-Io);
-               // b.add_ij(node2,0,Io);
-            }
-        }
+        non_linear.setall(0);
+        stamp_diode_current(non_linear,curr_iter);
         f = A*curr_iter+non_linear-(b);
         //f.debug();
 
-        next_iter = Jacobian.solve_gauss_elimination(Jacobian*curr_iter-f);
+        if(refactor || newton!=modified_newton){
+            jacobian_lu = factorize(get_jacobian(curr_iter,timestep));
+            jacobian_timestep = timestep;
+            newton_stat.factorizations++;
+            refactor = false;
+        }
+        if(jacobian_lu.singular){
+            Jacobian = get_jacobian(curr_iter,timestep);
+            next_iter = Jacobian.solve_gauss_elimination(Jacobian*curr_iter-f);
+            newton_stat.factorizations++;
+        }else{
+            next_iter = curr_iter - Matrix::lu_solve(jacobian_lu,f);
+        }
+        newton_stat.iterations++;
+        iterations++;
 
         diff = Matrix::calculate_maxVdifference(curr_iter,next_iter);
-        if(diff == -1)
-            dick = 0;
+        if(guess && (iterations>=predictor_max_iterations || !std::isfinite(diff))){
+            newton_stat.rejected_predictions++;
+            guess = nullptr;
+            curr_iter = last_state;
+            diff = 100;
+            last_diff = -1;
+            refactor = true;
+            continue;
+        }
+        //slow contraction, the old jacobian is too far from this operating point
+        if(last_diff>0 && diff>chord_contraction*last_diff)
+            refactor = true;
+        last_diff = diff;
 
         //curr_iter.debug();
         //next_iter.debug();
@@ -659,10 +653,254 @@ Matrix Circuit::update_sys(const Matrix& last_state,double timestep,double curre
 
 }
 
+Matrix Circuit::solve_linear(const Matrix &A,const Matrix &b,double timestep)
+{
+    if(structured_solver){
+        //the pattern is fixed after ini_sys, the values only change with the step size
+        int k = 0;
+        while(k<structure_cache.size() && structure_cache[k].first!=timestep)
+            k++;
+        if(k==structure_cache.size()){
+            if(structure_cache.size()>=4)
+                structure_cache.erase(structure_cache.begin());
+            //copies with the parent's topology reuse its ordering, a path that breaks down still falls back
+            matrix_structure s = shared_structure ? *shared_structure : A.analyze_structure();
+            structure_cache.push_back(qMakePair(timestep,s));
+            k = structure_cache.size()-1;
+            if(!shared_structure)
+                qDebug()<<"linear solver: "<<Matrix::solver_path_name(s.path)<<" (bandwidth "<<s.lower<<"/"<<s.upper<<(s.order.empty() ? ")" : ", reordered)");
+        }
+        matrix_structure &s = structure_cache[k].second;
+        if(s.path!=solver_general || !equilibration){
+            int path = s.path;
+            Matrix x = A.solve_structured(b,s);
+            if(s.path!=path)
+                qDebug()<<"linear solver: "<<Matrix::solver_path_name(path)<<" broke down, using "<<Matrix::solver_path_name(s.path);
+            if(s.path!=solver_general || !equilibration){
+                newton_stat.linear_solves[s.path]++;
+                return x;
+            }
+            //even the pivoted band broke down, from now on the equilibrated lu below solves it
+        }
+    }
+    newton_stat.linear_solves[solver_general]++;
+    if(!equilibration)
+        return const_cast<Matrix&>(A).solve_gauss_elimination(b);
+    //same values for the same step size, so the scaled factors are kept like the structure
+    int k = 0;
+    while(k<lu_cache.size() && lu_cache[k].first!=timestep)
+        k++;
+    if(k==lu_cache.size()){
+        if(lu_cache.size()>=4)
+            lu_cache.erase(lu_cache.begin());
+        lu_cache.push_back(qMakePair(timestep,factorize(A)));
+        k = lu_cache.size()-1;
+    }
+    const LU_factor &lu = lu_cache[k].second;
+    if(lu.singular)
+        return const_cast<Matrix&>(A).solve_gauss_elimination(b);
+    Matrix x = Matrix::lu_solve(lu,b);
+    if(refinement_steps>0)
+        x = Matrix::lu_refine(A,lu,b,x,refinement_steps,&newton_stat.refinement_steps);
+    return x;
+}
+LU_factor Circuit::factorize(const Matrix &A)
+{
+    LU_factor lu = A.lu_factorize(&pivot_order,equilibration);
+    structure_stat.repivoted += lu.repivoted;
+    if(equilibration)
+        newton_stat.equilibrated_factorizations++;
+    if(!lu.singular)
+        newton_stat.condition_estimate = std::max(newton_stat.condition_estimate,Matrix::condition_estimate(A,lu));
+    return lu;
+}
+schur_system& Circuit::get_schur_system(const Matrix &A,double timestep)
+{
+    for(int i=0;i<schur_cache.size();i++){
+        if(schur_cache[i].timestep == timestep)
+            return schur_cache[i];
+    }
+    //analysis() alternates between a few step sizes, keep the latest ones
+    if(schur_cache.size()>=4)
+        schur_cache.erase(schur_cache.begin());
+    schur_cache.push_back(schur_system());
+    schur_system& s = schur_cache.back();
+    s.timestep = timestep;
+
+    int n = A.get_row_num();
+    std::vector<int> local(n,-1);
+    for(int i=0;i<allDiode.size();i++){
+        int node1 = allDiode[i]->getNodeindex1()-1;
+        int node2 = allDiode[i]->getNodeindex2()-1;
+        if(node1>=0)
+            local[node1] = 0;
+        if(node2>=0)
+            local[node2] = 0;
+    }
+    //a branch unknown that only couples to diode nodes (e.g. the current of a
+    //source driving a diode) would leave A_LL singular, keep it with the diodes
+    bool moved = true;
+    while(moved){
+        moved = false;
+        for(int i=0;i<n;i++){
+            if(local[i]==0)
+                continue;
+            bool row_empty = true;
+            bool col_empty = true;
+            for(int j=0;j<n&&(row_empty||col_empty);j++){
+                if(local[j]==0)
+                    continue;
+                if(A(i,j)!=0)
+                    row_empty = false;
+                if(A(j,i)!=0)
+                    col_empty = false;
+            }
+            if(row_empty||col_empty){
+                local[i] = 0;
+                moved = true;
+            }
+        }
+    }
+    for(int i=0;i<n;i++){
+        if(local[i]==0){
+            local[i] = s.nonlinear.size();
+            s.nonlinear.push_back(i);
+        }else{
+            s.linear.push_back(i);
+        }
+    }
+    for(int i=0;i<allDiode.size();i++){
+        int node1 = allDiode[i]->getNodeindex1()-1;
+        int node2 = allDiode[i]->getNodeindex2()-1;
+        s.diode_node1.push_back(node1<0 ? -1 : local[node1]);
+        s.diode_node2.push_back(node2<0 ? -1 : local[node2]);
+    }
+
+    //factor the linear block once for this dt and fold it onto the diode nodes
+    Matrix A_NN = A.sub_matrix(s.nonlinear,s.nonlinear);
+    s.A_NL = A.sub_matrix(s.nonlinear,s.linear);
+    if(s.linear.empty()){
+        s.S = A_NN;
+        s.valid = true;
+        return s;
+    }
+    s.linear_lu = A.sub_matrix(s.linear,s.linear).lu_factorize();
+    newton_stat.factorizations++;
+    if(s.linear_lu.singular){
+        qDebug()<<"linear block is singular, no schur reduction";
+        return s;
+    }
+    s.W = Matrix::lu_solve(s.linear_lu,A.sub_matrix(s.linear,s.nonlinear));
+    s.S = A_NN - s.A_NL*s.W;
+    s.valid = true;
+    qDebug()<<"schur complement: "<<s.nonlinear.size()<<" of "<<n<<" unknowns";
+    return s;
+}
+bool Circuit::solve_schur(const Matrix &A,const Matrix &b,const Matrix &guess,double timestep,Matrix &ans,int max_iterations)
+{
+    schur_system& s = get_schur_system(A,timestep);
+    if(!s.valid)
+        return false;
+    int nN = s.nonlinear.size();
+    int nL = s.linear.size();
+
+    //eliminate the linear unknowns: x_L = y - W*x_N
+    Matrix y(nL,1);
+    Matrix b_N(nN,1);
+    for(int i=0;i<nN;i++)
+        b_N.set_ij(i,0,b(s.nonlinear[i],0));
+    if(nL>0){
+        Matrix b_L(nL,1);
+        for(int i=0;i<nL;i++)
+            b_L.set_ij(i,0,b(s.linear[i],0));
+        y = Matrix::lu_solve(s.linear_lu,b_L);
+        b_N -= s.A_NL*y;
+    }
+
+    Matrix x(nN,1);
+    for(int i=0;i<nN;i++)
+        x.set_ij(i,0,guess(s.nonlinear[i],0));
+    //NR iteration on the diode nodes only
+    if(!solve_reduced_newton(s.S,b_N,x,s.diode_node1,s.diode_node2,max_iterations))
+        return false;
+
+    //one back substitution for the linear network
+    ans = Matrix(A.get_row_num(),1);
+    for(int i=0;i<nN;i++)
+        ans.set_ij(s.nonlinear[i],0,x(i,0));
+    if(nL>0){
+        Matrix x_L = y - s.W*x;
+        for(int i=0;i<nL;i++)
+            ans.set_ij(s.linear[i],0,x_L(i,0));
+    }
+    return true;
+}
+bool Circuit::solve_reduced_newton(Matrix &S,const Matrix &b,Matrix &x,const std::vector<int> &node1,const std::vector<int> &node2,int max_iterations)
+{
+    //S x + Id(x) = b, diode terminals given as positions in x
+    Matrix next;
+    int iterations = 0;
+    LU_factor J_lu;
+    bool refactor = true;
+    double diff = 100;
+    double last_diff = -1;
+    double accuracy = newton_accuracy;
+    while(diff>accuracy)
+    {
+        Matrix F = S*x-b;
+        Matrix J = S;
+        evaluate_diodes(x,node1,node2);
+        //the local numbering keeps node sharing, so the global colors still apply
+        for(int c=0;c<diode_colors.size();c++){
+            const QVector<int>& color = diode_colors[c];
+            parallel_for(color.size(),[&](int begin,int end){
+                for(int k=begin;k<end;k++){
+                    int i = color[k];
+                    int n1 = node1[i];
+                    int n2 = node2[i];
+                    double Id = diodes.Id[i];
+                    double G = diodes.G[i];
+                    if(Id==0||G==0)
+                        continue;
+                    if(n1>=0){
+                        F.add_ij(n1,0,Id);
+                        J.add_ij(n1,n1,G);
+                    }
+                    if(n2>=0){
+                        F.add_ij(n2,0,-Id);
+                        J.add_ij(n2,n2,G);
+                    }
+                    if(n1>=0&&n2>=0){
+                        J.add_ij(n1,n2,-G);
+                        J.add_ij(n2,n1,-G);
+                    }
+                }
+            });
+        }
+        if(refactor||newton!=modified_newton){
+            J_lu = factorize(J);
+            newton_stat.factorizations++;
+            refactor = false;
+            if(J_lu.singular)
+                return false;
+        }
+        next = x - Matrix::lu_solve(J_lu,F);
+        newton_stat.iterations++;
+        iterations++;
+
+        diff = Matrix::calculate_maxVdifference(x,next);
+        if(max_iterations>0 && (iterations>=max_iterations || !std::isfinite(diff)))
+            return false;
+        if(last_diff>0 && diff>chord_contraction*last_diff)
+            refactor = true;
+        last_diff = diff;
+        x = next;
+    }
+    return true;
+}
 void Circuit::analysis(double t,double maxtimestep)
 {
 
-    double current_time = 0;
     double min_timestep = t/200000;
     double max_timestep;
     if(maxtimestep == -1)
@@ -671,15 +909,26 @@ void Circuit::analysis(double t,double maxtimestep)
         max_timestep = maxtimestep;
     qDebug()<<"max";
     qDebug()<<max_timestep;
-    double accuracy = 1e-3;
-    double timestep = (min_timestep);
+    newton_stat.clear();
     //initial state dc analysis
     Matrix last_state = dc_analysis();
     ini_sys();
     solutions.push_back(qMakePair(last_state,0));
+    if(exponential_stepping && allDiode.size()==0 && !rom.valid && analysis_exponential(t,max_timestep,last_state)){
+        report_newton_statistics();
+        return;
+    }
     //total_numofNode-1;
-
-    while(current_time<=t){
+    transient(0,t,min_timestep,max_timestep,false);
+    report_newton_statistics();
+}
+void Circuit::transient(double t0,double t1,double min_timestep,double max_timestep,bool exact_end)
+{
+    //adaptive backward euler from solutions.back(), exact_end stops on t1 instead of past it
+    double current_time = t0;
+    double accuracy = 1e-3;
+    double timestep = (min_timestep);
+    while(exact_end ? current_time<t1 : current_time<=t1){
 
         //double diff = 0;
 
@@ -689,9 +938,16 @@ void Circuit::analysis(double t,double maxtimestep)
         Matrix x_now = solutions.back().first;
         Matrix x_better;
 
-        x_step = update_sys(x_now,timestep,current_time);
-        x_halfstep = update_sys(x_now,timestep/2,current_time);
-        x_twohalfstep = update_sys(x_halfstep,timestep/2,current_time+timestep/2);
+        Matrix guess;
+        bool predict = predictor_order>0 && allDiode.size()>0;
+        if(predict)
+            guess = predict_state(current_time+timestep);
+        x_step = step_state(x_now,timestep,current_time,predict ? &guess : nullptr);
+        if(predict)
+            guess = predict_state(current_time+timestep/2);
+        x_halfstep = step_state(x_now,timestep/2,current_time,predict ? &guess : nullptr);
+        //the second half step starts from x_halfstep, x_step is already a good guess
+        x_twohalfstep = step_state(x_halfstep,timestep/2,current_time+timestep/2,predict ? &x_step : nullptr);
 
         double diff = Matrix::calculate_maxVdifference(x_step,x_twohalfstep);
         //qDebug()<<timestep;
@@ -706,74 +962,1800 @@ void Circuit::analysis(double t,double maxtimestep)
             timestep = min_timestep;
         if(timestep>max_timestep)
             timestep = max_timestep;
+        if(exact_end && current_time+timestep>t1)
+            timestep = t1-current_time;
         //timestep = t/10000;
-        x_better = update_sys(x_now,timestep,current_time);
+        if(predict)
+            guess = predict_state(current_time+timestep);
+        x_better = step_state(x_now,timestep,current_time,predict ? &guess : nullptr);
 
         current_time+=timestep;
+        if(exact_end && current_time>=t1)
+            current_time = t1;
         solutions.push_back(qMakePair(x_better,current_time));
+        newton_stat.accepted_steps++;
+        if(keep_jacobians){
+            //the factors newton last used on this step, the adjoint sweep solves on their transpose
+            int n = x_better.get_row_num();
+            bool fits = !jacobian_lu.singular && jacobian_timestep==timestep && jacobian_lu.LU.get_row_num()==n;
+            fits = fits && (long long)(kept_jacobians.size()+1)*n*n<=kept_jacobian_limit;
+            kept_jacobians.push_back(fits ? jacobian_lu : LU_factor());
+        }
 
         //timestep = t/10000;
 
     }
 }
-double Circuit::calculate_maxtimestep()
+Circuit* Circuit::solver_copy()
 {
-    double ans = INT32_MAX;
-    for(int i=0;i<allVoltage_source.size();i++){
-        if(!allVoltage_source[i]->isDCsource()){
-            qDebug()<<1/allVoltage_source[i]->getFrequency();
-            ans = std::min(ans,1/allVoltage_source[i]->getFrequency());
-        }
+    //shares the components, owns its own matrices and caches
+    Circuit* c = new Circuit();
+    c->owns_components = false;
+    c->allComponent = allComponent;
+    c->component_names = component_names;
+    c->component_slot = component_slot;
+    c->component_index_stale = component_index_stale;
+    c->allResistor = allResistor;
+    c->allInductor = allInductor;
+    c->allCapacitor = allCapacitor;
+    c->allVoltage_source = allVoltage_source;
+    c->allCurrent_source = allCurrent_source;
+    c->allCCCS = allCCCS;
+    c->allCCVS = allCCVS;
+    c->allVCCS = allVCCS;
+    c->allVCVS = allVCVS;
+    c->allDiode = allDiode;
+    c->total_numofNode = total_numofNode;
+    c->initial_condition = initial_condition;
+    c->state = state;
+    c->newton = newton;
+    c->chord_contraction = chord_contraction;
+    c->newton_accuracy = newton_accuracy;
+    c->schur_reduction = schur_reduction;
+    c->structured_solver = structured_solver;
+    c->shared_structure = shared_structure;
+    c->equilibration = equilibration;
+    c->refinement_steps = refinement_steps;
+    c->pivot_order = pivot_order;
+    c->predictor_order = predictor_order;
+    c->device_bypass = device_bypass;
+    c->bypass_tolerance = bypass_tolerance;
+    c->reduction_moments = reduction_moments;
+    c->reduction_max_size = reduction_max_size;
+    c->probed_nodes = probed_nodes;
+    c->ini_sys();
+    return c;
+}
+bool Circuit::parareal_analysis(double t,int slices,double maxtimestep)
+{
+    parareal_stat = parareal_report();
+    if(slices<=0)
+        slices = std::max(4,assembly_threads);
+    double max_timestep = maxtimestep==-1 ? calculate_maxtimestep() : maxtimestep;
+    //same floor as analysis(), so the fine result matches a serial run
+    double min_timestep = t/200000;
+    double slice = t/slices;
+    //fixed backward euler steps, no finer than the fine engine's largest step
+    int coarse_steps = std::max(10,int(ceil(slice/max_timestep)));
+
+    newton_stat.clear();
+    Matrix x0 = dc_analysis();
+    ini_sys();
+    if(state!=ok)
+        return false;
+    QVector<Circuit*> fine;
+    for(int j=0;j<slices;j++)
+        fine.push_back(solver_copy());
+
+    //coarse propagator on this circuit, one slice from x
+    auto coarse = [&](Matrix x,int j){
+        double h = slice/coarse_steps;
+        for(int k=0;k<coarse_steps;k++)
+            x = update_sys(x,h,j*slice+k*h);
+        return x;
+    };
+    QVector<Matrix> U(slices+1);//states on the slice boundaries
+    QVector<Matrix> G(slices+1);//coarse result of the previous iteration
+    QVector<Matrix> F(slices+1);
+    U[0] = x0;
+    for(int j=0;j<slices;j++){
+        G[j+1] = coarse(U[j],j);
+        U[j+1] = G[j+1];
     }
-    for(int i=0;i<allCurrent_source.size();i++){
-        if(!allCurrent_source[i]->isDCsource()){
-            ans = std::min(ans,1/allCurrent_source[i]->getFrequency());
+    QElapsedTimer timer;
+    timer.start();
+    double fine_time = 0;
+    for(int k=0;k<slices;k++){
+        //fine propagators, slices before k are already exact
+        QElapsedTimer fine_timer;
+        fine_timer.start();
+        std::function<void(int,int)> body = [&](int begin,int end){
+            for(int j=k+begin;j<k+end;j++){
+                Circuit* c = fine[j];
+                c->solutions.clear();
+                c->newton_stat.clear();
+                c->solutions.push_back(qMakePair(U[j],j*slice));
+                c->transient(j*slice,(j+1)*slice,min_timestep,max_timestep,true);
+                F[j+1] = c->solutions.back().first;
+            }
+        };
+        if(pool)
+            pool->parallel_for(slices-k,1,body);
+        else
+            body(0,slices-k);
+        fine_time += fine_timer.elapsed();
+        parareal_stat.iterations++;
+
+        //sequential coarse correction
+        double change = 0;
+        double scale = 0;
+        for(int j=k;j<slices;j++){
+            Matrix g = coarse(U[j],j);
+            Matrix next = g+F[j+1]-G[j+1];
+            G[j+1] = g;
+            change = std::max(change,Matrix::calculate_maxVdifference(next,U[j+1]));
+            for(int i=0;i<next.get_row_num();i++)
+                scale = std::max(scale,fabs(next(i,0)));
+            U[j+1] = next;
         }
-    }
-    for(int i=0;i<allCapacitor.size();i++){
-        for(int j=0;j<allInductor.size();j++){
-            ans = std::min(ans,sqrt(allCapacitor[i]->get_capacitance()*allInductor[i]->getInductance())/(2*M_PI));
+        parareal_stat.boundary_change = change;
+        qDebug()<<"parareal iteration "<<k+1<<": boundary change "<<change;
+        //after k+1 sweeps the first k+1 slices started from exact states
+        if(change<=1e-6+1e-5*scale || k+1==slices){
+            parareal_stat.converged = true;
+            break;
         }
     }
-    return ans/10;
+    //the last fine sweep started from converged boundaries, stitch it together
+    solutions.clear();
+    solutions.push_back(qMakePair(x0,0));
+    for(int j=0;j<slices;j++){
+        const QVector< QPair<Matrix,double> >& part = fine[j]->get_solutions();
+        for(int i=1;i<part.size();i++)
+            solutions.push_back(part[i]);
+        newton_stat.accepted_steps += fine[j]->get_newton_statistics().accepted_steps;
+        delete fine[j];
+    }
+    parareal_stat.slices = slices;
+    parareal_stat.elapsed = timer.elapsed();
+    parareal_stat.fine_elapsed = fine_time;
+    qDebug()<<"parareal: "<<slices<<" slices, "<<parareal_stat.iterations<<" iterations, "<<(parareal_stat.converged ? "converged" : "not converged");
+    qDebug()<<"ideal speedup with one core per slice: "<<double(slices)/parareal_stat.iterations;
+    return parareal_stat.converged;
 }
-Matrix Circuit::dc_analysis()
+const parareal_report& Circuit::get_parareal_report()
 {
-    if(state!=ok){
-        qDebug()<<"There is something wrong @@";
-        return Matrix(1,1,0);
+    return parareal_stat;
+}
+void Circuit::build_reduced_model()
+{
+    //ports: nodes touching anything but R, L and C, plus probed and initial condition nodes
+    int nodes = total_numofNode-1;
+    int n = sys.ini_A.get_row_num();
+    std::vector<char> port(nodes,0);
+    std::vector<char> touched(nodes,0);
+    auto mark = [&](int node){
+        if(node>=0&&node<nodes)
+            port[node] = 1;
+    };
+    for(int i=0;i<allVoltage_source.size();i++){
+        mark(allVoltage_source[i]->getNodeindex1()-1);
+        mark(allVoltage_source[i]->getNodeindex2()-1);
     }
-    bool no_dc = true;
-    int num_of_unknown = total_numofNode-1;//without ground
-    num_of_unknown += allVoltage_source.size();
-    num_of_unknown += allCapacitor.size();
-    num_of_unknown += allInductor.size();
-    num_of_unknown += allVCVS.size();
-    num_of_unknown += allCCVS.size();
-
-    Matrix A(num_of_unknown,num_of_unknown,0);
-    Matrix b(num_of_unknown,1,0);
-    Matrix last_state(num_of_unknown,1,0);
-    //qDebug()<<"hello";
-    for(int i=0;i<initial_condition.size();i++){
-        if(initial_condition[i].first != 0)
-            last_state.set_ij(initial_condition[i].first-1,0,initial_condition[i].second);
+    for(int i=0;i<allCurrent_source.size();i++){
+        mark(allCurrent_source[i]->getNodeindex1()-1);
+        mark(allCurrent_source[i]->getNodeindex2()-1);
+    }
+    for(int i=0;i<allDiode.size();i++){
+        mark(allDiode[i]->getNodeindex1()-1);
+        mark(allDiode[i]->getNodeindex2()-1);
+    }
+    for(int i=0;i<allVCCS.size();i++){
+        mark(allVCCS[i]->getNodeindex1()-1);
+        mark(allVCCS[i]->getNodeindex2()-1);
+        mark(getDependantNode(allVCCS[i]->getDependantNode1())-1);
+        mark(getDependantNode(allVCCS[i]->getDependantNode2())-1);
+    }
+    for(int i=0;i<allVCVS.size();i++){
+        mark(allVCVS[i]->getNodeindex1()-1);
+        mark(allVCVS[i]->getNodeindex2()-1);
+        mark(getDependantNode(allVCVS[i]->getDependantNode1())-1);
+        mark(getDependantNode(allVCVS[i]->getDependantNode2())-1);
+    }
+    for(int i=0;i<allCCCS.size();i++){
+        mark(allCCCS[i]->getNodeindex1()-1);
+        mark(allCCCS[i]->getNodeindex2()-1);
+    }
+    for(int i=0;i<allCCVS.size();i++){
+        mark(allCCVS[i]->getNodeindex1()-1);
+        mark(allCCVS[i]->getNodeindex2()-1);
+    }
+    for(int i=0;i<initial_condition.size();i++)
+        mark(initial_condition[i].first-1);
+    for(int i=0;i<probed_nodes.size();i++)
+        mark(probed_nodes[i]-1);
+    auto touch = [&](int node){
+        if(node>=0&&node<nodes)
+            touched[node] = 1;
+    };
+    for(int i=0;i<allResistor.size();i++){
+        touch(allResistor[i]->getNodeindex1()-1);
+        touch(allResistor[i]->getNodeindex2()-1);
+    }
+    for(int i=0;i<allCapacitor.size();i++){
+        touch(allCapacitor[i]->getNodeindex1()-1);
+        touch(allCapacitor[i]->getNodeindex2()-1);
+    }
+    for(int i=0;i<allInductor.size();i++){
+        touch(allInductor[i]->getNodeindex1()-1);
+        touch(allInductor[i]->getNodeindex2()-1);
     }
-    //Debug()<<"hello";
-    //resistor stamps
 
-    int matrix_offset=0;
+    //local numbering of the subnetwork: ports first, then internal unknowns
+    std::vector<int> local(n,-1);
+    std::vector<int> port_rows;
+    std::vector<int> internal;
+    for(int i=0;i<nodes;i++)
+        if(touched[i]&&!port[i])
+            internal.push_back(i);
+    if(internal.empty()){
+        qDebug()<<"model reduction: no internal nodes";
+        return;
+    }
+    auto inside = [&](int node){
+        return node>=0 && !port[node] && touched[node];
+    };
+    auto port_of = [&](int node){
+        if(node>=0 && port[node] && local[node]<0){
+            local[node] = port_rows.size();
+            port_rows.push_back(node);
+        }
+    };
+    int c_offset = total_numofNode-1+allVoltage_source.size();
+    int l_offset = c_offset+allCapacitor.size();
+    std::vector<int> resistors;
+    std::vector<int> capacitors;
     for(int i=0;i<allResistor.size();i++){
         int node1 = allResistor[i]->getNodeindex1()-1;
         int node2 = allResistor[i]->getNodeindex2()-1;
-        double conductance = 1/allResistor[i]->get_resistance();
-        if(node1<0&&node2<0){
-            continue;
-        }else if(node1<0){
-            A.add_ij(node2,node2,conductance);
-        }else if(node2<0){
-            A.add_ij(node1,node1,conductance);
-        }else{
+        if(inside(node1)||inside(node2)){
+            resistors.push_back(i);
+            port_of(node1);
+            port_of(node2);
+        }
+    }
+    for(int i=0;i<allCapacitor.size();i++){
+        int node1 = allCapacitor[i]->getNodeindex1()-1;
+        int node2 = allCapacitor[i]->getNodeindex2()-1;
+        if(inside(node1)||inside(node2)){
+            capacitors.push_back(i);
+            port_of(node1);
+            port_of(node2);
+        }
+    }
+    for(int i=0;i<allInductor.size();i++){
+        int node1 = allInductor[i]->getNodeindex1()-1;
+        int node2 = allInductor[i]->getNodeindex2()-1;
+        if(inside(node1)||inside(node2)){
+            internal.push_back(l_offset+i);
+            port_of(node1);
+            port_of(node2);
+        }
+    }
+    int np = port_rows.size();
+    int ni = internal.size();
+    for(int k=0;k<ni;k++)
+        local[internal[k]] = np+k;
+
+    //nodal G and C of the subnetwork, inductor rows L i' = v2 - v1 as in ini_sys
+    //the inductor coupling is skew, so G + G^T and C stay positive semidefinite
+    Matrix G(np+ni,np+ni,0);
+    Matrix C(np+ni,np+ni,0);
+    auto stamp = [&](Matrix &M,int node1,int node2,double value){
+        int a = node1<0 ? -1 : local[node1];
+        int b = node2<0 ? -1 : local[node2];
+        if(a>=0)
+            M.add_ij(a,a,value);
+        if(b>=0)
+            M.add_ij(b,b,value);
+        if(a>=0&&b>=0){
+            M.add_ij(a,b,-value);
+            M.add_ij(b,a,-value);
+        }
+    };
+    for(int i : resistors)
+        stamp(G,allResistor[i]->getNodeindex1()-1,allResistor[i]->getNodeindex2()-1,1/allResistor[i]->get_resistance());
+    for(int i : capacitors)
+        stamp(C,allCapacitor[i]->getNodeindex1()-1,allCapacitor[i]->getNodeindex2()-1,allCapacitor[i]->get_capacitance());
+    int inductors = 0;
+    for(int k=0;k<ni;k++){
+        if(internal[k]<l_offset)
+            continue;
+        int i = internal[k]-l_offset;
+        int row = np+k;
+        int a = allInductor[i]->getNodeindex1()-1;
+        int b = allInductor[i]->getNodeindex2()-1;
+        a = a<0 ? -1 : local[a];
+        b = b<0 ? -1 : local[b];
+        if(a>=0){
+            G.add_ij(a,row,-1);
+            G.add_ij(row,a,1);
+        }
+        if(b>=0){
+            G.add_ij(b,row,1);
+            G.add_ij(row,b,-1);
+        }
+        C.add_ij(row,row,allInductor[i]->getInductance());
+        inductors++;
+    }
+    std::vector<int> P(np);
+    std::vector<int> I(ni);
+    for(int k=0;k<np;k++)
+        P[k] = k;
+    for(int k=0;k<ni;k++)
+        I[k] = np+k;
+    Matrix G_II = G.sub_matrix(I,I);
+    Matrix C_II = C.sub_matrix(I,I);
+    Matrix G_IP = G.sub_matrix(I,P);
+    Matrix C_IP = C.sub_matrix(I,P);
+
+    //moments about s0 = 0, or about the fastest source rate when the network floats at dc
+    double s0 = 0;
+    LU_factor M_lu = G_II.lu_factorize();
+    if(M_lu.singular){
+        s0 = 1/calculate_maxtimestep();
+        M_lu = (G_II+C_II*s0).lu_factorize();
+    }
+    if(M_lu.singular){
+        qDebug()<<"model reduction: internal network is singular";
+        return;
+    }
+
+    //block arnoldi: span{R, A R, A^2 R, ...} with A = (G+s0 C)^-1 C, R = (G+s0 C)^-1 [G_IP C_IP]
+    std::vector< std::vector<double> > basis;
+    int max_size = reduction_max_size>0 ? std::min(reduction_max_size,ni) : ni;
+    auto orthonormalize = [&](Matrix R){
+        std::vector< std::vector<double> > added;
+        for(int c=0;c<R.get_col_num() && (int)basis.size()<max_size;c++){
+            std::vector<double> v = R.get_col(c);
+            double norm0 = 0;
+            for(double x : v)
+                norm0 += x*x;
+            norm0 = sqrt(norm0);
+            if(norm0==0)
+                continue;
+            //modified gram schmidt twice, deflate what is left of a dependent column
+            for(int pass=0;pass<2;pass++){
+                for(const std::vector<double> &u : basis){
+                    double d = 0;
+                    for(int k=0;k<ni;k++)
+                        d += u[k]*v[k];
+                    for(int k=0;k<ni;k++)
+                        v[k] -= d*u[k];
+                }
+            }
+            double norm = 0;
+            for(double x : v)
+                norm += x*x;
+            norm = sqrt(norm);
+            if(norm<=1e-10*norm0)
+                continue;
+            for(double &x : v)
+                x /= norm;
+            basis.push_back(v);
+            added.push_back(v);
+        }
+        Matrix next(ni,added.size(),0);
+        for(int c=0;c<(int)added.size();c++)
+            for(int k=0;k<ni;k++)
+                next.set_ij(k,c,added[c][k]);
+        return next;
+    };
+    Matrix start(ni,2*np,0);
+    for(int k=0;k<ni;k++){
+        for(int c=0;c<np;c++){
+            start.set_ij(k,c,G_IP(k,c));
+            start.set_ij(k,np+c,C_IP(k,c));
+        }
+    }
+    Matrix block = orthonormalize(Matrix::lu_solve(M_lu,start));
+    for(int m=1;m<reduction_moments && block.get_col_num()>0 && (int)basis.size()<max_size;m++)
+        block = orthonormalize(Matrix::lu_solve(M_lu,C_II*block));
+    int q = basis.size();
+    if(q==0 || q>=ni){
+        qDebug()<<"model reduction: "<<q<<" states would not reduce "<<ni<<" unknowns";
+        return;
+    }
+
+    rom.V = Matrix(ni,q,0);
+    for(int c=0;c<q;c++)
+        for(int k=0;k<ni;k++)
+            rom.V.set_ij(k,c,basis[c][k]);
+    rom.Vt = rom.V.transpose();
+    Matrix G_PI = G.sub_matrix(P,I);
+    Matrix C_PI = C.sub_matrix(P,I);
+    rom.G_pz = G_PI*rom.V;
+    rom.G_zp = rom.Vt*G_IP;
+    rom.G_zz = rom.Vt*G_II*rom.V;
+    rom.C_pp = C.sub_matrix(P,P);
+    rom.C_pz = C_PI*rom.V;
+    rom.C_zp = rom.Vt*C_IP;
+    rom.C_zz = rom.Vt*C_II*rom.V;
+
+    //the kept system drops the internal rows and the reduced capacitor currents
+    std::vector<char> dropped(n,0);
+    for(int r : internal)
+        dropped[r] = 1;
+    for(int i : capacitors)
+        dropped[c_offset+i] = 1;
+    std::vector<int> position(n,-1);
+    for(int r=0;r<n;r++){
+        if(dropped[r])
+            continue;
+        position[r] = rom.kept.size();
+        rom.kept.push_back(r);
+    }
+    rom.port_rows = port_rows;
+    for(int r : port_rows)
+        rom.ports.push_back(position[r]);
+    rom.internal = internal;
+    rom.capacitors = capacitors;
+    for(int i=0;i<allDiode.size();i++){
+        int node1 = allDiode[i]->getNodeindex1()-1;
+        int node2 = allDiode[i]->getNodeindex2()-1;
+        rom.diode_node1.push_back(node1<0 ? -1 : position[node1]);
+        rom.diode_node2.push_back(node2<0 ? -1 : position[node2]);
+    }
+    rom.valid = true;
+
+    reduction_stat.ports = np;
+    reduction_stat.internal = ni+capacitors.size();
+    reduction_stat.reduced_size = q;
+    reduction_stat.elements = resistors.size()+capacitors.size()+inductors;
+    reduction_stat.expansion_point = s0;
+    qDebug()<<"model reduction: "<<reduction_stat.elements<<" elements, "<<reduction_stat.internal<<" unknowns -> "<<q<<" states at "<<np<<" ports";
+    qDebug()<<"system size "<<n<<" -> "<<rom.kept.size()+q;
+}
+Matrix Circuit::update_reduced(const Matrix& last_state,double timestep,double current_time,const Matrix* guess)
+{
+    //kept rows of the assembled system with the reduced model stamped on the ports
+    update_A_b(*sys.A,*sys.b,last_state,timestep,current_time);
+    const Matrix& A = *sys.A;
+    const Matrix& b = *sys.b;
+    int nk = rom.kept.size();
+    int np = rom.ports.size();
+    int ni = rom.internal.size();
+    int q = rom.V.get_col_num();
+    int m = nk+q;
+    Matrix Ac(m,m,0);
+    Matrix bc(m,1,0);
+    for(int i=0;i<nk;i++){
+        for(int j=0;j<nk;j++)
+            Ac.set_ij(i,j,A(rom.kept[i],rom.kept[j]));
+        bc.set_ij(i,0,b(rom.kept[i],0));
+    }
+    //backward euler on G x + C x' with the history of the port voltages and z = V^T x_internal
+    Matrix v_old(np,1);
+    Matrix x_int(ni,1);
+    for(int a=0;a<np;a++)
+        v_old.set_ij(a,0,last_state(rom.port_rows[a],0));
+    for(int k=0;k<ni;k++)
+        x_int.set_ij(k,0,last_state(rom.internal[k],0));
+    Matrix z_old = rom.Vt*x_int;
+    Matrix history_p = rom.C_pp*v_old+rom.C_pz*z_old;
+    Matrix history_z = rom.C_zp*v_old+rom.C_zz*z_old;
+    for(int a=0;a<np;a++){
+        int pa = rom.ports[a];
+        bc.add_ij(pa,0,history_p(a,0)/timestep);
+        for(int c=0;c<np;c++)
+            Ac.add_ij(pa,rom.ports[c],rom.C_pp(a,c)/timestep);
+        for(int k=0;k<q;k++){
+            Ac.add_ij(pa,nk+k,rom.G_pz(a,k)+rom.C_pz(a,k)/timestep);
+            Ac.add_ij(nk+k,pa,rom.G_zp(k,a)+rom.C_zp(k,a)/timestep);
+        }
+    }
+    for(int k=0;k<q;k++){
+        bc.add_ij(nk+k,0,history_z(k,0)/timestep);
+        for(int l=0;l<q;l++)
+            Ac.add_ij(nk+k,nk+l,rom.G_zz(k,l)+rom.C_zz(k,l)/timestep);
+    }
+
+    Matrix y(m,1);
+    if(allDiode.size()==0){
+        //the reduced block is dense, partial pivoting keeps it stable at tiny steps
+        y = Matrix::lu_solve(Ac.lu_factorize(),bc);
+        newton_stat.factorizations++;
+    }else{
+        newton_stat.solves++;
+        auto start = [&](const Matrix &x){
+            for(int i=0;i<nk;i++)
+                y.set_ij(i,0,x(rom.kept[i],0));
+            for(int k=0;k<q;k++)
+                y.set_ij(nk+k,0,z_old(k,0));
+        };
+        start(guess ? *guess : last_state);
+        if(!solve_reduced_newton(Ac,bc,y,rom.diode_node1,rom.diode_node2,guess ? 10 : -1) && guess){
+            newton_stat.rejected_predictions++;
+            start(last_state);
+            solve_reduced_newton(Ac,bc,y,rom.diode_node1,rom.diode_node2,-1);
+        }
+    }
+
+    //expand: internal unknowns from the basis, capacitor currents from their voltage change
+    Matrix x = last_state;
+    for(int i=0;i<nk;i++)
+        x.set_ij(rom.kept[i],0,y(i,0));
+    Matrix z(q,1);
+    for(int k=0;k<q;k++)
+        z.set_ij(k,0,y(nk+k,0));
+    Matrix internal = rom.V*z;
+    for(int k=0;k<ni;k++)
+        x.set_ij(rom.internal[k],0,internal(k,0));
+    int c_offset = total_numofNode-1+allVoltage_source.size();
+    for(int i : rom.capacitors){
+        int node1 = allCapacitor[i]->getNodeindex1()-1;
+        int node2 = allCapacitor[i]->getNodeindex2()-1;
+        double dv = x(node1,0)-x(node2,0)-last_state(node1,0)+last_state(node2,0);
+        x.set_ij(c_offset+i,0,allCapacitor[i]->get_capacitance()*dv/timestep);
+    }
+    return x;
+}
+void Circuit::set_model_reduction(int moments,int max_size,const QVector<int> &probes)
+{
+    reduction_moments = std::max(0,moments);
+    reduction_max_size = max_size;
+    probed_nodes = probes;
+}
+const reduction_report& Circuit::get_reduction_report()
+{
+    return reduction_stat;
+}
+Matrix Circuit::step_state(const Matrix& last_state,double timestep,double current_time,const Matrix* guess)
+{
+    if(block.owned.empty())
+        return update_sys(last_state,timestep,current_time,guess);
+    return update_block(last_state,timestep,current_time,guess);
+}
+Matrix Circuit::update_block(const Matrix& last_state,double timestep,double current_time,const Matrix* guess)
+{
+    //owned rows only, the couplings to other partitions move to the right hand side
+    update_A_b(*sys.A,*sys.b,last_state,timestep,current_time);
+    int m = block.owned.size();
+    Matrix x = last_state;
+    for(int k=0;k<(int)block.inputs.size();k++)
+        x.set_ij(block.inputs[k],0,waveform_value(*block.input_waves[k],current_time+timestep,block.inputs[k]));
+    Matrix S = sys.A->sub_matrix(block.owned,block.owned);
+    Matrix b(m,1);
+    for(int i=0;i<m;i++){
+        int row = block.owned[i];
+        double value = (*sys.b)(row,0);
+        for(int k=0;k<(int)block.inputs.size();k++)
+            value -= (*sys.A)(row,block.inputs[k])*x(block.inputs[k],0);
+        b.set_ij(i,0,value);
+    }
+    bool nonlinear = false;
+    for(int i=0;i<(int)block.diode_node1.size();i++)
+        nonlinear = nonlinear || block.diode_node1[i]>=0 || block.diode_node2[i]>=0;
+    Matrix y(m,1);
+    if(!nonlinear){
+        y = S.solve_gauss_elimination(b);
+        newton_stat.factorizations++;
+    }else{
+        newton_stat.solves++;
+        const Matrix& start = guess ? *guess : last_state;
+        for(int i=0;i<m;i++)
+            y.set_ij(i,0,start(block.owned[i],0));
+        if(!solve_reduced_newton(S,b,y,block.diode_node1,block.diode_node2,guess ? 10 : -1) && guess){
+            newton_stat.rejected_predictions++;
+            for(int i=0;i<m;i++)
+                y.set_ij(i,0,last_state(block.owned[i],0));
+            solve_reduced_newton(S,b,y,block.diode_node1,block.diode_node2,-1);
+        }
+    }
+    for(int i=0;i<m;i++)
+        x.set_ij(block.owned[i],0,y(i,0));
+    return x;
+}
+double Circuit::waveform_value(const QVector< QPair<Matrix,double> > &wave,double t,int row)
+{
+    //linear interpolation, held constant outside the simulated span
+    if(t<=wave.front().second)
+        return wave.front().first(row,0);
+    if(t>=wave.back().second)
+        return wave.back().first(row,0);
+    int k = std::upper_bound(wave.begin(),wave.end(),t,[](double time,const QPair<Matrix,double> &p){
+        return time<p.second;
+    })-wave.begin();
+    const QPair<Matrix,double> &a = wave[k-1];
+    const QPair<Matrix,double> &b = wave[k];
+    if(b.second<=a.second)
+        return b.first(row,0);
+    double s = (t-a.second)/(b.second-a.second);
+    return a.first(row,0)+s*(b.first(row,0)-a.first(row,0));
+}
+QVector<std::vector<int>> Circuit::partition_unknowns()
+{
+    //union find over the MNA unknowns, strongly coupled elements join theirs
+    int n = sys.ini_A.get_row_num();
+    std::vector<int> parent(n);
+    for(int i=0;i<n;i++)
+        parent[i] = i;
+    auto find = [&](int i){
+        while(parent[i]!=i){
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+    auto join = [&](int a,int b){
+        if(a<0||b<0)
+            return;
+        a = find(a);
+        b = find(b);
+        if(a!=b)
+            parent[std::max(a,b)] = std::min(a,b);
+    };
+    int vs_offset = total_numofNode-1;
+    int c_offset = vs_offset+allVoltage_source.size();
+    int l_offset = c_offset+allCapacitor.size();
+    int vcvs_offset = l_offset+allInductor.size();
+    int ccvs_offset = vcvs_offset+allVCVS.size();
+    //high impedance resistors are weak links
+    for(int i=0;i<allResistor.size();i++){
+        if(allResistor[i]->get_resistance()<relaxation_resistance)
+            join(allResistor[i]->getNodeindex1()-1,allResistor[i]->getNodeindex2()-1);
+    }
+    for(int i=0;i<allVoltage_source.size();i++){
+        join(vs_offset+i,allVoltage_source[i]->getNodeindex1()-1);
+        join(vs_offset+i,allVoltage_source[i]->getNodeindex2()-1);
+    }
+    for(int i=0;i<allCapacitor.size();i++){
+        join(c_offset+i,allCapacitor[i]->getNodeindex1()-1);
+        join(c_offset+i,allCapacitor[i]->getNodeindex2()-1);
+    }
+    for(int i=0;i<allInductor.size();i++){
+        join(l_offset+i,allInductor[i]->getNodeindex1()-1);
+        join(l_offset+i,allInductor[i]->getNodeindex2()-1);
+    }
+    for(int i=0;i<allCurrent_source.size();i++)
+        join(allCurrent_source[i]->getNodeindex1()-1,allCurrent_source[i]->getNodeindex2()-1);
+    for(int i=0;i<allDiode.size();i++)
+        join(allDiode[i]->getNodeindex1()-1,allDiode[i]->getNodeindex2()-1);
+    //controlled sources only join their output side, the controls are one way links
+    for(int i=0;i<allVCCS.size();i++)
+        join(allVCCS[i]->getNodeindex1()-1,allVCCS[i]->getNodeindex2()-1);
+    for(int i=0;i<allCCCS.size();i++)
+        join(allCCCS[i]->getNodeindex1()-1,allCCCS[i]->getNodeindex2()-1);
+    for(int i=0;i<allVCVS.size();i++){
+        join(vcvs_offset+i,allVCVS[i]->getNodeindex1()-1);
+        join(vcvs_offset+i,allVCVS[i]->getNodeindex2()-1);
+    }
+    for(int i=0;i<allCCVS.size();i++){
+        join(ccvs_offset+i,allCCVS[i]->getNodeindex1()-1);
+        join(ccvs_offset+i,allCCVS[i]->getNodeindex2()-1);
+    }
+    QVector<std::vector<int>> parts;
+    std::vector<int> index(n,-1);
+    for(int i=0;i<n;i++){
+        int root = find(i);
+        if(index[root]<0){
+            index[root] = parts.size();
+            parts.push_back(std::vector<int>());
+        }
+        parts[index[root]].push_back(i);
+    }
+    return parts;
+}
+bool Circuit::relaxation_analysis(double t,int max_sweeps,double maxtimestep)
+{
+    relaxation_stat = relaxation_report();
+    QElapsedTimer timer;
+    timer.start();
+    newton_stat.clear();
+    Matrix x0 = dc_analysis();
+    ini_sys();
+    if(state!=ok)
+        return false;
+    //partitions are cut from the full system
+    rom.valid = false;
+    QVector<std::vector<int>> parts = partition_unknowns();
+    int P = parts.size();
+    qDebug()<<"waveform relaxation: "<<P<<" partitions";
+    if(P<2){
+        analysis(t,maxtimestep);
+        relaxation_stat.converged = true;
+        relaxation_stat.partitions = P;
+        relaxation_stat.sweeps = 1;
+        relaxation_stat.elapsed = timer.elapsed();
+        return true;
+    }
+    int n = x0.get_row_num();
+    double min_timestep = t/200000;
+    //interface waveforms are settled once they move less than the local error target of transient()
+    const double accuracy = 1e-3;
+    std::vector<int> owner(n);
+    for(int p=0;p<P;p++)
+        for(int i : parts[p])
+            owner[i] = p;
+
+    QVector<Circuit*> part;
+    QVector<std::vector<int>> feeds(P);//partitions read by each partition
+    std::vector<double> max_step(P,-1);
+    for(int p=0;p<P;p++){
+        Circuit* c = solver_copy();
+        relaxation_block& blk = c->block;
+        blk.owned = parts[p];
+        std::vector<int> local(n,-1);
+        for(int k=0;k<(int)blk.owned.size();k++)
+            local[blk.owned[k]] = k;
+        //foreign columns of the owned rows, capacitor and inductor stamps never cross partitions
+        std::vector<char> seen(n,0);
+        for(int i : blk.owned){
+            for(int j=0;j<n;j++){
+                if(owner[j]!=p && !seen[j] && sys.ini_A(i,j)!=0){
+                    seen[j] = 1;
+                    blk.inputs.push_back(j);
+                    if(std::find(feeds[p].begin(),feeds[p].end(),owner[j])==feeds[p].end())
+                        feeds[p].push_back(owner[j]);
+                }
+            }
+        }
+        blk.input_waves.assign(blk.inputs.size(),nullptr);
+        for(int i=0;i<allDiode.size();i++){
+            int node1 = allDiode[i]->getNodeindex1()-1;
+            int node2 = allDiode[i]->getNodeindex2()-1;
+            blk.diode_node1.push_back(node1<0 ? -1 : local[node1]);
+            blk.diode_node2.push_back(node2<0 ? -1 : local[node2]);
+        }
+        part.push_back(c);
+    }
+    //step limits from each partition's own sources, so slow blocks keep long steps
+    for(int i=0;i<allVoltage_source.size();i++){
+        if(allVoltage_source[i]->isDCsource())
+            continue;
+        int p = owner[total_numofNode-1+i];
+        double h = 1/allVoltage_source[i]->getFrequency()/10;
+        max_step[p] = max_step[p]<0 ? h : std::min(max_step[p],h);
+    }
+    for(int i=0;i<allCurrent_source.size();i++){
+        int node = std::max(allCurrent_source[i]->getNodeindex1(),allCurrent_source[i]->getNodeindex2())-1;
+        if(allCurrent_source[i]->isDCsource() || node<0)
+            continue;
+        int p = owner[node];
+        double h = 1/allCurrent_source[i]->getFrequency()/10;
+        max_step[p] = max_step[p]<0 ? h : std::min(max_step[p],h);
+    }
+    //a block never steps coarser than the blocks driving it, or it would alias their waveforms
+    for(int pass=0;pass<P;pass++){
+        for(int p=0;p<P;p++){
+            for(int q : feeds[p]){
+                if(max_step[q]>0)
+                    max_step[p] = max_step[p]<0 ? max_step[q] : std::min(max_step[p],max_step[q]);
+            }
+        }
+    }
+    for(int p=0;p<P;p++){
+        if(maxtimestep!=-1)
+            max_step[p] = maxtimestep;
+        else if(max_step[p]<0)
+            max_step[p] = t/100;
+    }
+
+    //gauss seidel: dependency order, a block only waits for earlier blocks that feed it
+    std::vector<int> order;
+    std::vector<int> position(P,-1);
+    std::vector<int> level(P,0);
+    while((int)order.size()<P){
+        int next = -1;
+        for(int p=0;p<P&&next<0;p++){
+            if(position[p]>=0)
+                continue;
+            bool ready = true;
+            for(int q : feeds[p])
+                ready = ready && (position[q]>=0 || q==p);
+            if(ready)
+                next = p;
+        }
+        //feedback loop, break it at the first unsolved block
+        for(int p=0;p<P&&next<0;p++)
+            if(position[p]<0)
+                next = p;
+        position[next] = order.size();
+        order.push_back(next);
+    }
+    bool feedback = false;
+    int levels = 1;
+    for(int p : order){
+        for(int q : feeds[p]){
+            if(relaxation_mode==gauss_seidel_sweep && position[q]<position[p])
+                level[p] = std::max(level[p],level[q]+1);
+            else
+                feedback = true;
+        }
+        levels = std::max(levels,level[p]+1);
+    }
+
+    std::vector< QVector< QPair<Matrix,double> > > previous(P);
+    for(int p=0;p<P;p++)
+        previous[p].push_back(qMakePair(x0,0.0));
+    for(int sweep=0;sweep<max_sweeps;sweep++){
+        for(int p=0;p<P;p++){
+            relaxation_block& blk = part[p]->block;
+            for(int k=0;k<(int)blk.inputs.size();k++){
+                int q = owner[blk.inputs[k]];
+                bool fresh = relaxation_mode==gauss_seidel_sweep && position[q]<position[p];
+                blk.input_waves[k] = fresh ? &part[q]->solutions : &previous[q];
+            }
+        }
+        for(int l=0;l<levels;l++){
+            std::vector<int> ready;
+            for(int p : order)
+                if(level[p]==l)
+                    ready.push_back(p);
+            std::function<void(int,int)> body = [&](int begin,int end){
+                for(int k=begin;k<end;k++){
+                    Circuit* c = part[ready[k]];
+                    c->solutions.clear();
+                    c->newton_stat.clear();
+                    c->solutions.push_back(qMakePair(x0,0.0));
+                    c->transient(0,t,min_timestep,max_step[ready[k]],true);
+                }
+            };
+            if(pool)
+                pool->parallel_for(ready.size(),1,body);
+            else
+                body(0,ready.size());
+        }
+        relaxation_stat.sweeps++;
+
+        //compare every input waveform with the one the sweep started from
+        double change = 0;
+        double scale = 0;
+        for(int p=0;p<P;p++){
+            const relaxation_block& blk = part[p]->block;
+            for(int j : blk.inputs){
+                const QVector< QPair<Matrix,double> >& wave = part[owner[j]]->solutions;
+                for(int k=0;k<wave.size();k++){
+                    double value = wave[k].first(j,0);
+                    change = std::max(change,fabs(value-waveform_value(previous[owner[j]],wave[k].second,j)));
+                    scale = std::max(scale,fabs(value));
+                }
+            }
+        }
+        for(int p=0;p<P;p++)
+            previous[p] = part[p]->solutions;
+        relaxation_stat.interface_change = change;
+        qDebug()<<"relaxation sweep "<<sweep+1<<": interface change "<<change;
+        //without feedback every block already read final waveforms
+        if(!feedback || change<=accuracy*std::max(1.0,scale)){
+            relaxation_stat.converged = true;
+            break;
+        }
+    }
+
+    //merge the partitions onto the union of their time points
+    std::vector<double> times;
+    for(int p=0;p<P;p++)
+        for(int k=0;k<previous[p].size();k++)
+            times.push_back(previous[p][k].second);
+    std::sort(times.begin(),times.end());
+    solutions.clear();
+    for(int k=0;k<(int)times.size();k++){
+        if(k>0 && times[k]-times[k-1]<=min_timestep*1e-6)
+            continue;
+        Matrix x(n,1);
+        for(int p=0;p<P;p++)
+            for(int i : parts[p])
+                x.set_ij(i,0,waveform_value(previous[p],times[k],i));
+        solutions.push_back(qMakePair(x,times[k]));
+    }
+    relaxation_stat.partitions = P;
+    for(int p=0;p<P;p++){
+        relaxation_stat.steps.push_back(part[p]->newton_stat.accepted_steps);
+        newton_stat.accepted_steps += part[p]->newton_stat.accepted_steps;
+        delete part[p];
+    }
+    relaxation_stat.elapsed = timer.elapsed();
+    qDebug()<<"waveform relaxation: "<<relaxation_stat.sweeps<<" sweeps, "<<(relaxation_stat.converged ? "converged" : "not converged");
+    qDebug()<<"accepted steps per partition: "<<relaxation_stat.steps;
+    return relaxation_stat.converged;
+}
+const relaxation_report& Circuit::get_relaxation_report()
+{
+    return relaxation_stat;
+}
+void Circuit::set_relaxation_coupling(double resistance)
+{
+    relaxation_resistance = resistance;
+}
+void Circuit::set_relaxation_sweep(int mode)
+{
+    relaxation_mode = mode;
+}
+Matrix Circuit::predict_state(double time)
+{
+    //lagrange extrapolation through the last predictor_order+1 solutions
+    int points = std::min(predictor_order+1,int(solutions.size()));
+    int first = solutions.size()-points;
+    Matrix ans(solutions.back().first.get_row_num(),1);
+    for(int k=first;k<solutions.size();k++){
+        double weight = 1;
+        for(int j=first;j<solutions.size();j++){
+            if(j!=k)
+                weight *= (time-solutions[j].second)/(solutions[k].second-solutions[j].second);
+        }
+        Matrix x = solutions[k].first;
+        ans += x*weight;
+    }
+    newton_stat.predictions++;
+    return ans;
+}
+Matrix Circuit::storage_matrix(std::vector<int> &rows)
+{
+    //descriptor rows, the same stamps update_A_b makes with C/h and -L/h
+    int n = sys.ini_A.get_row_num();
+    int c_offset = total_numofNode-1+allVoltage_source.size();
+    int l_offset = c_offset+allCapacitor.size();
+    Matrix E(n,n,0);
+    rows.clear();
+    for(int i=0;i<allCapacitor.size();i++){
+        int node1 = allCapacitor[i]->getNodeindex1()-1;
+        int node2 = allCapacitor[i]->getNodeindex2()-1;
+        double capacitance = allCapacitor[i]->get_capacitance();
+        E.add_ij(c_offset+i,node1,capacitance);
+        E.add_ij(c_offset+i,node2,-capacitance);
+        rows.push_back(c_offset+i);
+    }
+    for(int i=0;i<allInductor.size();i++){
+        E.set_ij(l_offset+i,l_offset+i,-allInductor[i]->getInductance());
+        rows.push_back(l_offset+i);
+    }
+    return E;
+}
+bool Circuit::build_state_space()
+{
+    ss = state_space_system();
+    int n = sys.ini_A.get_row_num();
+    std::vector<int> rows;
+    Matrix E = storage_matrix(rows);
+    int m = rows.size();
+    if(m==0)
+        return false;
+
+    //M x = [u; w]: the static rows with every storage row replaced by its state
+    Matrix M = sys.ini_A;
+    for(int k=0;k<m;k++){
+        for(int j=0;j<n;j++)
+            M.set_ij(rows[k],j,E(rows[k],j));
+    }
+    LU_factor M_lu = M.lu_factorize();
+    if(M_lu.singular){
+        qDebug()<<"capacitor loop or inductor cutset, no state space form";
+        return false;
+    }
+    Matrix P(n,m,0);
+    for(int k=0;k<m;k++)
+        P.set_ij(rows[k],k,1);
+    ss.R = Matrix::lu_solve(M_lu,P);
+
+    //source waveforms: z = [1, square levels, cos/sin pairs]
+    int ncs = allCurrent_source.size();
+    int nvs = allVoltage_source.size();
+    int q = 1;
+    for(int j=0;j<ncs+nvs;j++){
+        bool dc = j<ncs ? allCurrent_source[j]->isDCsource() : allVoltage_source[j-ncs]->isDCsource();
+        bool square = j<ncs ? allCurrent_source[j]->isSquaresource() : allVoltage_source[j-ncs]->isSquaresource();
+        ss.square_slot.push_back(square ? q : -1);
+        ss.sine_slot.push_back(!dc&&!square ? q : -1);
+        if(square)
+            q += 1;
+        else if(!dc)
+            q += 2;
+    }
+    //u = B z, each source sampled through its own stamp pattern
+    Matrix B(n,q,0);
+    for(int j=0;j<ncs+nvs;j++){
+        //offset + a cos(wt) + b sin(wt) from three samples of the sine
+        double weight[3] = {0,0,0};
+        int slot[3] = {0,-1,-1};
+        if(ss.square_slot[j]>=0){
+            weight[0] = 1;
+            slot[0] = ss.square_slot[j];
+        }else if(ss.sine_slot[j]>=0){
+            double f = j<ncs ? allCurrent_source[j]->getFrequency() : allVoltage_source[j-ncs]->getFrequency();
+            double v[3];
+            for(int k=0;k<3;k++){
+                double t = k/(4*f);
+                v[k] = j<ncs ? allCurrent_source[j]->get_current(t) : allVoltage_source[j-ncs]->get_voltage(t);
+            }
+            weight[0] = (v[0]+v[2])/2;
+            weight[1] = (v[0]-v[2])/2;
+            weight[2] = v[1]-weight[0];
+            slot[1] = ss.sine_slot[j];
+            slot[2] = ss.sine_slot[j]+1;
+        }else{
+            weight[0] = j<ncs ? allCurrent_source[j]->get_current(0) : allVoltage_source[j-ncs]->get_voltage(0);
+        }
+        for(int k=0;k<3;k++){
+            if(slot[k]<0||weight[k]==0)
+                continue;
+            if(j<ncs){
+                int node1 = allCurrent_source[j]->getNodeindex1()-1; // 1->2
+                int node2 = allCurrent_source[j]->getNodeindex2()-1;
+                if(node1<0&&node2<0)
+                    continue;
+                else if(node1<0)
+                    B.add_ij(node2,slot[k],weight[k]);
+                else if(node2<0)
+                    B.add_ij(node1,slot[k],weight[k]);
+                else{
+                    B.add_ij(node1,slot[k],weight[k]);
+                    B.add_ij(node2,slot[k],-weight[k]);
+                }
+            }else{
+                int i = j-ncs;
+                int node1 = allVoltage_source[i]->getNodeindex1()-1; //-
+                int node2 = allVoltage_source[i]->getNodeindex2()-1; //+
+                if(node1<0&&node2<0)
+                    continue;
+                else if(node2<0)
+                    B.add_ij(total_numofNode-1+i,slot[k],-weight[k]);
+                else
+                    B.add_ij(total_numofNode-1+i,slot[k],weight[k]);
+            }
+        }
+    }
+    ss.Q = Matrix::lu_solve(M_lu,B);
+
+    //w' = -(A x) on the storage rows
+    std::vector<int> all(n);
+    for(int j=0;j<n;j++)
+        all[j] = j;
+    Matrix A_r = sys.ini_A.sub_matrix(rows,all);
+    Matrix F = A_r*ss.R;
+    Matrix H = A_r*ss.Q;
+    ss.Y = Matrix(m+q,m+q,0);
+    for(int i=0;i<m;i++){
+        for(int j=0;j<m;j++)
+            ss.Y.set_ij(i,j,-F(i,j));
+        for(int j=0;j<q;j++)
+            ss.Y.set_ij(i,m+j,-H(i,j));
+    }
+    for(int j=0;j<ncs+nvs;j++){
+        int k = ss.sine_slot[j];
+        if(k<0)
+            continue;
+        double w = 2*M_PI*(j<ncs ? allCurrent_source[j]->getFrequency() : allVoltage_source[j-ncs]->getFrequency());
+        ss.Y.set_ij(m+k,m+k+1,-w);//cos' = -w sin
+        ss.Y.set_ij(m+k+1,m+k,w);//sin' = w cos
+    }
+    ss.E_w = E.sub_matrix(rows,all);
+    ss.valid = true;
+    qDebug()<<"exponential stepping: "<<m<<" states, "<<q<<" source states";
+    return true;
+}
+Matrix& Circuit::get_propagator(double h)
+{
+    for(int i=0;i<ss.propagators.size();i++){
+        if(ss.propagators[i].first == h)
+            return ss.propagators[i].second;
+    }
+    //steps cut short by a breakpoint are rare, keep the latest few
+    if(ss.propagators.size()>=8)
+        ss.propagators.erase(ss.propagators.begin());
+    Matrix Yh = ss.Y*h;
+    ss.propagators.push_back(qMakePair(h,Yh.exponential()));
+    return ss.propagators.back().second;
+}
+Matrix Circuit::source_state(double t,double square_time)
+{
+    int ncs = allCurrent_source.size();
+    int q = ss.Y.get_row_num()-ss.E_w.get_row_num();
+    Matrix z(q,1,0);
+    z.set_ij(0,0,1);
+    for(int j=0;j<int(ss.square_slot.size());j++){
+        if(ss.square_slot[j]>=0){
+            double level = j<ncs ? allCurrent_source[j]->get_current(square_time) : allVoltage_source[j-ncs]->get_voltage(square_time);
+            z.set_ij(ss.square_slot[j],0,level);
+        }else if(ss.sine_slot[j]>=0){
+            double w = 2*M_PI*(j<ncs ? allCurrent_source[j]->getFrequency() : allVoltage_source[j-ncs]->getFrequency());
+            z.set_ij(ss.sine_slot[j],0,cos(w*t));
+            z.set_ij(ss.sine_slot[j]+1,0,sin(w*t));
+        }
+    }
+    return z;
+}
+bool Circuit::analysis_exponential(double t,double max_timestep,const Matrix &x0)
+{
+    if(!build_state_space())
+        return false;
+    int m = ss.E_w.get_row_num();
+    int q = ss.Y.get_row_num()-m;
+    //the step is exact, it is only capped so the waveform has enough points
+    double h_max = std::min(max_timestep,t/1000);
+    Matrix x = x0;
+    Matrix w = ss.E_w*x;
+    Matrix wz(m+q,1,0);
+    double current_time = 0;
+    while(current_time<t){
+        double h = std::min(h_max,t-current_time);
+        double next = current_time+h;
+        for(int j=0;j<allCurrent_source.size();j++)
+            next = std::min(next,allCurrent_source[j]->getNextBreakpoint(current_time));
+        for(int j=0;j<allVoltage_source.size();j++)
+            next = std::min(next,allVoltage_source[j]->getNextBreakpoint(current_time));
+        if(next-current_time<h)
+            h = next-current_time;
+        //square levels are constant inside the step, take them from its middle
+        Matrix z = source_state(current_time,current_time+h/2);
+        for(int i=0;i<m;i++)
+            wz.set_ij(i,0,w(i,0));
+        for(int i=0;i<q;i++)
+            wz.set_ij(m+i,0,z(i,0));
+        Matrix next_wz = get_propagator(h)*wz;
+        for(int i=0;i<m;i++)
+            w.set_ij(i,0,next_wz(i,0));
+        current_time = next;
+
+        z = source_state(current_time,current_time);
+        x = ss.R*w+ss.Q*z;
+        solutions.push_back(qMakePair(x,current_time));
+        newton_stat.accepted_steps++;
+    }
+    qDebug()<<"exponential stepping: "<<newton_stat.accepted_steps<<" steps, "<<ss.propagators.size()<<" step sizes cached";
+    return true;
+}
+void Circuit::set_structured_solver(bool on)
+{
+    structured_solver = on;
+    structure_cache.clear();
+}
+void Circuit::set_equilibration(bool on,int refinement_steps)
+{
+    equilibration = on;
+    this->refinement_steps = std::max(0,refinement_steps);
+    lu_cache.clear();
+    jacobian_lu.singular = true;
+}
+void Circuit::set_exponential_stepping(bool on)
+{
+    exponential_stepping = on;
+}
+double Circuit::source_period()
+{
+    //the slowest source sets the period, the others have to fit into it
+    double f_min = INFINITY;
+    QVector<double> frequencies;
+    for(int i=0;i<allVoltage_source.size();i++){
+        if(!allVoltage_source[i]->isDCsource())
+            frequencies.push_back(allVoltage_source[i]->getFrequency());
+    }
+    for(int i=0;i<allCurrent_source.size();i++){
+        if(!allCurrent_source[i]->isDCsource())
+            frequencies.push_back(allCurrent_source[i]->getFrequency());
+    }
+    for(int i=0;i<frequencies.size();i++)
+        f_min = std::min(f_min,frequencies[i]);
+    if(frequencies.empty() || !(f_min>0))
+        return -1;
+    for(int i=0;i<frequencies.size();i++){
+        double ratio = frequencies[i]/f_min;
+        if(fabs(ratio-round(ratio))>1e-6*ratio)
+            return -1;
+    }
+    return 1/f_min;
+}
+bool Circuit::pss_analysis(double period,int steps_per_period)
+{
+    pss_stat = pss_report();
+    if(period<=0)
+        period = source_period();
+    if(period<=0){
+        qDebug()<<"no common source period, give one to pss_analysis";
+        return false;
+    }
+    pss_stat.period = period;
+    newton_stat.clear();
+    Matrix x0 = dc_analysis();
+    ini_sys();
+    if(state!=ok)
+        return false;
+    //the shooting sensitivities are taken on the full system
+    rom.valid = false;
+    //x(T) has to be a smooth and accurate function of x(0): every step is solved
+    //a hundred times below the shooting tolerance and no device is bypassed
+    double saved_accuracy = newton_accuracy;
+    bool saved_bypass = device_bypass;
+    double x0_scale = 0;
+    for(int i=0;i<x0.get_row_num();i++)
+        x0_scale = std::max(x0_scale,fabs(x0(i,0)));
+    newton_accuracy = 1e-11+1e-8*x0_scale;
+    device_bypass = false;
+
+    int n = x0.get_row_num();
+    double h = period/steps_per_period;
+    std::vector<int> rows;
+    Matrix E_h = storage_matrix(rows)*(1/h);
+    const int max_iterations = 30;
+    Matrix S;
+    QVector< QPair<Matrix,double> > waveform;
+
+    //shooting newton on x(T) - x(0) = 0
+    for(int iter=0;iter<max_iterations;iter++){
+        //one period with fixed steps, so x(T) is a smooth function of x(0)
+        Matrix x = x0;
+        S = Matrix(n,n,0);
+        for(int i=0;i<n;i++)
+            S.set_ij(i,i,1);
+        waveform.clear();
+        waveform.push_back(qMakePair(x,0.0));
+        for(int k=0;k<steps_per_period;k++){
+            x = update_sys(x,h,k*h);
+            //sensitivity of one backward euler step: J dx_next = E/h dx
+            Matrix rhs = E_h*S;
+            S = Matrix::lu_solve(get_jacobian(x,h).lu_factorize(),rhs);
+            waveform.push_back(qMakePair(x,(k+1)*h));
+        }
+        pss_stat.periods_computed++;
+
+        Matrix r = x-x0;
+        double residual = 0;
+        double scale = 0;
+        for(int i=0;i<n;i++){
+            residual = std::max(residual,fabs(r(i,0)));
+            scale = std::max(scale,fabs(x(i,0)));
+        }
+        pss_stat.residual = residual;
+        newton_accuracy = 1e-11+1e-8*std::max(scale,x0_scale);
+        qDebug()<<"pss iteration "<<iter+1<<": residual "<<residual;
+        if(residual<=1e-9+1e-6*scale){
+            pss_stat.converged = true;
+            break;
+        }
+        //(S - I) dx0 = -(x(T) - x0)
+        Matrix K = S;
+        for(int i=0;i<n;i++)
+            K.add_ij(i,i,-1);
+        LU_factor K_lu = K.lu_factorize();
+        if(K_lu.singular){
+            qDebug()<<"pss: monodromy matrix has an eigenvalue 1";
+            break;
+        }
+        x0 -= Matrix::lu_solve(K_lu,r);
+    }
+    solutions = waveform;
+    newton_accuracy = saved_accuracy;
+    device_bypass = saved_bypass;
+
+    //power iteration on the monodromy matrix: how fast plain transient would settle
+    //v keeps a max norm of 1, so the growth of S*v is the spectral radius
+    Matrix v(n,1,1);
+    double rho = 0;
+    for(int k=0;k<100;k++){
+        Matrix next = S*v;
+        double norm = 0;
+        for(int i=0;i<n;i++)
+            norm = std::max(norm,fabs(next(i,0)));
+        if(norm==0)
+            break;
+        rho = norm;
+        v = next*(1/norm);
+    }
+    pss_stat.floquet_radius = rho;
+    if(rho<1)
+        pss_stat.periods_to_settle = rho>0 ? int(ceil(log(1e-6)/log(rho))) : 1;
+
+    qDebug()<<"pss "<<(pss_stat.converged ? "converged" : "did not converge")<<" after "<<pss_stat.periods_computed<<" periods computed";
+    if(pss_stat.periods_to_settle>=0)
+        qDebug()<<"plain transient needs about "<<pss_stat.periods_to_settle<<" periods to settle to 1e-6 (decay "<<rho<<" per period)";
+    return pss_stat.converged;
+}
+const pss_report& Circuit::get_pss_report()
+{
+    return pss_stat;
+}
+bool Circuit::get_excitation(QString source,Matrix &column)
+{
+    //b of a unit value on the named independent source, with the signs update_A_b uses
+    int n = total_numofNode-1+allVoltage_source.size()+allCapacitor.size()+allInductor.size()+allVCVS.size()+allCCVS.size();
+    column = Matrix(n,1);
+    for(int i=0;i<allVoltage_source.size();i++){
+        if(allVoltage_source[i]->getname()!=source)
+            continue;
+        int node1 = allVoltage_source[i]->getNodeindex1()-1; //-
+        int node2 = allVoltage_source[i]->getNodeindex2()-1; //+
+        if(node1>=0 || node2>=0)
+            column.set_ij(total_numofNode-1+i,0,(node2<0 && node1>=0) ? -1 : 1);
+        return true;
+    }
+    for(int i=0;i<allCurrent_source.size();i++){
+        if(allCurrent_source[i]->getname()!=source)
+            continue;
+        int node1 = allCurrent_source[i]->getNodeindex1()-1; // 1->2
+        int node2 = allCurrent_source[i]->getNodeindex2()-1;
+        if(node1<0&&node2<0){
+            return true;
+        }else if(node1<0){
+            column.add_ij(node2,0,1);
+        }else if(node2<0){
+            column.add_ij(node1,0,1);
+        }else{
+            column.add_ij(node1,0,1);
+            column.add_ij(node2,0,-1);
+        }
+        return true;
+    }
+    qDebug()<<"no independent source named "<<source;
+    return false;
+}
+Matrix Circuit::solve_excitations(const Matrix &U,double timestep)
+{
+    //every column of U is a right hand side for the same linear network
+    if(state!=ok)
+        return Matrix();
+    if(allDiode.size()>0){
+        qDebug()<<"excitation sweeps need a linear circuit";
+        return Matrix();
+    }
+    if(!sys.ini)
+        ini_sys();
+    int n = sys.ini_A.get_row_num();
+    if(U.get_row_num()!=n){
+        qDebug()<<"excitations need "<<n<<" rows";
+        return Matrix();
+    }
+    QElapsedTimer timer;
+    timer.start();
+    //timestep 0 is the static network, otherwise the backward euler matrix of one step
+    Matrix A = sys.ini_A;
+    if(timestep>0){
+        std::vector<int> rows;
+        Matrix E = storage_matrix(rows);
+        for(int i=0;i<n;i++){
+            for(int j=0;j<n;j++){
+                if(E(i,j)!=0)
+                    A.add_ij(i,j,E(i,j)/timestep);
+            }
+        }
+    }
+    LU_factor lu = A.lu_factorize();
+    if(lu.singular){
+        qDebug()<<"singular network matrix";
+        return Matrix();
+    }
+    Matrix X = Matrix::lu_solve_blocked(lu,U);
+    qDebug()<<U.get_col_num()<<" excitations of "<<n<<" unknowns in "<<timer.elapsed()<<" ms";
+    return X;
+}
+bool Circuit::ac_analysis(QString source,double f_start,double f_stop,int points,int sweep)
+{
+    ac_stat = ac_report();
+    ac_magnitude.clear();
+    ac_phase.clear();
+    if(f_start<=0 || f_stop<f_start || points<1){
+        qDebug()<<"bad ac sweep";
+        return false;
+    }
+    int n = total_numofNode-1+allVoltage_source.size()+allCapacitor.size()+allInductor.size()+allVCVS.size()+allCCVS.size();
+    //unit excitation on the named source, every other source is off
+    Matrix excitation;
+    if(!get_excitation(source,excitation))
+        return false;
+    ComplexMatrix u(n,1);
+    for(int i=0;i<n;i++)
+        u.set_ij(i,0,excitation(i,0));
+
+    //linearize at the operating point: G = A0 + diode conductances, C = E
+    Matrix x0 = dc_analysis();
+    ini_sys();
+    rom.valid = false;
+    if(state!=ok)
+        return false;
+    Matrix G = sys.ini_A;
+    if(x0.get_row_num()==n)
+        stamp_diode_conductance(G,x0);
+    std::vector<int> rows;
+    Matrix E = storage_matrix(rows);
+
+    QVector<double> frequencies;
+    if(sweep==ac_linear){
+        for(int k=0;k<points;k++)
+            frequencies.push_back(points==1 ? f_start : f_start+k*(f_stop-f_start)/(points-1));
+    }else{
+        //points per decade or octave
+        double base = sweep==ac_octave ? 2 : 10;
+        int steps = int(ceil(log(f_stop/f_start)/log(base)*points-1e-9));
+        for(int k=0;k<=steps;k++)
+            frequencies.push_back(std::min(f_stop,f_start*pow(base,double(k)/points)));
+    }
+    int count = frequencies.size();
+
+    //G + jwC only changes in value, the pivot order found at the middle of the sweep is kept for all points
+    auto assemble = [&](double f){
+        ComplexMatrix Y(n,n);
+        double w = 2*M_PI*f;
+        for(int i=0;i<n;i++){
+            for(int j=0;j<n;j++){
+                if(G(i,j)!=0 || E(i,j)!=0)
+                    Y.set_ij(i,j,std::complex<double>(G(i,j),w*E(i,j)));
+            }
+        }
+        return Y;
+    };
+    QElapsedTimer timer;
+    timer.start();
+    complex_LU_factor reference = assemble(frequencies[count/2]).lu_factorize();
+    if(reference.singular){
+        qDebug()<<"singular small signal matrix";
+        return false;
+    }
+    std::vector<ComplexMatrix> X(count);
+    std::vector<int> repivoted(count,0);
+    std::function<void(int,int)> body = [&](int begin,int end){
+        for(int k=begin;k<end;k++){
+            complex_LU_factor f = assemble(frequencies[k]).lu_factorize(&reference.perm);
+            repivoted[k] = f.repivoted;
+            X[k] = ComplexMatrix::lu_solve(f,u);
+        }
+    };
+    if(pool)
+        pool->parallel_for(count,1,body);
+    else
+        body(0,count);
+
+    for(int k=0;k<count;k++){
+        Matrix magnitude(n,1);
+        Matrix phase(n,1);
+        for(int i=0;i<n;i++){
+            magnitude.set_ij(i,0,std::abs(X[k](i,0)));
+            phase.set_ij(i,0,std::arg(X[k](i,0))*180/M_PI);
+        }
+        ac_magnitude.push_back(qMakePair(magnitude,frequencies[k]));
+        ac_phase.push_back(qMakePair(phase,frequencies[k]));
+        if(repivoted[k]>0)
+            ac_stat.repivoted++;
+    }
+    ac_stat.points = count;
+    ac_stat.threads = pool ? pool->size() : 1;
+    ac_stat.elapsed = timer.elapsed();
+    qDebug()<<"ac sweep: "<<count<<" points in "<<ac_stat.elapsed<<" ms, "<<ac_stat.repivoted<<" needed new pivots";
+    return true;
+}
+const QVector< QPair<Matrix,double> >& Circuit::get_ac_magnitude()
+{
+    return ac_magnitude;
+}
+const QVector< QPair<Matrix,double> >& Circuit::get_ac_phase()
+{
+    return ac_phase;
+}
+const ac_report& Circuit::get_ac_report()
+{
+    return ac_stat;
+}
+void Circuit::accumulate_sensitivity(const Matrix &lambda,const Matrix &x,const Matrix *x_old,double timestep,double time,std::vector<double> &gradient)
+{
+    //gradient -= lambda^T dF/dp for one residual F = A0 x + E (x - x_old)/h + i_D(x) - u(time)
+    int k = 0;
+    auto node_difference = [](const Matrix &v,int node1,int node2){
+        return (node1<0 ? 0 : v(node1,0))-(node2<0 ? 0 : v(node2,0));
+    };
+    for(int i=0;i<allResistor.size();i++,k++){
+        int node1 = allResistor[i]->getNodeindex1()-1;
+        int node2 = allResistor[i]->getNodeindex2()-1;
+        double R = allResistor[i]->get_resistance();
+        gradient[k] += node_difference(x,node1,node2)*node_difference(lambda,node1,node2)/(R*R);
+    }
+    int c_offset = total_numofNode-1+allVoltage_source.size();
+    for(int i=0;i<allCapacitor.size();i++,k++){
+        if(!x_old)
+            continue;
+        int node1 = allCapacitor[i]->getNodeindex1()-1;
+        int node2 = allCapacitor[i]->getNodeindex2()-1;
+        double dv = node_difference(x,node1,node2)-node_difference(*x_old,node1,node2);
+        gradient[k] -= lambda(c_offset+i,0)*dv/timestep;
+    }
+    int l_offset = c_offset+allCapacitor.size();
+    for(int i=0;i<allInductor.size();i++,k++){
+        if(!x_old)
+            continue;
+        double di = x(l_offset+i,0)-(*x_old)(l_offset+i,0);
+        gradient[k] += lambda(l_offset+i,0)*di/timestep;
+    }
+    //sources, per unit of their dc value or of their waveform scale
+    int vs_offset = total_numofNode-1;
+    for(int i=0;i<allVoltage_source.size();i++,k++){
+        int node1 = allVoltage_source[i]->getNodeindex1()-1;
+        int node2 = allVoltage_source[i]->getNodeindex2()-1;
+        bool dc = allVoltage_source[i]->isDCsource();
+        if(!x_old && !dc)
+            continue;
+        double sign = (node2<0 && node1>=0) ? -1 : 1;
+        gradient[k] += lambda(vs_offset+i,0)*sign*(dc ? 1 : allVoltage_source[i]->get_voltage(time));
+    }
+    for(int i=0;i<allCurrent_source.size();i++,k++){
+        int node1 = allCurrent_source[i]->getNodeindex1()-1;
+        int node2 = allCurrent_source[i]->getNodeindex2()-1;
+        bool dc = allCurrent_source[i]->isDCsource();
+        if(!x_old && !dc)
+            continue;
+        //same incidence as the b stamps of update_A_b
+        double incidence = node1<0 ? lambda(node2,0) : node2<0 ? lambda(node1,0) : node_difference(lambda,node1,node2);
+        gradient[k] += incidence*(dc ? 1 : allCurrent_source[i]->get_current(time));
+    }
+    //controlled source gains, the stamps of ini_sys are linear in the gain
+    for(int i=0;i<allVCCS.size();i++,k++){
+        int node1 = allVCCS[i]->getNodeindex1()-1;
+        int node2 = allVCCS[i]->getNodeindex2()-1;
+        int s_node1 = getDependantNode(allVCCS[i]->getDependantNode1())-1;
+        int s_node2 = getDependantNode(allVCCS[i]->getDependantNode2())-1;
+        gradient[k] -= node_difference(x,s_node1,s_node2)*node_difference(lambda,node1,node2);
+    }
+    int vcvs_offset = l_offset+allInductor.size();
+    for(int i=0;i<allVCVS.size();i++,k++){
+        int s_node1 = getDependantNode(allVCVS[i]->getDependantNode1())-1;
+        int s_node2 = getDependantNode(allVCVS[i]->getDependantNode2())-1;
+        gradient[k] += lambda(vcvs_offset+i,0)*node_difference(x,s_node1,s_node2);
+    }
+    for(int i=0;i<allCCCS.size();i++,k++){
+        int node1 = allCCCS[i]->getNodeindex1()-1;
+        int node2 = allCCCS[i]->getNodeindex2()-1;
+        voltage_source* vs = dynamic_cast<voltage_source*>(getDependantBranch(allCCCS[i]->getDependantBranchName()));
+        if(!vs)
+            continue;
+        gradient[k] -= x(vs_offset+vs->get_num(),0)*node_difference(lambda,node1,node2);
+    }
+    int ccvs_offset = vcvs_offset+allVCVS.size();
+    for(int i=0;i<allCCVS.size();i++,k++){
+        voltage_source* vs = dynamic_cast<voltage_source*>(getDependantBranch(allCCVS[i]->getDependantBranchName()));
+        if(!vs)
+            continue;
+        gradient[k] += lambda(ccvs_offset+i,0)*x(vs_offset+vs->get_num(),0);
+    }
+}
+bool Circuit::sensitivity_analysis(int node,double t,double maxtimestep)
+{
+    sensitivity_stat = sensitivity_report();
+    sensitivity_stat.node = node;
+    sensitivity_stat.time = t;
+    newton_stat.clear();
+    Matrix x0 = dc_analysis();
+    bool dc_solved = dc_stat.stage!=dc_initial_condition;
+    ini_sys();
+    rom.valid = false;
+    if(state!=ok)
+        return false;
+    int n = sys.ini_A.get_row_num();
+    if(node<1 || node>=total_numofNode){
+        qDebug()<<"no node "<<node;
+        return false;
+    }
+    solutions.push_back(qMakePair(x0,0));
+    kept_jacobians.clear();
+    if(t>0){
+        double max_timestep = maxtimestep==-1 ? calculate_maxtimestep() : maxtimestep;
+        //without diodes the sweep below only refactors when the step size changes
+        keep_jacobians = allDiode.size()>0;
+        transient(0,t,t/200000,max_timestep,true);
+        keep_jacobians = false;
+    }
+    sensitivity_stat.output = solutions.back().first(node-1,0);
+    sensitivity_stat.steps = solutions.size()-1;
+
+    //one entry per parameter, in the order accumulate_sensitivity walks them
+    QVector<sensitivity_entry> table;
+    auto add = [&](Component* c,const QString &parameter,double value){
+        sensitivity_entry e;
+        e.component = c->getname();
+        e.parameter = parameter;
+        e.value = value;
+        table.push_back(e);
+    };
+    for(int i=0;i<allResistor.size();i++)
+        add(allResistor[i],"resistance",allResistor[i]->get_resistance());
+    for(int i=0;i<allCapacitor.size();i++)
+        add(allCapacitor[i],"capacitance",allCapacitor[i]->get_capacitance());
+    for(int i=0;i<allInductor.size();i++)
+        add(allInductor[i],"inductance",allInductor[i]->getInductance());
+    for(int i=0;i<allVoltage_source.size();i++){
+        bool dc = allVoltage_source[i]->isDCsource();
+        add(allVoltage_source[i],dc ? "value" : "scale",dc ? allVoltage_source[i]->get_voltage(0) : 1);
+    }
+    for(int i=0;i<allCurrent_source.size();i++){
+        bool dc = allCurrent_source[i]->isDCsource();
+        add(allCurrent_source[i],dc ? "value" : "scale",dc ? allCurrent_source[i]->get_current(0) : 1);
+    }
+    for(int i=0;i<allVCCS.size();i++)
+        add(allVCCS[i],"gain",allVCCS[i]->getCoefficient());
+    for(int i=0;i<allVCVS.size();i++)
+        add(allVCVS[i],"gain",allVCVS[i]->getCoefficient());
+    for(int i=0;i<allCCCS.size();i++)
+        add(allCCCS[i],"gain",allCCCS[i]->getCoefficient());
+    for(int i=0;i<allCCVS.size();i++)
+        add(allCCVS[i],"gain",allCCVS[i]->getCoefficient());
+    std::vector<double> gradient(table.size(),0);
+
+    //backward euler adjoint: J_k^T l_k = e_out at the last step, E^T l_(k+1)/h_(k+1) before it
+    std::vector<int> rows;
+    Matrix E = storage_matrix(rows);
+    Matrix Et = E.transpose();
+    Matrix rhs(n,1);
+    rhs.set_ij(node-1,0,1);
+    auto jacobian = [&](const Matrix &x,double h){
+        Matrix J = sys.ini_A;
+        if(h>0){
+            for(int i=0;i<n;i++){
+                for(int j=0;j<n;j++){
+                    if(E(i,j)!=0)
+                        J.add_ij(i,j,E(i,j)/h);
+                }
+            }
+        }
+        stamp_diode_conductance(J,x);
+        return J;
+    };
+    //the kept factors belong to newton's last iterate, refinement against J^T at the accepted state closes the gap
+    auto solve_kept = [&](const Matrix &J,const LU_factor &f,Matrix &lambda){
+        lambda = Matrix::lu_solve_transposed(f,rhs);
+        double last = INFINITY;
+        for(int s=0;s<10;s++){
+            Matrix r(n,1);
+            for(int i=0;i<n;i++){
+                double v = rhs(i,0);
+                for(int j=0;j<n;j++)
+                    v -= J(j,i)*lambda(j,0);
+                r.set_ij(i,0,v);
+            }
+            Matrix d = Matrix::lu_solve_transposed(f,r);
+            double d_norm = 0,l_norm = 0;
+            for(int i=0;i<n;i++){
+                lambda.add_ij(i,0,d(i,0));
+                d_norm = std::max(d_norm,fabs(d(i,0)));
+                l_norm = std::max(l_norm,fabs(lambda(i,0)));
+            }
+            sensitivity_stat.refinement_steps++;
+            if(d_norm<=1e-13*l_norm)
+                return true;
+            if(d_norm>0.5*last)
+                return false;
+            last = d_norm;
+        }
+        return false;
+    };
+    LU_factor adjoint_lu;
+    double adjoint_timestep = 0;
+    for(int k=solutions.size()-1;k>=1;k--){
+        const Matrix &x = solutions[k].first;
+        const Matrix &x_old = solutions[k-1].first;
+        double h = solutions[k].second-solutions[k-1].second;
+        if(h<=0)
+            continue;
+        Matrix lambda;
+        bool solved = false;
+        if(k-1<kept_jacobians.size() && !kept_jacobians[k-1].singular){
+            solved = solve_kept(jacobian(x,h),kept_jacobians[k-1],lambda);
+            if(solved)
+                sensitivity_stat.reused_factorizations++;
+        }
+        //without diodes the jacobian only changes with the step size
+        if(!solved && (allDiode.size()>0 || adjoint_lu.singular || h!=adjoint_timestep)){
+            adjoint_lu = jacobian(x,h).lu_factorize();
+            adjoint_timestep = h;
+            sensitivity_stat.factorizations++;
+            if(adjoint_lu.singular){
+                qDebug()<<"singular jacobian in the adjoint sweep";
+                kept_jacobians.clear();
+                return false;
+            }
+        }
+        if(!solved)
+            lambda = Matrix::lu_solve_transposed(adjoint_lu,rhs);
+        sensitivity_stat.adjoint_solves++;
+        accumulate_sensitivity(lambda,x,&x_old,h,solutions[k-1].second,gradient);
+        rhs = Et*lambda*(1/h);
+    }
+    kept_jacobians.clear();
+    //the initial state is the operating point, which moves with the parameters too
+    if(dc_solved){
+        LU_factor dc_lu = jacobian(x0,0).lu_factorize();
+        sensitivity_stat.factorizations++;
+        if(dc_lu.singular){
+            qDebug()<<"singular dc jacobian, initial state kept fixed";
+        }else{
+            Matrix lambda = Matrix::lu_solve_transposed(dc_lu,rhs);
+            sensitivity_stat.adjoint_solves++;
+            accumulate_sensitivity(lambda,x0,nullptr,0,0,gradient);
+        }
+    }
+
+    for(int i=0;i<table.size();i++){
+        table[i].derivative = gradient[i];
+        table[i].normalized = gradient[i]*table[i].value;
+    }
+    std::stable_sort(table.begin(),table.end(),[](const sensitivity_entry &a,const sensitivity_entry &b){
+        return fabs(a.normalized)>fabs(b.normalized);
+    });
+    sensitivity_stat.table = table;
+    sensitivity_stat.valid = true;
+    qDebug()<<"sensitivity of node "<<node<<" at t = "<<t<<": "<<sensitivity_stat.output;
+    qDebug()<<sensitivity_stat.factorizations<<" factorizations, "<<sensitivity_stat.reused_factorizations<<" steps on the forward factors ("<<sensitivity_stat.refinement_steps<<" refinement steps)";
+    for(int i=0;i<table.size();i++)
+        qDebug()<<table[i].component<<" "<<table[i].parameter<<" "<<table[i].value<<": d/dp "<<table[i].derivative<<", p*d/dp "<<table[i].normalized;
+    return true;
+}
+const sensitivity_report& Circuit::get_sensitivity_report()
+{
+    return sensitivity_stat;
+}
+double Circuit::calculate_maxtimestep()
+{
+    double ans = INT32_MAX;
+    for(int i=0;i<allVoltage_source.size();i++){
+        if(!allVoltage_source[i]->isDCsource()){
+            qDebug()<<1/allVoltage_source[i]->getFrequency();
+            ans = std::min(ans,1/allVoltage_source[i]->getFrequency());
+        }
+    }
+    for(int i=0;i<allCurrent_source.size();i++){
+        if(!allCurrent_source[i]->isDCsource()){
+            ans = std::min(ans,1/allCurrent_source[i]->getFrequency());
+        }
+    }
+    for(int i=0;i<allCapacitor.size();i++){
+        for(int j=0;j<allInductor.size();j++){
+            ans = std::min(ans,sqrt(allCapacitor[i]->get_capacitance()*allInductor[i]->getInductance())/(2*M_PI));
+        }
+    }
+    return ans/10;
+}
+Matrix Circuit::dc_analysis()
+{
+    if(state!=ok){
+        qDebug()<<"There is something wrong @@";
+        return Matrix(1,1,0);
+    }
+    Matrix A;
+    Matrix b;
+    bool no_dc = build_dc_system(A,b);
+    Matrix last_state(A.get_row_num(),1,0);
+    for(int i=0;i<initial_condition.size();i++){
+        if(initial_condition[i].first != 0)
+            last_state.set_ij(initial_condition[i].first-1,0,initial_condition[i].second);
+    }
+    if(no_dc && initial_condition.size()){
+        dc_stat = dc_report();
+        dc_stat.stage = dc_initial_condition;
+        return last_state;
+    }
+    return dc_operating_point(A,b,last_state);
+}
+bool Circuit::build_dc_system(Matrix &A,Matrix &b)
+{
+    //capacitors open, inductors shorted, only dc sources drive b; true if there is none
+    bool no_dc = true;
+    int num_of_unknown = total_numofNode-1;//without ground
+    num_of_unknown += allVoltage_source.size();
+    num_of_unknown += allCapacitor.size();
+    num_of_unknown += allInductor.size();
+    num_of_unknown += allVCVS.size();
+    num_of_unknown += allCCVS.size();
+
+    A = Matrix(num_of_unknown,num_of_unknown,0);
+    b = Matrix(num_of_unknown,1,0);
+    //resistor stamps
+
+    int matrix_offset=0;
+    for(int i=0;i<allResistor.size();i++){
+        int node1 = allResistor[i]->getNodeindex1()-1;
+        int node2 = allResistor[i]->getNodeindex2()-1;
+        double conductance = 1/allResistor[i]->get_resistance();
+        if(node1<0&&node2<0){
+            continue;
+        }else if(node1<0){
+            A.add_ij(node2,node2,conductance);
+        }else if(node2<0){
+            A.add_ij(node1,node1,conductance);
+        }else{
             //qDebug()<<node1<<" "<<node2;
             A.add_ij(node1,node1,conductance);
             A.add_ij(node2,node2,conductance);
@@ -782,7 +2764,7 @@ Matrix Circuit::dc_analysis()
         }
 
     }
-    //current_source stamps
+    //current_source stamps, only dc sources drive the operating point
     for(int i=0;i<allCurrent_source.size();i++){
         if(!allCurrent_source[i]->isDCsource())
             continue;
@@ -818,8 +2800,8 @@ Matrix Circuit::dc_analysis()
             A.add_ij(node2,matrix_offset+i,1);
             b.add_ij(matrix_offset+i,0,voltage);
         }else if(node2<0){
-            A.add_ij(matrix_offset+i,node2,1);
-            A.add_ij(node2,matrix_offset+i,1);
+            A.add_ij(matrix_offset+i,node1,1);
+            A.add_ij(node1,matrix_offset+i,1);
             b.add_ij(matrix_offset+i,0,-voltage);
         }else{
             A.add_ij(matrix_offset+i,node2,1);
@@ -830,13 +2812,6 @@ Matrix Circuit::dc_analysis()
         }
     }
 
-    for(int i=0;i<initial_condition.size();i++){
-        if(initial_condition[i].first != 0)
-            last_state.set_ij(initial_condition[i].first-1,0,initial_condition[i].second);
-    }
-    if(no_dc){
-        return last_state;
-    }
     //capacitor stamps
     matrix_offset = total_numofNode-1+allVoltage_source.size();
     for(int i=0;i<allCapacitor.size();i++){
@@ -1010,162 +2985,906 @@ Matrix Circuit::dc_analysis()
         }
         A.add_ij(matrix_offset+i,matrix_offsetCCVS+vs_num,-G);
     }
-    for(int i=0;i<allDiode.size();i++){
-        int node1 = allDiode[i]->getNodeindex1()-1; // 1 --|>-- 2
-        int node2 = allDiode[i]->getNodeindex2()-1;
-        double Isat = allDiode[i]->get_Isat();
-        double Vd = last_state(node1,0)-last_state(node2,0);
-        double v_on = 0.025*log(0.025/(sqrt(2)*allDiode[i]->get_Isat()));
-        if(Vd<v_on)
-            continue;
-        double G = 40*Isat*exp(40*Vd);
-        //double Io = (exp(40*Vd)-1) - G*Vd;
-        if(node1<0&&node2<0){
-            continue;
-        }else if(node1<0){
-            A.add_ij(node2,node2,G);
-            //b.add_ij(node2,0,Io);
-
-        }else if(node2<0){
-            A.add_ij(node1,node1,G);
-            //b.add_ij(node1,0,-Io);
-        }else{
-            A.add_ij(node1,node1,G);
-            A.add_ij(node1,node2,-G);
-            A.add_ij(node2,node1,-G);
-            A.add_ij(node2,node2,G);
-           // b.add_ij(node1,0,-Io);
-           // b.add_ij(node2,0,Io);
+    return no_dc;
+}
+bool Circuit::solve_dc_newton(const Matrix &A,const Matrix &b,Matrix &x,double gmin,QElapsedTimer &timer,int &iterations)
+{
+    //companion model newton with junction limiting, gmin from every node to ground
+    const double vt = 0.025;
+    const double junction_gmin = 1e-12;
+    int n = A.get_row_num();
+    QVector<double> vd(allDiode.size());
+    for(int i=0;i<allDiode.size();i++)
+        vd[i] = x(allDiode[i]->getNodeindex1()-1,0)-x(allDiode[i]->getNodeindex2()-1,0);
+
+    for(int iter=0;iter<100;iter++){
+        if(timer.elapsed()>dc_stage_budget)
+            return false;
+        Matrix G = A;
+        Matrix rhs = b;
+        for(int i=0;i<total_numofNode-1;i++)
+            G.add_ij(i,i,gmin);
+        for(int i=0;i<allDiode.size();i++){
+            int node1 = allDiode[i]->getNodeindex1()-1; // 1 --|>-- 2
+            int node2 = allDiode[i]->getNodeindex2()-1;
+            double Isat = allDiode[i]->get_Isat();
+            double Id = 0;
+            double Gd = junction_gmin;
+            if(vd[i]>0){
+                Id = Isat*(exp(40*vd[i])-1);
+                Gd += 40*Isat*exp(40*vd[i]);
+            }
+            double Ieq = Id+junction_gmin*vd[i]-Gd*vd[i];
+            if(node1>=0){
+                G.add_ij(node1,node1,Gd);
+                rhs.add_ij(node1,0,-Ieq);
+            }
+            if(node2>=0){
+                G.add_ij(node2,node2,Gd);
+                rhs.add_ij(node2,0,Ieq);
+            }
+            if(node1>=0&&node2>=0){
+                G.add_ij(node1,node2,-Gd);
+                G.add_ij(node2,node1,-Gd);
+            }
+        }
+        LU_factor lu = G.lu_factorize();
+        iterations++;
+        if(lu.singular)
+            return false;
+        Matrix next = Matrix::lu_solve(lu,rhs);
+
+        bool converged = true;
+        for(int i=0;i<n;i++){
+            double d = fabs(next(i,0)-x(i,0));
+            if(!std::isfinite(next(i,0)))
+                return false;
+            if(d>1e-6+1e-3*fabs(next(i,0)))
+                converged = false;
+        }
+        for(int i=0;i<allDiode.size();i++){
+            double vnew = next(allDiode[i]->getNodeindex1()-1,0)-next(allDiode[i]->getNodeindex2()-1,0);
+            double vcrit = vt*log(vt/(sqrt(2)*allDiode[i]->get_Isat()));
+            if(vnew>vcrit && fabs(vnew-vd[i])>2*vt){
+                if(vd[i]>0){
+                    double arg = 1+(vnew-vd[i])/vt;
+                    vnew = arg>0 ? vd[i]+vt*log(arg) : vcrit;
+                }else{
+                    vnew = vt*log(vnew/vt);
+                }
+                converged = false;
+            }
+            vd[i] = vnew;
         }
+        x = next;
+        if(converged)
+            return true;
+    }
+    return false;
+}
+Matrix Circuit::dc_operating_point(const Matrix &A,const Matrix &b,const Matrix &guess)
+{
+    dc_stat = dc_report();
+    QElapsedTimer timer;
+    Matrix x = guess;
+
+    //plain newton
+    timer.start();
+    if(solve_dc_newton(A,b,x,0,timer,dc_stat.iterations[0]))
+        dc_stat.stage = dc_newton;
+    dc_stat.elapsed[0] = timer.elapsed();
+
+    //gmin stepping, shrink the shunt conductance while the solution follows
+    if(dc_stat.stage == dc_failed){
+        timer.start();
+        x = guess;
+        double gmin = 1e-2;
+        double factor = 10;
+        Matrix last_good = x;
+        bool ok = solve_dc_newton(A,b,x,gmin,timer,dc_stat.iterations[1]);
+        while(ok && factor>1.01){
+            if(gmin<1e-12){
+                if(solve_dc_newton(A,b,x,0,timer,dc_stat.iterations[1]))
+                    dc_stat.stage = dc_gmin_stepping;
+                //gmin cannot go lower, stepping it again would only repeat this solve, leave it to source stepping
+                break;
+            }
+            last_good = x;
+            if(solve_dc_newton(A,b,x,gmin/factor,timer,dc_stat.iterations[1])){
+                gmin /= factor;
+            }else{
+                x = last_good;
+                factor = sqrt(factor);
+            }
+            if(timer.elapsed()>dc_stage_budget)
+                break;
+        }
+        dc_stat.elapsed[1] = timer.elapsed();
     }
 
+    //source stepping, ramp every independent source from zero
+    if(dc_stat.stage == dc_failed){
+        timer.start();
+        x = Matrix(A.get_row_num(),1);
+        double lambda = 0;
+        double step = 0.1;
+        Matrix last_good = x;
+        while(step>1e-4 && timer.elapsed()<=dc_stage_budget){
+            double next_lambda = std::min(1.0,lambda+step);
+            Matrix scaled = b;
+            scaled = scaled*next_lambda;
+            if(solve_dc_newton(A,scaled,x,0,timer,dc_stat.iterations[2])){
+                lambda = next_lambda;
+                last_good = x;
+                step *= 1.5;
+                if(lambda>=1){
+                    dc_stat.stage = dc_source_stepping;
+                    break;
+                }
+            }else{
+                x = last_good;
+                step /= 2;
+            }
+        }
+        dc_stat.elapsed[2] = timer.elapsed();
+    }
 
-
-    A.debug();
-    b.debug();
-    Matrix test = A.solve_gauss_elimination(b);
-    A.debug();
-    b.debug();
-    //Matrix ans = A.solve(b);
-    //Matrix test = A.solve_gauss_elimination(b);
-
-    //qDebug()<<"ans";
-    //ans.debug();
-    //qDebug()<<"test";
-    //test.debug();
-
-    return test;
+    const char* stage_name[] = {"failed","newton","gmin stepping","source stepping"};
+    qDebug()<<"dc operating point: "<<stage_name[dc_stat.stage];
+    qDebug()<<"iterations newton/gmin/source: "<<dc_stat.iterations[0]<<dc_stat.iterations[1]<<dc_stat.iterations[2];
+    qDebug()<<"time (ms) newton/gmin/source: "<<dc_stat.elapsed[0]<<dc_stat.elapsed[1]<<dc_stat.elapsed[2];
+    if(dc_stat.stage == dc_failed){
+        state = no_solution;
+        return guess;
+    }
+    return x;
 }
-void Circuit::update_A_b(Matrix &A,Matrix &b,Matrix last_state,double timestep,double current_time)
+void Circuit::set_dc_time_budget(double ms)
 {
-    int matrix_offset=0;
-    A = sys.ini_A;
-    b.setall(0);
-    //current_source stamps
-    for(int i=0;i<allCurrent_source.size();i++){
-        int node1 = allCurrent_source[i]->getNodeindex1()-1; // 1->2
-        int node2 = allCurrent_source[i]->getNodeindex2()-1;
-        double current = allCurrent_source[i]->get_current(current_time);
-        if(node1<0&&node2<0){
+    dc_stage_budget = ms;
+}
+const dc_report& Circuit::get_dc_report()
+{
+    return dc_stat;
+}
+bool Circuit::dc_sweep(QString component,double start,double stop,int points)
+{
+    dc_sweep_stat = dc_sweep_report();
+    dc_sweep_solutions.clear();
+    if(state!=ok || points<2 || start==stop){
+        qDebug()<<"bad dc sweep";
+        return false;
+    }
+    Matrix A0;
+    Matrix b0;
+    build_dc_system(A0,b0);
+    int n = A0.get_row_num();
+
+    //the swept value enters linearly: b = b0 + (p-nominal)*source or A = A0 + (1/p-1/nominal)*stamp
+    Matrix source(n,1);
+    double nominal = 0;
+    int r_node1 = -1;
+    int r_node2 = -1;
+    bool is_source = false;
+    bool found = false;
+    for(int i=0;i<allResistor.size() && !found;i++){
+        if(allResistor[i]->getname()!=component)
             continue;
-        }else if(node1<0){
-            b.add_ij(node2,0,current);
-        }else if(node2<0){
-            b.add_ij(node1,0,current);
+        found = true;
+        r_node1 = allResistor[i]->getNodeindex1()-1;
+        r_node2 = allResistor[i]->getNodeindex2()-1;
+        nominal = allResistor[i]->get_resistance();
+    }
+    for(int i=0;i<allVoltage_source.size() && !found;i++){
+        if(allVoltage_source[i]->getname()!=component)
+            continue;
+        found = true;
+        is_source = true;
+        nominal = allVoltage_source[i]->isDCsource() ? allVoltage_source[i]->get_voltage(0) : 0;
+    }
+    for(int i=0;i<allCurrent_source.size() && !found;i++){
+        if(allCurrent_source[i]->getname()!=component)
+            continue;
+        found = true;
+        is_source = true;
+        nominal = allCurrent_source[i]->isDCsource() ? allCurrent_source[i]->get_current(0) : 0;
+    }
+    if(is_source)
+        get_excitation(component,source);
+    if(!found){
+        qDebug()<<"no resistor or independent source named "<<component;
+        return false;
+    }
+    if(!is_source && (start<=0 || stop<=0)){
+        qDebug()<<"swept resistance must stay positive";
+        return false;
+    }
+    auto system = [&](double p,Matrix &A,Matrix &b){
+        A = A0;
+        b = b0;
+        if(is_source){
+            for(int i=0;i<n;i++){
+                if(source(i,0)!=0)
+                    b.add_ij(i,0,(p-nominal)*source(i,0));
+            }
         }else{
-            b.add_ij(node1,0,current);
-            b.add_ij(node2,0,-current);
+            double dg = 1/p-1/nominal;
+            A.add_ij(r_node1,r_node1,dg);
+            A.add_ij(r_node2,r_node2,dg);
+            if(r_node1>=0 && r_node2>=0){
+                A.add_ij(r_node1,r_node2,-dg);
+                A.add_ij(r_node2,r_node1,-dg);
+            }
+        }
+    };
+
+    QElapsedTimer total;
+    total.start();
+    double grid = (stop-start)/(points-1);
+    dc_sweep_stat.points = points;
+    Matrix A;
+    Matrix b;
+
+    //linear circuit and a source sweep: one factorization, every point is a new right hand side
+    if(allDiode.size()==0 && is_source){
+        system(start,A,b);
+        LU_factor lu = A.lu_factorize();
+        dc_sweep_stat.factorizations++;
+        if(lu.singular){
+            qDebug()<<"singular dc matrix";
+            return false;
+        }
+        for(int k=0;k<points;k++){
+            double p = k==points-1 ? stop : start+k*grid;
+            system(p,A,b);
+            dc_sweep_solutions.push_back(qMakePair(Matrix::lu_solve(lu,b),p));
         }
+        dc_sweep_stat.steps = points;
+        dc_sweep_stat.completed = true;
+        dc_sweep_stat.elapsed = total.elapsed();
+        return true;
     }
-    //voltage_source stamps
-    matrix_offset = total_numofNode-1;
-    for(int i=0;i<allVoltage_source.size();i++){
-        int node1 = allVoltage_source[i]->getNodeindex1()-1; //-
-        int node2 = allVoltage_source[i]->getNodeindex2()-1; //+
-        double voltage = allVoltage_source[i]->get_voltage(current_time);
 
-        if(node1<0&&node2<0){
+    //continuation: newton starts from the line through the last two points,
+    //a prediction that misses by more than predictor_tolerance halves the step
+    const double predictor_tolerance = 0.05;
+    const int max_iterations = 10;
+    double min_step = fabs(grid)/1024;
+    system(start,A,b);
+    Matrix x = dc_operating_point(A,b,Matrix(n,1));
+    dc_sweep_stat.cold_starts++;
+    if(state!=ok)
+        return false;
+    dc_sweep_solutions.push_back(qMakePair(x,start));
+    dc_sweep_stat.steps++;
+    Matrix x_prev;
+    double p = start;
+    double p_prev = start;
+    bool have_prev = false;
+    double step = grid;
+    int next_grid = 1;
+    while(next_grid<points){
+        double target = next_grid==points-1 ? stop : start+next_grid*grid;
+        bool predicted = have_prev;
+        double h = step;
+        bool on_grid = fabs(p+h-start)>=fabs(target-start)-1e-9*fabs(grid);
+        if(on_grid)
+            h = target-p;
+        Matrix guess = x;
+        if(have_prev){
+            Matrix slope = x-x_prev;
+            guess = x+slope*(h/(p-p_prev));
+        }
+        system(p+h,A,b);
+        Matrix trial = guess;
+        QElapsedTimer timer;
+        timer.start();
+        int iterations = 0;
+        bool converged = solve_dc_newton(A,b,trial,0,timer,iterations) && iterations<=max_iterations;
+        dc_sweep_stat.newton_iterations += iterations;
+        dc_sweep_stat.factorizations += iterations;
+        double miss = converged ? Matrix::calculate_maxVdifference(trial,guess) : INFINITY;
+        if((!converged || (predicted && miss>predictor_tolerance)) && fabs(h)>min_step){
+            dc_sweep_stat.rejected++;
+            step = h/2;
             continue;
-        }else if(node1<0){
-            b.add_ij(matrix_offset+i,0,voltage);
-        }else if(node2<0){
-            b.add_ij(matrix_offset+i,0,-voltage);
+        }
+        if(!converged){
+            //no step is small enough, fall back to the homotopy solver from the last point
+            trial = dc_operating_point(A,b,x);
+            dc_sweep_stat.cold_starts++;
+            if(state!=ok){
+                dc_sweep_stat.elapsed = total.elapsed();
+                return false;
+            }
+        }
+        x_prev = x;
+        p_prev = p;
+        have_prev = true;
+        x = trial;
+        p = on_grid ? target : p+h;
+        dc_sweep_stat.steps++;
+        //refinement steps only carry the continuation, row k stays start+k*grid
+        if(on_grid){
+            next_grid++;
+            dc_sweep_solutions.push_back(qMakePair(x,p));
         }else{
-            b.add_ij(matrix_offset+i,0,voltage);
+            dc_sweep_stat.refinement_steps++;
         }
+        if(predicted && miss<predictor_tolerance/4)
+            step = fabs(2*step)<fabs(grid) ? 2*step : grid;
     }
-    //capacitor stamps
-    matrix_offset = total_numofNode-1+allVoltage_source.size();
-    for(int i=0;i<allCapacitor.size();i++){
-        int node1 = allCapacitor[i]->getNodeindex1()-1;
-        int node2 = allCapacitor[i]->getNodeindex2()-1;
-        double capacitance = allCapacitor[i]->get_capacitance();
-        if(node1<0&&node2<0){
+    dc_sweep_stat.completed = true;
+    dc_sweep_stat.elapsed = total.elapsed();
+    qDebug()<<"dc sweep of "<<component<<": "<<dc_sweep_stat.steps<<" points for "<<points<<" requested, "<<dc_sweep_stat.rejected<<" rejected, "<<dc_sweep_stat.newton_iterations<<" newton iterations";
+    return true;
+}
+const QVector< QPair<Matrix,double> >& Circuit::get_dc_sweep()
+{
+    return dc_sweep_solutions;
+}
+const dc_sweep_report& Circuit::get_dc_sweep_report()
+{
+    return dc_sweep_stat;
+}
+QPair<int,int> Circuit::find_valued_component(const QString &name)
+{
+    for(int i=0;i<allResistor.size();i++)
+        if(allResistor[i]->getname()==name)
+            return qMakePair(int(valued_resistor),i);
+    for(int i=0;i<allCapacitor.size();i++)
+        if(allCapacitor[i]->getname()==name)
+            return qMakePair(int(valued_capacitor),i);
+    for(int i=0;i<allInductor.size();i++)
+        if(allInductor[i]->getname()==name)
+            return qMakePair(int(valued_inductor),i);
+    for(int i=0;i<allVoltage_source.size();i++)
+        if(allVoltage_source[i]->getname()==name)
+            return qMakePair(int(valued_voltage_source),i);
+    for(int i=0;i<allCurrent_source.size();i++)
+        if(allCurrent_source[i]->getname()==name)
+            return qMakePair(int(valued_current_source),i);
+    qDebug()<<"no resistor, capacitor, inductor or independent source named "<<name;
+    return qMakePair(-1,-1);
+}
+double Circuit::component_value(const QPair<int,int> &target)
+{
+    int i = target.second;
+    switch(target.first){
+        case valued_resistor: return allResistor[i]->get_resistance();
+        case valued_capacitor: return allCapacitor[i]->get_capacitance();
+        case valued_inductor: return allInductor[i]->getInductance();
+        case valued_voltage_source: return allVoltage_source[i]->get_amplitude();
+        case valued_current_source: return allCurrent_source[i]->get_amplitude();
+    }
+    return 0;
+}
+void Circuit::set_component_value(const QPair<int,int> &target,double value)
+{
+    int i = target.second;
+    switch(target.first){
+        case valued_resistor: allResistor[i]->set_resistance(value); break;
+        case valued_capacitor: allCapacitor[i]->set_capacitance(value); break;
+        case valued_inductor: allInductor[i]->setInductance(value); break;
+        case valued_voltage_source: allVoltage_source[i]->set_amplitude(value); break;
+        case valued_current_source: allCurrent_source[i]->set_amplitude(value); break;
+    }
+}
+Circuit* Circuit::private_copy(const QVector<QPair<int,int>> &targets,QVector<Component*> &made)
+{
+    //solver copies share the components, the ones whose values change get private copies
+    Circuit* c = solver_copy();
+    for(int k=0;k<targets.size();k++){
+        int i = targets[k].second;
+        Component* original = nullptr;
+        Component* copy = nullptr;
+        switch(targets[k].first){
+            case valued_resistor:
+                original = allResistor[i];
+                if(c->allResistor[i]==original)
+                    copy = c->allResistor[i] = allResistor[i]->solver_copy();
+                break;
+            case valued_capacitor:
+                original = allCapacitor[i];
+                if(c->allCapacitor[i]==original)
+                    copy = c->allCapacitor[i] = allCapacitor[i]->solver_copy();
+                break;
+            case valued_inductor:
+                original = allInductor[i];
+                if(c->allInductor[i]==original)
+                    copy = c->allInductor[i] = allInductor[i]->solver_copy();
+                break;
+            case valued_voltage_source:
+                original = allVoltage_source[i];
+                if(c->allVoltage_source[i]==original)
+                    copy = c->allVoltage_source[i] = allVoltage_source[i]->solver_copy();
+                break;
+            case valued_current_source:
+                original = allCurrent_source[i];
+                if(c->allCurrent_source[i]==original)
+                    copy = c->allCurrent_source[i] = allCurrent_source[i]->solver_copy();
+                break;
+        }
+        if(!copy)
             continue;
-        }else if(node1<0){
-            A.add_ij(matrix_offset+i,node2,-capacitance/timestep);
-            b.add_ij(matrix_offset+i,0, capacitance * (-last_state(node2,0)) /timestep);
-        }else if(node2<0){
-            A.add_ij(matrix_offset+i,node1,capacitance/timestep);
-            b.add_ij(matrix_offset+i,0,capacitance * (last_state(node1,0)) /timestep);
-        }else{
-            A.add_ij(matrix_offset+i,node1,capacitance/timestep);
-            A.add_ij(matrix_offset+i,node2,-capacitance/timestep);
-            b.add_ij(matrix_offset+i,0,capacitance*(last_state(node1,0)-last_state(node2,0))/timestep);
+        //dependent sources find their branch by name in allComponent
+        int j = c->allComponent.indexOf(original);
+        if(j>=0)
+            c->allComponent[j] = copy;
+        made.push_back(copy);
+    }
+    return c;
+}
+int Circuit::run_on_copies(int n,const QVector<QPair<int,int>> &targets,const std::function<void(Circuit*,int)> &run)
+{
+    //a copy is taken from the idle list for every chunk and given back after it, so there are never more than the runs in flight
+    std::mutex lock;
+    QVector<Circuit*> copies;
+    QVector<Circuit*> idle;
+    QVector<Component*> made;
+    std::function<void(int,int)> body = [&](int begin,int end){
+        Circuit* c = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if(!idle.isEmpty()){
+                c = idle.back();
+                idle.pop_back();
+            }
+        }
+        if(!c){
+            QVector<Component*> parts;
+            c = private_copy(targets,parts);
+            std::lock_guard<std::mutex> guard(lock);
+            copies.push_back(c);
+            for(int k=0;k<parts.size();k++)
+                made.push_back(parts[k]);
+        }
+        for(int r=begin;r<end;r++)
+            run(c,r);
+        std::lock_guard<std::mutex> guard(lock);
+        idle.push_back(c);
+    };
+    //one run per chunk, the pool's shared chunk counter keeps every worker busy while run lengths differ
+    if(pool)
+        pool->parallel_for(n,1,body);
+    else
+        body(0,n);
+    int count = copies.size();
+    for(int i=0;i<copies.size();i++)
+        delete copies[i];
+    for(int i=0;i<made.size();i++)
+        delete made[i];
+    return count;
+}
+bool Circuit::step_analysis(const QVector<step_parameter> &steps,double t,double maxtimestep)
+{
+    step_runs.clear();
+    step_stat = step_report();
+    if(state!=ok || steps.isEmpty() || t<=0)
+        return false;
+    QVector<QPair<int,int>> targets;
+    int runs = 1;
+    for(const step_parameter &p : steps){
+        QPair<int,int> target = find_valued_component(p.component);
+        if(target.first<0)
+            return false;
+        if(p.points<1 || (target.first<=valued_inductor && (p.start<=0 || p.stop<=0))){
+            qDebug()<<"bad step range for "<<p.component;
+            return false;
+        }
+        targets.push_back(target);
+        runs *= p.points;
+    }
+    //the last parameter changes fastest
+    step_runs.resize(runs);
+    for(int r=0;r<runs;r++){
+        step_runs[r].values.resize(steps.size());
+        int rest = r;
+        for(int k=steps.size()-1;k>=0;k--){
+            int points = steps[k].points;
+            int digit = rest%points;
+            rest /= points;
+            step_runs[r].values[k] = points==1 ? steps[k].start : steps[k].start+(steps[k].stop-steps[k].start)*digit/(points-1);
         }
-
-
     }
 
-    //inductor stamps
-    matrix_offset = total_numofNode-1+allVoltage_source.size()+allCapacitor.size();
-    for(int i=0;i<allInductor.size();i++){
-        int node1 = allInductor[i]->getNodeindex1()-1;
-        int node2 = allInductor[i]->getNodeindex2()-1;
-        double inductance = allInductor[i]->getInductance();
-        if(node1<0&&node2<0){
-            continue;
-        }else if(node1<0){
-            A.add_ij(matrix_offset+i,matrix_offset+i,-inductance/timestep);
-            b.add_ij(matrix_offset+i,0,-inductance*last_state(matrix_offset+i,0)/timestep);
-
-        }else if(node2<0){
-            A.add_ij(matrix_offset+i,matrix_offset+i,-inductance/timestep);
-            b.add_ij(matrix_offset+i,0,-inductance*last_state(matrix_offset+i,0)/timestep);
+    std::vector<double> run_time(runs,0);
+    QElapsedTimer total;
+    total.start();
+    step_stat.copies = run_on_copies(runs,targets,[&](Circuit* c,int r){
+        QElapsedTimer timer;
+        timer.start();
+        for(int k=0;k<targets.size();k++)
+            c->set_component_value(targets[k],step_runs[r].values[k]);
+        c->state = ok;
+        c->analysis(t,maxtimestep);
+        bool finite = c->state==ok && c->solutions.size()>1;
+        if(finite){
+            const Matrix &last = c->solutions.back().first;
+            for(int i=0;i<last.get_row_num();i++)
+                finite = finite && std::isfinite(last(i,0));
+        }
+        step_runs[r].completed = finite;
+        step_runs[r].solutions = c->solutions;
+        run_time[r] = timer.elapsed();
+    });
+    step_stat.elapsed = total.elapsed();
+    step_stat.runs = runs;
+    step_stat.threads = pool ? pool->size() : 1;
+    for(int r=0;r<runs;r++){
+        step_stat.run_time += run_time[r];
+        if(step_runs[r].completed)
+            step_stat.completed++;
+    }
+    qDebug()<<"step: "<<step_stat.completed<<" of "<<runs<<" runs on "<<step_stat.threads<<" threads, "<<step_stat.copies<<" circuit copies, "<<step_stat.elapsed<<" ms ("<<step_stat.run_time<<" ms of runs)";
+    return step_stat.completed==runs;
+}
+//splitmix64 seeded by the trial number, so a trial draws the same values whatever thread runs it
+struct trial_random{
+    unsigned long long state;
+    static unsigned long long mix(unsigned long long z){
+        z = (z^(z>>30))*0xbf58476d1ce4e5b9ULL;
+        z = (z^(z>>27))*0x94d049bb133111ebULL;
+        return z^(z>>31);
+    }
+    trial_random(unsigned seed,int trial){
+        //seed and trial are mixed one after the other, a linear start would make
+        //(seed+1,trial) the stream of (seed,trial) one draw later
+        state = mix(mix(seed+0x9e3779b97f4a7c15ULL)^(unsigned long long)trial);
+    }
+    unsigned long long next(){
+        return mix(state += 0x9e3779b97f4a7c15ULL);
+    }
+    double uniform(){//[0,1)
+        return (next()>>11)*(1.0/9007199254740992.0);
+    }
+    double gaussian(){//box-muller
+        double u = 1-uniform();
+        return sqrt(-2*log(u))*cos(2*M_PI*uniform());
+    }
+};
+bool Circuit::monte_carlo_analysis(const QVector<tolerance_spec> &tolerances,const QVector<monte_carlo_probe> &probes,int trials,double t,double maxtimestep,unsigned seed,int bins)
+{
+    monte_carlo_stat = monte_carlo_report();
+    monte_carlo_stat.seed = seed;
+    if(state!=ok || trials<1 || probes.isEmpty())
+        return false;
+    QVector<QPair<int,int>> targets;
+    QVector<double> nominal;
+    for(const tolerance_spec &spec : tolerances){
+        QPair<int,int> target = find_valued_component(spec.component);
+        if(target.first<0)
+            return false;
+        if(spec.tolerance<0 || (target.first<=valued_inductor && spec.tolerance>=1)){
+            qDebug()<<"bad tolerance for "<<spec.component;
+            return false;
+        }
+        targets.push_back(target);
+        nominal.push_back(component_value(target));
+    }
+    for(const monte_carlo_probe &probe : probes){
+        if(probe.node<1 || probe.node>=total_numofNode){
+            qDebug()<<"no node "<<probe.node;
+            return false;
+        }
+    }
+    QElapsedTimer total;
+    total.start();
+
+    //the topology is the same in every trial: the structural matching is already in pivot_order,
+    //the ordering and solver path of the transient matrix are found once here
+    matrix_structure pattern;
+    if(t>0 && structured_solver && allDiode.size()==0){
+        Matrix x0 = dc_analysis();
+        ini_sys();
+        double h = maxtimestep==-1 ? calculate_maxtimestep() : maxtimestep;
+        update_A_b(*sys.A,*sys.b,x0,h,0);
+        pattern = sys.A->analyze_structure();
+        shared_structure = &pattern;
+        monte_carlo_stat.shared_structure = true;
+    }
 
+    //measurements only, the waveforms are dropped after every trial
+    int m = probes.size();
+    std::vector<double> measured((size_t)trials*m,0);
+    std::vector<char> completed(trials,0);
+    monte_carlo_stat.copies = run_on_copies(trials,targets,[&](Circuit* c,int r){
+        trial_random random(seed,r);
+        for(int k=0;k<targets.size();k++){
+            double spread = tolerances[k].distribution==tolerance_gaussian ?
+                        std::max(-1.0,std::min(1.0,random.gaussian()/3)) : 2*random.uniform()-1;
+            c->set_component_value(targets[k],nominal[k]*(1+tolerances[k].tolerance*spread));
+        }
+        c->state = ok;
+        bool finite = true;
+        if(t<=0){
+            Matrix x = c->dc_analysis();
+            finite = c->dc_stat.stage!=dc_failed;
+            for(int p=0;p<m;p++)
+                measured[(size_t)r*m+p] = x(probes[p].node-1,0);
         }else{
-            A.add_ij(matrix_offset+i,matrix_offset+i,-inductance/timestep);
-            b.add_ij(matrix_offset+i,0,-inductance*last_state(matrix_offset+i,0)/timestep);
+            c->analysis(t,maxtimestep);
+            const QVector< QPair<Matrix,double> > &wave = c->solutions;
+            finite = c->state==ok && wave.size()>1;
+            for(int p=0;p<m && finite;p++){
+                int row = probes[p].node-1;
+                double high = wave[0].first(row,0);
+                double low = high;
+                double area = 0;
+                for(int i=1;i<wave.size();i++){
+                    double v = wave[i].first(row,0);
+                    high = std::max(high,v);
+                    low = std::min(low,v);
+                    area += (wave[i].second-wave[i-1].second)*(v+wave[i-1].first(row,0))/2;
+                }
+                double value = wave.back().first(row,0);
+                switch(probes[p].measure){
+                    case measure_max: value = high; break;
+                    case measure_min: value = low; break;
+                    case measure_peak_to_peak: value = high-low; break;
+                    case measure_average: value = area/wave.back().second; break;
+                }
+                measured[(size_t)r*m+p] = value;
+            }
+            c->solutions.clear();
         }
-    }
-    /*
-    for(int i=0;i<allDiode.size();i++){
-        int node1 = allDiode[i]->getNodeindex1()-1; // 1 --|>-- 2
-        int node2 = allDiode[i]->getNodeindex2()-1;
-        double Isat = allDiode[i]->get_Isat();
-        double Vd = last_state(node1,0)-last_state(node2,0);
-        double G = 40*Isat*exp(40*Vd);
-        //double Io = (exp(40*Vd)-1) - G*Vd;
-        if(node1<0&&node2<0){
+        for(int p=0;p<m;p++)
+            finite = finite && std::isfinite(measured[(size_t)r*m+p]);
+        completed[r] = finite;
+    });
+    shared_structure = nullptr;
+    if(monte_carlo_stat.shared_structure)
+        sys.clear();
+
+    monte_carlo_stat.trials = trials;
+    monte_carlo_stat.threads = pool ? pool->size() : 1;
+    for(int r=0;r<trials;r++)
+        monte_carlo_stat.completed += completed[r];
+    bins = std::max(1,bins);
+    for(int p=0;p<m;p++){
+        measurement_statistics st;
+        st.node = probes[p].node;
+        st.measure = probes[p].measure;
+        st.histogram.fill(0,bins);
+        double sum = 0;
+        for(int r=0;r<trials;r++){
+            if(!completed[r])
+                continue;
+            double v = measured[(size_t)r*m+p];
+            st.min = st.samples==0 ? v : std::min(st.min,v);
+            st.max = st.samples==0 ? v : std::max(st.max,v);
+            sum += v;
+            st.samples++;
+        }
+        if(st.samples==0){
+            monte_carlo_stat.statistics.push_back(st);
             continue;
-        }else if(node1<0){
-            A.add_ij(node2,node2,G);
-            //b.add_ij(node2,0,Io);
+        }
+        st.mean = sum/st.samples;
+        double square = 0;
+        for(int r=0;r<trials;r++){
+            if(completed[r])
+                square += (measured[(size_t)r*m+p]-st.mean)*(measured[(size_t)r*m+p]-st.mean);
+        }
+        st.sigma = st.samples>1 ? sqrt(square/(st.samples-1)) : 0;
+        st.bin_start = st.min;
+        st.bin_width = (st.max-st.min)/bins;
+        for(int r=0;r<trials;r++){
+            if(!completed[r])
+                continue;
+            int b = st.bin_width>0 ? int((measured[(size_t)r*m+p]-st.min)/st.bin_width) : 0;
+            st.histogram[std::min(b,bins-1)]++;
+        }
+        qDebug()<<"monte carlo node "<<st.node<<" measure "<<st.measure<<": mean "<<st.mean<<" sigma "<<st.sigma<<" range "<<st.min<<" .. "<<st.max;
+        monte_carlo_stat.statistics.push_back(st);
+    }
+    monte_carlo_stat.elapsed = total.elapsed();
+    qDebug()<<"monte carlo: "<<monte_carlo_stat.completed<<" of "<<trials<<" trials on "<<monte_carlo_stat.threads<<" threads, "<<monte_carlo_stat.copies<<" circuit copies, "<<monte_carlo_stat.elapsed<<" ms";
+    return monte_carlo_stat.completed==trials;
+}
+const monte_carlo_report& Circuit::get_monte_carlo_report()
+{
+    return monte_carlo_stat;
+}
+const QVector<step_run>& Circuit::get_step_runs()
+{
+    return step_runs;
+}
+const step_report& Circuit::get_step_report()
+{
+    return step_stat;
+}
+void Circuit::update_A_b(Matrix &A,Matrix &b,const Matrix &last_state,double timestep,double current_time)
+{
+    A = sys.ini_A;
+    b.setall(0);
+    //current_source stamps, sources of one color touch different rows
+    for(int c=0;c<current_source_colors.size();c++){
+        const QVector<int>& color = current_source_colors[c];
+        parallel_for(color.size(),[&](int begin,int end){
+            for(int k=begin;k<end;k++){
+                int i = color[k];
+                int node1 = allCurrent_source[i]->getNodeindex1()-1; // 1->2
+                int node2 = allCurrent_source[i]->getNodeindex2()-1;
+                double current = allCurrent_source[i]->get_current(current_time);
+                if(node1<0&&node2<0){
+                    continue;
+                }else if(node1<0){
+                    b.add_ij(node2,0,current);
+                }else if(node2<0){
+                    b.add_ij(node1,0,current);
+                }else{
+                    b.add_ij(node1,0,current);
+                    b.add_ij(node2,0,-current);
+                }
+            }
+        });
+    }
+    //voltage sources, capacitors and inductors only write their own branch row
+    int vs_offset = total_numofNode-1;
+    parallel_for(allVoltage_source.size(),[&](int begin,int end){
+        for(int i=begin;i<end;i++){
+            int node1 = allVoltage_source[i]->getNodeindex1()-1; //-
+            int node2 = allVoltage_source[i]->getNodeindex2()-1; //+
+            double voltage = allVoltage_source[i]->get_voltage(current_time);
+            if(node1<0&&node2<0){
+                continue;
+            }else if(node1<0){
+                b.add_ij(vs_offset+i,0,voltage);
+            }else if(node2<0){
+                b.add_ij(vs_offset+i,0,-voltage);
+            }else{
+                b.add_ij(vs_offset+i,0,voltage);
+            }
+        }
+    });
+    int c_offset = total_numofNode-1+allVoltage_source.size();
+    parallel_for(allCapacitor.size(),[&](int begin,int end){
+        for(int i=begin;i<end;i++){
+            int node1 = allCapacitor[i]->getNodeindex1()-1;
+            int node2 = allCapacitor[i]->getNodeindex2()-1;
+            double capacitance = allCapacitor[i]->get_capacitance();
+            if(node1<0&&node2<0){
+                continue;
+            }else if(node1<0){
+                A.add_ij(c_offset+i,node2,-capacitance/timestep);
+                b.add_ij(c_offset+i,0, capacitance * (-last_state(node2,0)) /timestep);
+            }else if(node2<0){
+                A.add_ij(c_offset+i,node1,capacitance/timestep);
+                b.add_ij(c_offset+i,0,capacitance * (last_state(node1,0)) /timestep);
+            }else{
+                A.add_ij(c_offset+i,node1,capacitance/timestep);
+                A.add_ij(c_offset+i,node2,-capacitance/timestep);
+                b.add_ij(c_offset+i,0,capacitance*(last_state(node1,0)-last_state(node2,0))/timestep);
+            }
+        }
+    });
+    int l_offset = total_numofNode-1+allVoltage_source.size()+allCapacitor.size();
+    parallel_for(allInductor.size(),[&](int begin,int end){
+        for(int i=begin;i<end;i++){
+            int node1 = allInductor[i]->getNodeindex1()-1;
+            int node2 = allInductor[i]->getNodeindex2()-1;
+            double inductance = allInductor[i]->getInductance();
+            if(node1<0&&node2<0)
+                continue;
+            A.add_ij(l_offset+i,l_offset+i,-inductance/timestep);
+            b.add_ij(l_offset+i,0,-inductance*last_state(l_offset+i,0)/timestep);
+        }
+    });
+}
 
-        }else if(node2<0){
-            A.add_ij(node1,node1,G);
-            //b.add_ij(node1,0,-Io);
-        }else{
-            A.add_ij(node1,node1,G);
-            A.add_ij(node1,node2,-G);
-            A.add_ij(node2,node1,-G);
-            A.add_ij(node2,node2,G);
-           // b.add_ij(node1,0,-Io);
-           // b.add_ij(node2,0,Io);
+void Circuit::stamp_diode_current(Matrix &non_linear,const Matrix &state)
+{
+    evaluate_diodes(state,diodes.node1,diodes.node2);
+    for(int c=0;c<diode_colors.size();c++){
+        const QVector<int>& color = diode_colors[c];
+        parallel_for(color.size(),[&](int begin,int end){
+            for(int k=begin;k<end;k++){
+                int i = color[k];
+                int node1 = diodes.node1[i]; // 1 --|>-- 2
+                int node2 = diodes.node2[i];
+                double Id = diodes.Id[i];
+                if(Id==0)
+                    continue;
+                if(node1<0&&node2<0){
+                    continue;
+                }else if(node1<0){
+                    non_linear.add_ij(node2,0,-Id);
+                }else if(node2<0){
+                    non_linear.add_ij(node1,0,Id);
+                }else{
+                    non_linear.add_ij(node1,0,Id);
+                    non_linear.add_ij(node2,0,-Id);
+                }
+            }
+        });
+    }
+}
+void Circuit::evaluate_diodes(const Matrix &state,const std::vector<int> &node1,const std::vector<int> &node2)
+{
+    int n = diodes.Isat.size();
+    diodes.pending.resize(n);
+    diodes.arg.resize(n);
+    diodes.ex.resize(n);
+    std::atomic<int> evaluations(0);
+    std::atomic<int> bypasses(0);
+    //every chunk packs its pending diodes at the start of its own slice
+    parallel_for(n,[&](int begin,int end){
+        int count = 0;
+        int bypassed = 0;
+        int m = begin;
+        //gather: junction voltages, bypassed diodes are finished here
+        for(int i=begin;i<end;i++){
+            double Vd = state(node1[i],0)-state(node2[i],0);
+            diodes.Id[i] = 0;
+            diodes.G[i] = 0;
+            if(Vd<=0)
+                continue;
+            count++;
+            //bypass: the junction barely moved, extend the cached linearization
+            if(device_bypass && diodes.cached[i] && diodes.Vd0[i]>0 && fabs(Vd-diodes.Vd0[i])<bypass_tolerance){
+                diodes.Id[i] = diodes.Id0[i]+diodes.G0[i]*(Vd-diodes.Vd0[i]);
+                diodes.G[i] = diodes.G0[i];
+                bypassed++;
+                continue;
+            }
+            diodes.pending[m] = i;
+            diodes.arg[m] = 40*Vd;
+            m++;
         }
-    }*/
+        fast_exp::evaluate(diodes.arg.data()+begin,diodes.ex.data()+begin,m-begin);
+        //scatter back into the per diode arrays
+        for(int k=begin;k<m;k++){
+            int i = diodes.pending[k];
+            double e = diodes.ex[k];
+            double Id = diodes.Isat[i]*(e-1);
+            double G = 40*diodes.Isat[i]*e;
+            if(!isnormal(Id))
+                Id = 0;
+            if(isinf(G))
+                G = 0;
+            diodes.Id[i] = Id;
+            diodes.G[i] = G;
+            diodes.cached[i] = 1;
+            diodes.Vd0[i] = diodes.arg[k]/40;
+            diodes.Id0[i] = Id;
+            diodes.G0[i] = G;
+        }
+        evaluations += count;
+        bypasses += bypassed;
+    });
+    newton_stat.diode_evaluations += evaluations;
+    newton_stat.diode_bypasses += bypasses;
+}
+void Circuit::stamp_diode_conductance(Matrix &J,const Matrix &state)
+{
+    evaluate_diodes(state,diodes.node1,diodes.node2);
+    for(int c=0;c<diode_colors.size();c++){
+        const QVector<int>& color = diode_colors[c];
+        parallel_for(color.size(),[&](int begin,int end){
+            for(int k=begin;k<end;k++){
+                int i = color[k];
+                int node1 = diodes.node1[i]; // 1 --|>-- 2
+                int node2 = diodes.node2[i];
+                double G = diodes.G[i];
+                if(G==0)
+                    continue;
+                if(node1<0&&node2<0){
+                    continue;
+                }else if(node1<0){
+                    J.add_ij(node2,node2,G);
+                }else if(node2<0){
+                    J.add_ij(node1,node1,G);
+                }else{
+                    J.add_ij(node1,node1,G);
+                    J.add_ij(node1,node2,-G);
+                    J.add_ij(node2,node1,-G);
+                    J.add_ij(node2,node2,G);
+                }
+            }
+        });
+    }
 }
-
 void Circuit::sort_the_allcomponent()
 {
     allResistor.clear();
@@ -1223,314 +3942,211 @@ void Circuit::sort_the_allcomponent()
     qDebug()<<"VCCS: "<<allVCCS.size();
     qDebug()<<"VCVS: "<<allVCVS.size();
 
+    index_component_names();
     find_initial_condition();
+    if(state==ok)
+        check_controls();
+    if(state==ok)
+        check_structure();
 }
-Matrix Circuit::get_jacobian(Matrix last_state,double timestep)
+bool Circuit::check_controls()
 {
-
-    int num_of_unknown = total_numofNode-1;//without ground
-    num_of_unknown += allVoltage_source.size();
-    num_of_unknown += allCapacitor.size();
-    num_of_unknown += allInductor.size();
-    num_of_unknown += allVCVS.size();
-    num_of_unknown += allCCVS.size();
-    Matrix J(num_of_unknown,num_of_unknown,0);
-
-    //resistor stamps
-
-    int matrix_offset=0;
-    for(int i=0;i<allResistor.size();i++){
-        int node1 = allResistor[i]->getNodeindex1()-1;
-        int node2 = allResistor[i]->getNodeindex2()-1;
-        double conductance = 1/allResistor[i]->get_resistance();
-        if(node1<0&&node2<0){
-            continue;
-        }else if(node1<0){
-            J.add_ij(node2,node2,conductance);
-        }else if(node2<0){
-            J.add_ij(node1,node1,conductance);
-        }else{
-            J.add_ij(node1,node1,conductance);
-            J.add_ij(node2,node2,conductance);
-            J.add_ij(node1,node2,-conductance);
-            J.add_ij(node2,node1,-conductance);
-        }
+    //a control that does not resolve would otherwise be read as ground
+    for(auto s:allVCCS){
+        getDependantNode(s->getDependantNode1());
+        getDependantNode(s->getDependantNode2());
     }
-    /*
-    //current_source stamps
-    for(int i=0;i<allCurrent_source.size();i++){
-        int node1 = allCurrent_source[i]->getNodeindex1()-1; // 1->2
-        int node2 = allCurrent_source[i]->getNodeindex2()-1;
-        double current = allCurrent_source[i]->get_current(0);
-        if(node1<0&&node2<0){
-            continue;
-        }else if(node1<0){
-            sys.b->add_ij(node2,0,current);
-        }else if(node2<0){
-            sys.b->add_ij(node1,0,current);
-        }else{
-            sys.b->add_ij(node1,0,current);
-            sys.b->add_ij(node2,0,-current);
-        }
+    for(auto s:allVCVS){
+        getDependantNode(s->getDependantNode1());
+        getDependantNode(s->getDependantNode2());
     }
-    */
-    //voltage_source stamps
-    matrix_offset = total_numofNode-1;
-    for(int i=0;i<allVoltage_source.size();i++){
-        int node1 = allVoltage_source[i]->getNodeindex1()-1; //-
-        int node2 = allVoltage_source[i]->getNodeindex2()-1; //+
-        if(node1<0&&node2<0){
-            continue;
-        }else if(node1<0){
-            J.add_ij(matrix_offset+i,node2,1);
-            J.add_ij(node2,matrix_offset+i,1);
-        }else if(node2<0){
-            J.add_ij(matrix_offset+i,node2,1);
-            J.add_ij(node2,matrix_offset+i,1);
-        }else{
-            J.add_ij(matrix_offset+i,node2,1);
-            J.add_ij(node2,matrix_offset+i,1);
-            J.add_ij(matrix_offset+i,node1,-1);
-            J.add_ij(node1,matrix_offset+i,-1);
-        }
+    for(auto s:allCCCS)
+        getDependantBranch(s->getDependantBranchName());
+    for(auto s:allCCVS)
+        getDependantBranch(s->getDependantBranchName());
+    return state!=unresolved_control;
+}
+bool Circuit::check_structure()
+{
+    //runs after analysis_circuit_connection and the sort, the pattern is the one build_dc_system and storage_matrix stamp
+    structure_stat = structure_report();
+    pivot_order.clear();
+    Matrix A;
+    Matrix b;
+    build_dc_system(A,b);
+    int n = A.get_row_num();
+    int nodes = total_numofNode-1;
+    structure_stat.unknowns = n;
+    if(n==0)
+        return true;
+    Matrix P(n,n,0);
+    for(int i=0;i<n;i++)
+        for(int j=0;j<n;j++)
+            if(A(i,j)!=0)
+                P.set_ij(i,j,1);
+    for(int i=0;i<allDiode.size();i++){
+        int node1 = allDiode[i]->getNodeindex1()-1;
+        int node2 = allDiode[i]->getNodeindex2()-1;
+        P.set_ij(node1,node1,1);
+        P.set_ij(node2,node2,1);
+        P.set_ij(node1,node2,1);
+        P.set_ij(node2,node1,1);
     }
-    //capacitor stamps
-    matrix_offset = total_numofNode-1+allVoltage_source.size();
+    std::vector<int> dc_match = P.structural_matching();
+    int c_offset = nodes+allVoltage_source.size();
+    int l_offset = c_offset+allCapacitor.size();
     for(int i=0;i<allCapacitor.size();i++){
-        int node1 = allCapacitor[i]->getNodeindex1()-1;
-        int node2 = allCapacitor[i]->getNodeindex2()-1;
-        double capacitance = allCapacitor[i]->get_capacitance();
-        if(node1<0&&node2<0){
-            continue;
-        }else if(node1<0){
-
-            J.add_ij(node2,matrix_offset+i,-1);
-            J.add_ij(matrix_offset+i,node2,-capacitance/timestep);
-        }else if(node2<0){
-
-            J.add_ij(node1,matrix_offset+i,1);
-            J.add_ij(matrix_offset+i,node1,capacitance/timestep);
-
-        }else{
-            J.add_ij(node1,matrix_offset+i,1);
-            J.add_ij(node2,matrix_offset+i,-1);
-            J.add_ij(matrix_offset+i,node1,capacitance/timestep);
-            J.add_ij(matrix_offset+i,node2,-capacitance/timestep);
-        }
-    }
-    //inductor stamps
-    matrix_offset = total_numofNode-1+allVoltage_source.size()+allCapacitor.size();
-    for(int i=0;i<allInductor.size();i++){
-        int node1 = allInductor[i]->getNodeindex1()-1;
-        int node2 = allInductor[i]->getNodeindex2()-1;
-        double inductance = allInductor[i]->getInductance();
-        if(node1<0&&node2<0){
-            continue;
-        }else if(node1<0){
-
-            J.add_ij(node2,matrix_offset+i,1);
-            J.add_ij(matrix_offset+i,node2,timestep/inductance);
-
-        }else if(node2<0){
-
-            J.add_ij(node1,matrix_offset+i,-1);
-            J.add_ij(matrix_offset+i,node1,-timestep/inductance);
-
-        }else{
-            J.add_ij(node1,matrix_offset+i,-1);
-            J.add_ij(node2,matrix_offset+i,1);
-            J.add_ij(matrix_offset+i,node1,-timestep/inductance);
-            J.add_ij(matrix_offset+i,node2,timestep/inductance);
-        }
+        P.set_ij(c_offset+i,allCapacitor[i]->getNodeindex1()-1,1);
+        P.set_ij(c_offset+i,allCapacitor[i]->getNodeindex2()-1,1);
     }
-
-    for(int i=0;i<allDiode.size();i++){
-        int node1 = allDiode[i]->getNodeindex1()-1; // 1 --|>-- 2
-        int node2 = allDiode[i]->getNodeindex2()-1;
-        double Isat = allDiode[i]->get_Isat();
-        double Vd = last_state(node1,0)-last_state(node2,0);
-        if(Vd<=0)
-            continue;
-        double G = 40*Isat*exp(40*Vd);
-        if(isinf(G))
-            continue;
-        //double Io = (exp(40*Vd)-1) - G*Vd;
-        if(node1<0&&node2<0){
-            continue;
-        }else if(node1<0){
-            J.add_ij(node2,node2,G);
-            //b.add_ij(node2,0,Io);
-
-        }else if(node2<0){
-            J.add_ij(node1,node1,G);
-            //b.add_ij(node1,0,-Io);
-        }else{
-            J.add_ij(node1,node1,G);
-            J.add_ij(node1,node2,-G);
-            J.add_ij(node2,node1,-G);
-            J.add_ij(node2,node2,G);
-           // b.add_ij(node1,0,-Io);
-           // b.add_ij(node2,0,Io);
+    for(int i=0;i<allInductor.size();i++)
+        P.set_ij(l_offset+i,l_offset+i,1);
+    std::vector<int> col_match = P.structural_matching();
+    std::vector<int> row_match(n,-1);
+    for(int j=0;j<n;j++){
+        if(col_match[j]>=0){
+            row_match[col_match[j]] = j;
+            structure_stat.rank++;
         }
+        if(dc_match[j]>=0)
+            structure_stat.dc_rank++;
     }
 
-
-
-
-    //VCCS stamps not done
-    for(int i=0;i<allVCCS.size();i++){
-        int node1 = allVCCS[i]->getNodeindex1()-1;//1 --> 2
-        int node2 = allVCCS[i]->getNodeindex2()-1;
-        int s_node1 = getDependantNode(allVCCS[i]->getDependantNode1())-1;
-        int s_node2 = getDependantNode(allVCCS[i]->getDependantNode2())-1;
-        double G = allVCCS[i]->getCoefficient();
-        if(node1<0&&node2<0){
-            continue;
-        }else if(s_node1<0&&s_node2<0){
-            continue;
-        }else if(node1<0){
-            if(s_node1<0){
-                J.add_ij(node2,s_node2,G);
-            }else if(s_node2<0){
-                J.add_ij(node2,s_node1,-G);
-            }else{
-                J.add_ij(node2,s_node2,G);
-                J.add_ij(node2,s_node1,-G);
+    //branch unknowns and their rows belong to one component, node rows and columns to every component on the node
+    auto owner = [&](int k)->Component*{
+        k -= nodes;
+        if(k<0)
+            return nullptr;
+        if(k<allVoltage_source.size())
+            return allVoltage_source[k];
+        k -= allVoltage_source.size();
+        if(k<allCapacitor.size())
+            return allCapacitor[k];
+        k -= allCapacitor.size();
+        if(k<allInductor.size())
+            return allInductor[k];
+        k -= allInductor.size();
+        if(k<allVCVS.size())
+            return allVCVS[k];
+        return allCCVS[k-allVCVS.size()];
+    };
+    auto blame = [&](int k){
+        Component* c = owner(k);
+        if(c){
+            if(!structure_stat.components.contains(c->getname()))
+                structure_stat.components.push_back(c->getname());
+            QVector<Node*> &terminals = c->getNodes();
+            for(int t=0;t<terminals.size();t++){
+                int node = terminals[t]->getNodeIndex();
+                if(node>0 && !structure_stat.nodes.contains(node))
+                    structure_stat.nodes.push_back(node);
             }
-        }else if(node2<0){
-            if(s_node1<0){
-                J.add_ij(node1,s_node2,-G);
-            }else if(s_node2<0){
-                J.add_ij(node1,s_node1,G);
-            }else{
-                J.add_ij(node1,s_node2,-G);
-                J.add_ij(node1,s_node1,G);
+            return;
+        }
+        if(!structure_stat.nodes.contains(k+1))
+            structure_stat.nodes.push_back(k+1);
+        for(int i=0;i<allComponent.size();i++){
+            QVector<Node*> &terminals = allComponent[i]->getNodes();
+            for(int t=0;t<terminals.size();t++){
+                if(terminals[t]->getNodeIndex()-1==k && !structure_stat.components.contains(allComponent[i]->getname()))
+                    structure_stat.components.push_back(allComponent[i]->getname());
             }
-        }else{
-            if(s_node1<0){
-                J.add_ij(node1,s_node2,-G);
-                J.add_ij(node2,s_node2,G);
-            }else if(s_node2<0){
-                J.add_ij(node1,s_node1,G);
-                J.add_ij(node2,s_node1,-G);
-            }else{
-                J.add_ij(node1,s_node1,-G);
-                J.add_ij(node1,s_node2,G);
-                J.add_ij(node2,s_node1,-G);
-                J.add_ij(node2,s_node2,G);
+        }
+    };
+    if(structure_stat.rank<n){
+        //dulmage-mendelsohn: everything an alternating path reaches from an unmatched row or column
+        std::vector<char> row_seen(n,0),col_seen(n,0);
+        std::vector<int> stack;
+        for(int j=0;j<n;j++){
+            if(col_match[j]<0){
+                col_seen[j] = 1;
+                stack.push_back(j);
             }
         }
-    }
-    //VCVS stamps
-    matrix_offset += allInductor.size();
-    for(int i=0;i<allVCVS.size();i++){
-        int node1 = allVCVS[i]->getNodeindex1()-1;//-
-        int node2 = allVCVS[i]->getNodeindex2()-1;//+
-        int s_node1 = getDependantNode(allVCVS[i]->getDependantNode1())-1;
-        int s_node2 = getDependantNode(allVCVS[i]->getDependantNode2())-1;
-        double A = allVCVS[i]->getCoefficient();
-        if(node1<0&&node2<0){
-            continue;
-        }else if(s_node1<0&&s_node2<0){
-            continue;
-        }else if(node1<0){
-            if(s_node1<0){
-                J.add_ij(matrix_offset+i,node2,1);
-                J.add_ij(matrix_offset+i,s_node2,A);
-                J.add_ij(node2,matrix_offset+i,1);
-            }else if(s_node2<0){
-                J.add_ij(matrix_offset+i,node2,1);
-                J.add_ij(matrix_offset+i,s_node1,-A);
-                J.add_ij(node2,matrix_offset+i,1);
-            }else{
-                J.add_ij(matrix_offset+i,node2,1);
-                J.add_ij(matrix_offset+i,s_node2,A);
-                J.add_ij(matrix_offset+i,s_node1,-A);
-                J.add_ij(node2,matrix_offset+i,1);
+        while(!stack.empty()){
+            int j = stack.back();
+            stack.pop_back();
+            for(int i=0;i<n;i++){
+                if(P(i,j)!=0 && row_match[i]>=0 && !col_seen[row_match[i]]){
+                    col_seen[row_match[i]] = 1;
+                    stack.push_back(row_match[i]);
+                }
             }
-        }else if(node2<0){
-            if(s_node1<0){
-                J.add_ij(matrix_offset+i,node1,-1);
-                J.add_ij(matrix_offset+i,s_node2,A);
-                J.add_ij(node1,matrix_offset+i,-1);
-            }else if(s_node2<0){
-                J.add_ij(matrix_offset+i,node1,-1);
-                J.add_ij(matrix_offset+i,s_node1,-A);
-                J.add_ij(node1,matrix_offset+i,-1);
-            }else{
-                J.add_ij(matrix_offset+i,node1,-1);
-                J.add_ij(matrix_offset+i,s_node2,A);
-                J.add_ij(matrix_offset+i,s_node1,-A);
-                J.add_ij(node1,matrix_offset+i,-1);
+        }
+        for(int i=0;i<n;i++){
+            if(row_match[i]<0){
+                row_seen[i] = 1;
+                stack.push_back(i);
             }
-        }else{
-            if(s_node1<0){
-                J.add_ij(node2,matrix_offset+i,1);
-                J.add_ij(matrix_offset+i,node2,1);
-                J.add_ij(matrix_offset+i,node1,-1);
-                J.add_ij(node1,matrix_offset+i,-1);
-                J.add_ij(matrix_offset+i,s_node2,A);
-            }else if(s_node2<0){
-                J.add_ij(node2,matrix_offset+i,1);
-                J.add_ij(matrix_offset+i,node2,1);
-                J.add_ij(matrix_offset+i,node1,-1);
-                J.add_ij(node1,matrix_offset+i,-1);
-                J.add_ij(matrix_offset+i,s_node1,-A);
-            }else{
-                J.add_ij(node2,matrix_offset+i,1);
-                J.add_ij(matrix_offset+i,node2,1);
-                J.add_ij(matrix_offset+i,node1,-1);
-                J.add_ij(node1,matrix_offset+i,-1);
-                J.add_ij(matrix_offset+i,s_node2,A);
-                J.add_ij(matrix_offset+i,s_node1,-A);
+        }
+        while(!stack.empty()){
+            int i = stack.back();
+            stack.pop_back();
+            for(int j=0;j<n;j++){
+                if(P(i,j)!=0 && col_match[j]>=0 && !row_seen[col_match[j]]){
+                    row_seen[col_match[j]] = 1;
+                    stack.push_back(col_match[j]);
+                }
             }
         }
+        for(int k=0;k<n;k++)
+            if(row_seen[k] || col_seen[k])
+                blame(k);
+        structure_stat.singular = true;
     }
-    //CCCS stamps
-    int matrix_offsetCCCS = total_numofNode-1;
-    for(int i=0;i<allCCCS.size();i++){
-        int node1 = allCCCS[i]->getNodeindex1()-1;//1 ---> 2
-        int node2 = allCCCS[i]->getNodeindex2()-1;
-        int vs_num=0;
-        double A = allCCCS[i]->getCoefficient();
-        Component* s_node = getDependantBranch(allCCCS[i]->getDependantBranchName());
-        voltage_source* vs = dynamic_cast<voltage_source*>(s_node);
-        if(!vs){
-            qDebug()<<"Wrong usage";
-        }else{
-            vs_num = vs->get_num();
-        }
-        if(node1>=0)
-            J.add_ij(node1,matrix_offsetCCCS+vs_num,A);
-        if(node2>=0)
-            J.add_ij(node2,matrix_offsetCCCS+vs_num,-A);
+
+    //a full pattern can still float: a node group tied to ground only through current sources
+    std::vector<int> parent(nodes+1);
+    for(int i=0;i<=nodes;i++)
+        parent[i] = i;
+    std::function<int(int)> find = [&](int k){
+        return parent[k]==k ? k : parent[k] = find(parent[k]);
+    };
+    for(int i=0;i<allComponent.size();i++){
+        if(dynamic_cast<current_source*>(allComponent[i]) || dynamic_cast<Current_control_current_source*>(allComponent[i])
+                || dynamic_cast<Voltage_control_current_source*>(allComponent[i]))
+            continue;
+        QVector<Node*> &terminals = allComponent[i]->getNodes();
+        if(terminals.size()<2)
+            continue;
+        int node1 = terminals[0]->getNodeIndex()-1;
+        int node2 = terminals[1]->getNodeIndex()-1;
+        parent[find(node1<0 ? nodes : node1)] = find(node2<0 ? nodes : node2);
     }
-    matrix_offset += allVCVS.size();
-    int matrix_offsetCCVS = total_numofNode-1;
-    for(int i=0;i<allCCVS.size();i++){
-        int node1 = allCCVS[i]->getNodeindex1()-1;//-
-        int node2 = allCCVS[i]->getNodeindex2()-1;//+
-        int vs_num=0;
-        double A = allCCVS[i]->getCoefficient();
-        Component* s_node = getDependantBranch(allCCVS[i]->getDependantBranchName());
-        voltage_source* vs = dynamic_cast<voltage_source*>(s_node);
-        if(!vs){
-            qDebug()<<"Wrong usage";
-        }else{
-            vs_num = vs->get_num();
-        }
-        if(node1>=0){
-            J.add_ij(matrix_offset+i,node1,-1);
-            J.add_ij(node1,matrix_offset+i,-1);
+    for(int k=0;k<nodes;k++){
+        if(find(k)!=find(nodes)){
+            structure_stat.floating_nodes.push_back(k+1);
+            structure_stat.singular = true;
         }
-        if(node2>=0){
-            J.add_ij(matrix_offset+i,node2,1);
-            J.add_ij(node2,matrix_offset+i,1);
-        }
-        J.add_ij(matrix_offset+i,matrix_offsetCCVS+vs_num,-A);
     }
 
-
+    if(structure_stat.singular){
+        if(structure_stat.rank<n){
+            qDebug()<<"structurally singular, rank "<<structure_stat.rank<<" of "<<n;
+            qDebug()<<"nodes: "<<structure_stat.nodes;
+            qDebug()<<"components: "<<structure_stat.components;
+        }
+        if(!structure_stat.floating_nodes.isEmpty())
+            qDebug()<<"no path to ground from nodes "<<structure_stat.floating_nodes;
+        state = singular_structure;
+        return false;
+    }
+    if(structure_stat.dc_rank<n)
+        qDebug()<<"open capacitors leave "<<n-structure_stat.dc_rank<<" unknowns without a dc path";
+    pivot_order = col_match;
+    return true;
+}
+const structure_report& Circuit::get_structure_report()
+{
+    return structure_stat;
+}
+Matrix Circuit::get_jacobian(Matrix last_state,double timestep)
+{
+    //f = A*x + i_diode(x) - b, so J = A + diode conductances
+    Matrix J = sys.ini_A;
+    Matrix b = *sys.b;
+    update_A_b(J,b,last_state,timestep,0);
+    stamp_diode_conductance(J,last_state);
     return J;
 }
 void Circuit::resetAllNodeIndex()
@@ -1548,8 +4164,9 @@ void Circuit::resetAllNodeIndex()
 void Circuit::push_backComponent(Component *c)
 {
     allComponent.push_back(c);
+    component_index_stale = true;
 }
-void Circuit::push_backLine(LineNodeitem *l)
+void Circuit::push_backLine(NodeLine *l)
 {
     allLine.push_back(l);
 }
@@ -1560,6 +4177,7 @@ void Circuit::push_backGround(Ground *g)
 void Circuit::deleteComponent(int index)
 {
     allComponent.erase(allComponent.begin() + index);
+    component_index_stale = true;
 }
 
 void Circuit::deleteAllComponent()
@@ -1567,38 +4185,164 @@ void Circuit::deleteAllComponent()
     for(int i=0;i<allComponent.size();i++)
         delete allComponent[i];
     allComponent.clear();
+    component_index_stale = true;
 }
 int Circuit::get_circuit_state()
 {
     return state;
 }
+void Circuit::set_newton_mode(int mode,double contraction)
+{
+    newton = mode;
+    chord_contraction = contraction;
+    jacobian_lu.singular = true;
+}
+void Circuit::set_predictor_order(int order)
+{
+    predictor_order = std::max(0,std::min(order,3));
+}
+void Circuit::set_device_bypass(bool on,double tolerance)
+{
+    device_bypass = on;
+    bypass_tolerance = tolerance;
+    std::fill(diodes.cached.begin(),diodes.cached.end(),0);
+}
+void Circuit::set_assembly_threads(int threads)
+{
+    if(threads<=0)
+        threads = std::max(1u,std::thread::hardware_concurrency());
+    assembly_threads = threads;
+    delete pool;
+    pool = threads>1 ? new ThreadPool(threads) : nullptr;
+}
+int Circuit::get_assembly_threads()
+{
+    return assembly_threads;
+}
+void Circuit::parallel_for(int n,const std::function<void(int,int)>& body)
+{
+    //fixed chunks, so results never depend on the number of threads
+    const int grain = 256;
+    if(pool)
+        pool->parallel_for(n,grain,body);
+    else if(n>0)
+        body(0,n);
+}
+QVector<QVector<int>> Circuit::color_footprints(const std::vector<int> &node1,const std::vector<int> &node2,int nodes)
+{
+    //greedy coloring: a device goes to the first color that uses neither of its nodes
+    QVector<QVector<int>> colors;
+    std::vector<std::vector<char>> used;
+    for(int i=0;i<int(node1.size());i++){
+        int c = 0;
+        for(;c<colors.size();c++){
+            bool free1 = node1[i]<0 || !used[c][node1[i]];
+            bool free2 = node2[i]<0 || !used[c][node2[i]];
+            if(free1&&free2)
+                break;
+        }
+        if(c==colors.size()){
+            colors.push_back(QVector<int>());
+            used.push_back(std::vector<char>(nodes,0));
+        }
+        colors[c].push_back(i);
+        if(node1[i]>=0)
+            used[c][node1[i]] = 1;
+        if(node2[i]>=0)
+            used[c][node2[i]] = 1;
+    }
+    return colors;
+}
+void Circuit::set_schur_reduction(bool on)
+{
+    schur_reduction = on;
+    schur_cache.clear();
+}
+const newton_statistics& Circuit::get_newton_statistics()
+{
+    return newton_stat;
+}
+void Circuit::report_newton_statistics()
+{
+    qDebug()<<(newton == modified_newton ? "modified newton" : "full newton");
+    qDebug()<<"accepted steps: "<<newton_stat.accepted_steps<<" newton solves: "<<newton_stat.solves<<" iterations: "<<newton_stat.iterations;
+    if(newton_stat.accepted_steps>0)
+        qDebug()<<"factorizations per accepted step: "<<double(newton_stat.factorizations)/newton_stat.accepted_steps;
+    if(newton_stat.solves>0)
+        qDebug()<<"iterations per newton solve: "<<double(newton_stat.iterations)/newton_stat.solves;
+    if(predictor_order>0)
+        qDebug()<<"predictor order "<<predictor_order<<": "<<newton_stat.predictions<<" guesses, "<<newton_stat.rejected_predictions<<" rejected";
+    for(int i=solver_general;i<=solver_tridiagonal;i++){
+        if(newton_stat.linear_solves[i]>0)
+            qDebug()<<"linear solves ("<<Matrix::solver_path_name(i)<<"): "<<newton_stat.linear_solves[i];
+    }
+    if(newton_stat.condition_estimate>0)
+        qDebug()<<"condition estimate: "<<newton_stat.condition_estimate<<(equilibration ? " (equilibrated)" : "")<<" refinement steps: "<<newton_stat.refinement_steps;
+    if(newton_stat.diode_evaluations>0)
+        qDebug()<<"diode bypass: "<<newton_stat.diode_bypasses<<" of "<<newton_stat.diode_evaluations<<" evaluations ("<<100.0*newton_stat.diode_bypasses/newton_stat.diode_evaluations<<"%)";
+}
 const QVector< QPair<Matrix,double> >& Circuit::get_solutions()
 {
     return solutions;
 }
+void Circuit::index_component_names()
+{
+    component_index_stale = false;
+    component_names.clear();
+    component_slot.clear();
+    for(int i=0;i<allComponent.size();i++){
+        int id = component_names.intern(allComponent[i]->getname());
+        if(id==component_slot.size())
+            component_slot.push_back(i);
+    }
+}
+int Circuit::find_component(const QString &name)
+{
+    //made again once after allComponent changed, or when a component was renamed since
+    if(component_index_stale)
+        index_component_names();
+    int id = component_names.find(name);
+    if(id<0)
+        return -1;
+    int i = component_slot[id];
+    if(i<allComponent.size() && allComponent[i]->getname()==name)
+        return i;
+    index_component_names();
+    id = component_names.find(name);
+    return id>=0 ? component_slot[id] : -1;
+}
 int Circuit::getDependantNode(QString a)
 {
-    qDebug() << a;
-    QChar last = a[a.size()-1];
-    a.erase(a.end()-1,a.end());
-    qDebug() << a;
-    for(int i=0;i<allComponent.size();i++)
-        if(a == allComponent[i]->getname())
-        {
-            if(last == 'L')
-                return allComponent[i]->getNodes()[0]->getNodeIndex();
-            else if(last == 'R')
-                return allComponent[i]->getNodes()[1]->getNodeIndex();
-        }
+    //"<component>L" is the first terminal of the component, "<component>R" the second
+    int i = a.isEmpty() ? -1 : find_component(a.left(a.size()-1));
+    QChar last = i>=0 ? a[a.size()-1] : QChar();
+    if(i>=0 && last == 'L')
+        return allComponent[i]->getNodes()[0]->getNodeIndex();
+    if(i>=0 && last == 'R')
+        return allComponent[i]->getNodes()[1]->getNodeIndex();
+    //not ground: the circuit cannot be solved until the reference is fixed
+    if(state!=unresolved_control){
+        state = unresolved_control;
+        unresolved = a;
+    }
+    qDebug()<<"no terminal for "<<a;
+    return 0;
 }
 Component* Circuit::getDependantBranch(QString a)
 {
-    qDebug() << a;
-    for(int i=0;i<allComponent.size();i++)
-        if(a == allComponent[i]->getname())
-        {
-            return allComponent[i];
-        }
+    int i = find_component(a);
+    if(i>=0)
+        return allComponent[i];
+    if(state!=unresolved_control){
+        state = unresolved_control;
+        unresolved = a;
+    }
+    qDebug()<<"no branch "<<a;
+    return nullptr;
+}
+const QString& Circuit::get_unresolved_control()
+{
+    return unresolved;
 }
 Circuit::~Circuit()
 {
@@ -1613,7 +4357,9 @@ Circuit::~Circuit()
     allVCCS.clear();
     allVCVS.clear();
     sys.clear();
-    deleteAllComponent();
+    delete pool;
+    if(owns_components)
+        deleteAllComponent();
     for(int i=0;i<allLine.size();i++)
         delete allLine[i];
     allLine.clear();
@@ -1697,8 +4443,8 @@ Matrix Circuit::analysis_circuit(double t,double timestep)
             A.add_ij(node2,matrix_offset+i,1);
             b.add_ij(matrix_offset+i,0,voltage);
         }else if(node2<0){
-            A.add_ij(matrix_offset+i,node2,1);
-            A.add_ij(node2,matrix_offset+i,1);
+            A.add_ij(matrix_offset+i,node1,1);
+            A.add_ij(node1,matrix_offset+i,1);
             b.add_ij(matrix_offset+i,0,-voltage);
         }else{
             A.add_ij(matrix_offset+i,node2,1);
@@ -1852,8 +4598,8 @@ QVector<Matrix> Circuit::analysis_circuit_timeinterval(double t)
             sys.A->add_ij(node2,matrix_offset+i,1);
             sys.b->add_ij(matrix_offset+i,0,voltage);
         }else if(node2<0){
-            sys.A->add_ij(matrix_offset+i,node2,1);
-            sys.A->add_ij(node2,matrix_offset+i,1);
+            sys.A->add_ij(matrix_offset+i,node1,1);
+            sys.A->add_ij(node1,matrix_offset+i,1);
             sys.b->add_ij(matrix_offset+i,0,-voltage);
         }else{
             sys.A->add_ij(matrix_offset+i,node2,1);
@@ -5,6 +5,7 @@
 #include "capacitor.h"
 #include "ground.h"
 #include <matrix.h>
+#include "complex_matrix.h"
 #include <math.h>
 #include "voltage_source.h"
 #include "current_source.h"
@@ -13,15 +14,61 @@
 #include <voltage_control_current_source.h>
 #include <voltage_control_voltage_source.h>
 #include "diode.h"
-#include <linenodeitem.h>
+#include "nodeline.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <functional>
+#include "threadpool.h"
+#include "symboltable.h"
+struct qstring_hash{
+    size_t operator()(const QString &s)const{ return qHash(s); }
+};
 enum circuit_state{
     ok = 0,
     idle ,
     no_component,
     no_ground,
     no_solution,
+    singular_structure,//structurally rank deficient or floating, see get_structure_report
+    unresolved_control,//a controlled source names a component that does not exist, see get_unresolved_control
 
 };
+enum newton_mode{
+    full_newton = 0,
+    modified_newton,//chord iteration, jacobian factorization kept while it still contracts
+};
+struct newton_statistics{
+    int accepted_steps = 0;
+    int solves = 0;
+    int iterations = 0;
+    int factorizations = 0;
+    int predictions = 0;
+    int rejected_predictions = 0;//newton restarted from the previous state
+    int diode_evaluations = 0;
+    int diode_bypasses = 0;//cached stamps reused instead of calling exp
+    int linear_solves[5] = {0,0,0,0,0};//per solver_path, after fallbacks
+    int equilibrated_factorizations = 0;
+    int refinement_steps = 0;
+    double condition_estimate = 0;//largest 1-norm estimate of the matrices factored this run
+    void clear(){
+        *this = newton_statistics();
+    }
+};
+struct diode_batch{
+    //structure of arrays so the exp calls run as one vector loop
+    std::vector<int> node1;//matrix row of the anode, -1 for ground
+    std::vector<int> node2;
+    std::vector<double> Isat;
+    std::vector<double> Id;//last evaluation
+    std::vector<double> G;
+    std::vector<char> cached;//bypass cache: linearization at Vd0
+    std::vector<double> Vd0;
+    std::vector<double> Id0;
+    std::vector<double> G0;
+    std::vector<int> pending;//diodes that need a fresh exp this pass
+    std::vector<double> arg;
+    std::vector<double> ex;
+};
 struct circuit_Matrixsystem{
     Matrix* A;
     Matrix* b;
@@ -37,6 +84,223 @@ struct circuit_Matrixsystem{
         }
     }
 };
+enum dc_stage{
+    dc_failed = 0,
+    dc_newton,
+    dc_gmin_stepping,
+    dc_source_stepping,
+    dc_initial_condition,//no dc solve, start from the line voltages
+};
+struct dc_report{
+    int stage = dc_failed;
+    int iterations[3] = {0,0,0};//newton, gmin stepping, source stepping
+    double elapsed[3] = {0,0,0};//ms
+};
+struct dc_sweep_report{
+    bool completed = false;
+    int points = 0;//requested
+    int steps = 0;//solved, including the refinement near sharp transitions
+    int refinement_steps = 0;//solved between grid points, not in get_dc_sweep
+    int rejected = 0;//steps halved after a poor prediction or a slow newton
+    int newton_iterations = 0;
+    int factorizations = 0;
+    int cold_starts = 0;//points solved by dc_operating_point instead of a warm start
+    double elapsed = 0;//ms
+};
+enum valued_component{
+    valued_resistor = 0,
+    valued_capacitor,
+    valued_inductor,
+    valued_voltage_source,//amplitude
+    valued_current_source,
+};
+struct step_parameter{
+    QString component;//resistor, capacitor, inductor or independent source (its amplitude)
+    double start = 0;
+    double stop = 0;
+    int points = 1;//linear grid, start and stop included
+};
+struct step_run{
+    QVector<double> values;//one per step_parameter
+    bool completed = false;
+    QVector< QPair<Matrix,double> > solutions;
+};
+struct step_report{
+    int runs = 0;
+    int completed = 0;
+    int threads = 0;
+    int copies = 0;//circuit copies built, never more than the runs in flight
+    double elapsed = 0;//ms
+    double run_time = 0;//ms summed over the runs, run_time/elapsed is the speedup
+};
+enum tolerance_distribution{
+    tolerance_uniform = 0,//nominal*(1+tolerance*u), u uniform in [-1,1]
+    tolerance_gaussian,//tolerance is three sigma, clipped there
+};
+struct tolerance_spec{
+    QString component;//resistor, capacitor, inductor or independent source (its amplitude)
+    double tolerance = 0.05;//relative
+    int distribution = tolerance_uniform;
+};
+enum trial_measure{
+    measure_final = 0,//operating point, or the last transient sample
+    measure_max,
+    measure_min,
+    measure_peak_to_peak,
+    measure_average,//time weighted over the transient
+};
+struct monte_carlo_probe{
+    int node = 1;
+    int measure = measure_final;
+};
+struct measurement_statistics{
+    int node = 0;
+    int measure = measure_final;
+    int samples = 0;//completed trials
+    double mean = 0;
+    double sigma = 0;
+    double min = 0;
+    double max = 0;
+    double bin_start = 0;
+    double bin_width = 0;
+    QVector<int> histogram;
+};
+struct monte_carlo_report{
+    int trials = 0;
+    int completed = 0;
+    int threads = 0;
+    int copies = 0;
+    unsigned seed = 0;
+    bool shared_structure = false;//one pattern analysis for every trial
+    double elapsed = 0;//ms
+    QVector<measurement_statistics> statistics;//one per probe
+};
+struct schur_system{
+    double timestep = 0;
+    bool valid = false;
+    std::vector<int> nonlinear;//unknowns touched by a diode
+    std::vector<int> linear;
+    std::vector<int> diode_node1;//diode terminals as positions in nonlinear, -1 for ground
+    std::vector<int> diode_node2;
+    LU_factor linear_lu;//A_LL
+    Matrix A_NL;
+    Matrix W;//A_LL^-1 * A_LN
+    Matrix S;//A_NN - A_NL * W
+};
+struct pss_report{
+    bool converged = false;
+    double period = 0;
+    int periods_computed = 0;//one per shooting iteration
+    double residual = 0;//max |x(T) - x(0)|
+    double floquet_radius = 0;//slowest decay per period at the solution
+    int periods_to_settle = -1;//estimate for plain transient, -1 if it never settles
+};
+struct parareal_report{
+    bool converged = false;
+    int slices = 0;
+    int iterations = 0;
+    double boundary_change = 0;//largest update of a slice boundary in the last iteration
+    double elapsed = 0;//ms
+    double fine_elapsed = 0;//ms in the parallel fine sweeps
+};
+enum relaxation_sweep{
+    jacobi_sweep = 0,//every partition reads the previous sweep, all run at once
+    gauss_seidel_sweep,//partitions read the ones already solved in this sweep
+};
+struct relaxation_block{
+    //one waveform relaxation partition, the rest of the circuit comes in as waveforms
+    std::vector<int> owned;//unknowns solved here, empty for a whole circuit
+    std::vector<int> inputs;//foreign unknowns the owned rows couple to
+    std::vector<const QVector< QPair<Matrix,double> >*> input_waves;//waveform holding each input
+    std::vector<int> diode_node1;//diode terminals as positions in owned, -1 otherwise
+    std::vector<int> diode_node2;
+};
+struct relaxation_report{
+    bool converged = false;
+    int partitions = 0;
+    int sweeps = 0;
+    double interface_change = 0;//largest change of an input waveform in the last sweep
+    QVector<int> steps;//accepted steps of every partition in the last sweep
+    double elapsed = 0;//ms
+};
+struct reduced_model{
+    //prima macromodel of the R, L, C network behind the ports
+    bool valid = false;
+    std::vector<int> kept;//full unknowns solved directly, in compact order
+    std::vector<int> port_rows;//full row of every port node
+    std::vector<int> ports;//compact position of every port node
+    std::vector<int> internal;//internal node and inductor rows, x_internal = V z
+    std::vector<int> capacitors;//reduced capacitors, their currents are rebuilt after the solve
+    Matrix V;//orthonormal block krylov basis
+    Matrix Vt;
+    Matrix G_pz;//congruence diag(I,V)^T G diag(I,V), the resistive port block stays in the kept rows
+    Matrix G_zp;
+    Matrix G_zz;
+    Matrix C_pp;
+    Matrix C_pz;
+    Matrix C_zp;
+    Matrix C_zz;
+    std::vector<int> diode_node1;//diode terminals as compact positions, -1 for ground
+    std::vector<int> diode_node2;
+};
+struct reduction_report{
+    int ports = 0;
+    int internal = 0;//unknowns replaced by the reduced model
+    int reduced_size = 0;
+    int elements = 0;//resistors, capacitors and inductors folded into it
+    double expansion_point = 0;//s0 of the moments
+};
+enum ac_sweep{
+    ac_linear = 0,//points in total
+    ac_decade,//points per decade
+    ac_octave,//points per octave
+};
+struct ac_report{
+    int points = 0;
+    int repivoted = 0;//points where the shared pivot order had to change
+    int threads = 1;
+    double elapsed = 0;//ms
+};
+struct sensitivity_entry{
+    QString component;
+    QString parameter;//resistance, capacitance, inductance, value, scale or gain
+    double value = 0;
+    double derivative = 0;//d output / d value
+    double normalized = 0;//value * derivative, the output change for a 100% change
+};
+struct sensitivity_report{
+    bool valid = false;
+    int node = 0;
+    double time = 0;//0 for the dc operating point
+    double output = 0;
+    int steps = 0;
+    int adjoint_solves = 0;
+    int factorizations = 0;//jacobians factored in the adjoint sweep
+    int reused_factorizations = 0;//adjoint steps solved on the factors kept from the forward run
+    int refinement_steps = 0;//corrections that brought those factors to the converged state
+    QVector<sensitivity_entry> table;//largest |normalized| first
+};
+struct structure_report{
+    bool singular = false;
+    int unknowns = 0;
+    int rank = 0;//structural rank of the transient pattern, A + E with the diode stamps
+    int dc_rank = 0;//capacitors open
+    int repivoted = 0;//columns where the factorization left the zero free diagonal
+    QVector<int> nodes;//node numbers in the deficient part
+    QVector<QString> components;
+    QVector<int> floating_nodes;//full pattern rank, but no path to ground other than current sources
+};
+struct state_space_system{
+    //E x' + A x = u(t) written as w' = F w + H u with one state w per capacitor/inductor row
+    bool valid = false;
+    Matrix E_w;//w = E_w * x
+    Matrix R;//x = R * w + Q * z
+    Matrix Q;
+    Matrix Y;//[w;z]' = Y [w;z], z holds the source waveforms
+    std::vector<int> square_slot;//z index of each square source, -1 otherwise
+    std::vector<int> sine_slot;//z index of cos(wt), sin(wt) follows
+    QVector<QPair<double,Matrix>> propagators;//step size, exp(Y*h)
+};
 class Circuit
 {
     private:
@@ -51,7 +315,7 @@ class Circuit
         QVector<Voltage_control_current_source*>allVCCS;
         QVector<Voltage_control_voltage_source*>allVCVS;
         QVector<Diode*>allDiode;
-        QVector<LineNodeitem*> allLine;
+        QVector<NodeLine*> allLine;
         QVector<Ground* > allGround;
         QVector<int> nowSelectedItem;
         //QVector<Matrix> solutions;
@@ -61,38 +325,175 @@ class Circuit
 
         circuit_Matrixsystem sys;
         int state;
+        int newton;
+        double chord_contraction;
+        double newton_accuracy;//largest update that ends a transient newton solve
+        LU_factor jacobian_lu;
+        double jacobian_timestep;
+        bool keep_jacobians;//transient keeps the newton factors of every accepted step
+        QVector<LU_factor> kept_jacobians;//one per accepted step, singular where none fits
+        newton_statistics newton_stat;
+        bool schur_reduction;
+        QVector<schur_system> schur_cache;
         Matrix get_jacobian(Matrix last_state,double timestep);
+        schur_system& get_schur_system(const Matrix &A,double timestep);
+        bool solve_schur(const Matrix &A,const Matrix &b,const Matrix &guess,double timestep,Matrix &ans,int max_iterations = -1);
+        bool solve_reduced_newton(Matrix &S,const Matrix &b,Matrix &x,const std::vector<int> &node1,const std::vector<int> &node2,int max_iterations);
+        int predictor_order;
+        Matrix predict_state(double time);
+        void stamp_diode_current(Matrix &non_linear,const Matrix &state);
+        void stamp_diode_conductance(Matrix &J,const Matrix &state);
+        bool device_bypass;
+        double bypass_tolerance;
+        diode_batch diodes;
+        void evaluate_diodes(const Matrix &state,const std::vector<int> &node1,const std::vector<int> &node2);
+        ThreadPool* pool;
+        int assembly_threads;
+        QVector<QVector<int>> diode_colors;//diodes of one color share no node
+        QVector<QVector<int>> current_source_colors;
+        void parallel_for(int n,const std::function<void(int,int)>& body);
+        static QVector<QVector<int>> color_footprints(const std::vector<int> &node1,const std::vector<int> &node2,int nodes);
+        bool structured_solver;
+        QVector<QPair<double,matrix_structure>> structure_cache;//per step size
+        bool equilibration;
+        int refinement_steps;
+        QVector<QPair<double,LU_factor>> lu_cache;//equilibrated general path, per step size
+        LU_factor factorize(const Matrix &A);//equilibrated when enabled, condition estimate into newton_stat
+        Matrix solve_linear(const Matrix &A,const Matrix &b,double timestep);
+        bool exponential_stepping;
+        state_space_system ss;
+        Matrix storage_matrix(std::vector<int> &rows);//E of E x' + A x = u
+        bool build_state_space();
+        Matrix& get_propagator(double h);
+        Matrix source_state(double t,double square_time);
+        bool analysis_exponential(double t,double max_timestep,const Matrix &x0);
+        pss_report pss_stat;
+        parareal_report parareal_stat;
+        bool owns_components;//false for solver copies, which share the components
+        SymbolTable<QString,qstring_hash> component_names;//controlled sources find their control by name
+        QVector<int> component_slot;//position in allComponent by name id
+        bool component_index_stale;//allComponent changed since index_component_names
+        QString unresolved;
+        void index_component_names();
+        bool check_controls();
+        int find_component(const QString &name);//position in allComponent, -1 when there is none
+        Circuit* solver_copy();
+        void transient(double t0,double t1,double min_timestep,double max_timestep,bool exact_end);
+        Matrix step_state(const Matrix& last_state,double timestep,double current_time,const Matrix* guess);
+        relaxation_block block;
+        relaxation_report relaxation_stat;
+        double relaxation_resistance;
+        int relaxation_mode;
+        QVector<std::vector<int>> partition_unknowns();
+        Matrix update_block(const Matrix& last_state,double timestep,double current_time,const Matrix* guess);
+        reduced_model rom;
+        reduction_report reduction_stat;
+        int reduction_moments;
+        int reduction_max_size;
+        QVector<int> probed_nodes;
+        void build_reduced_model();
+        Matrix update_reduced(const Matrix& last_state,double timestep,double current_time,const Matrix* guess);
+        static double waveform_value(const QVector< QPair<Matrix,double> > &wave,double t,int row);
+        double source_period();
+        QVector< QPair<Matrix,double> > ac_magnitude;//|x|, frequency
+        QVector< QPair<Matrix,double> > ac_phase;//degrees, frequency
+        ac_report ac_stat;
+        sensitivity_report sensitivity_stat;
+        void accumulate_sensitivity(const Matrix &lambda,const Matrix &x,const Matrix *x_old,double timestep,double time,std::vector<double> &gradient);
+        dc_report dc_stat;
+        structure_report structure_stat;
+        std::vector<int> pivot_order;//zero free diagonal from check_structure, row of every column
+        QVector< QPair<Matrix,double> > dc_sweep_solutions;//ans, swept value
+        dc_sweep_report dc_sweep_stat;
+        QVector<step_run> step_runs;
+        step_report step_stat;
+        QPair<int,int> find_valued_component(const QString &name);//valued_component and list index, -1 if missing
+        double component_value(const QPair<int,int> &target);
+        void set_component_value(const QPair<int,int> &target,double value);
+        Circuit* private_copy(const QVector<QPair<int,int>> &targets,QVector<Component*> &made);
+        int run_on_copies(int n,const QVector<QPair<int,int>> &targets,const std::function<void(Circuit*,int)> &run);//returns the copies built
+        const matrix_structure* shared_structure;//pattern analysis of the parent, same topology for every copy
+        monte_carlo_report monte_carlo_stat;
+        double dc_stage_budget;
+        bool build_dc_system(Matrix &A,Matrix &b);
+        bool solve_dc_newton(const Matrix &A,const Matrix &b,Matrix &x,double gmin,QElapsedTimer &timer,int &iterations);
     public:
 
         Circuit();
+        Circuit(const Circuit&) = delete;//owns the pool, copies go through solver_copy
+        Circuit& operator=(const Circuit&) = delete;
         QVector<Component *> getAllComponent();
         QVector<Ground* > getAllground();
         QVector<int> getNowSelectedItem();
-        QVector<LineNodeitem *> getAllLine();
+        QVector<NodeLine *> getAllLine();
         const QVector< QPair<Matrix,double> >& get_solutions();
         void setNowSelectedItem(int index);
         void updatedelete();
-        void Input();
         void analysis_circuit_connection();
+        void netlist_connection(int node_count);//node indices set by a netlist reader, node_count includes ground
         void ini_sys();
-        Matrix update_sys(const Matrix& last_state,double timestep,double current_time); // when analysis
+        Matrix update_sys(const Matrix& last_state,double timestep,double current_time,const Matrix* guess = nullptr); // when analysis
         void analysis(double t,double maxtimestep  = -1);
+        bool pss_analysis(double period = -1,int steps_per_period = 200);//steady state period in solutions
+        const pss_report& get_pss_report();
+        bool parareal_analysis(double t,int slices = 0,double maxtimestep = -1);//0 slices: one per thread, at least 4
+        const parareal_report& get_parareal_report();
+        bool relaxation_analysis(double t,int max_sweeps = 20,double maxtimestep = -1);//partitioned at weak couplings
+        const relaxation_report& get_relaxation_report();
+        void set_relaxation_coupling(double resistance);//resistors from this value up split partitions
+        void set_relaxation_sweep(int mode);
+        bool get_excitation(QString source,Matrix &column);//b for a unit value of one independent source
+        Matrix solve_excitations(const Matrix &U,double timestep = 0);//n x N solutions of a linear circuit for N columns of b
+        bool ac_analysis(QString source,double f_start,double f_stop,int points,int sweep = ac_decade);//small signal around dc_analysis()
+        const QVector< QPair<Matrix,double> >& get_ac_magnitude();
+        const QVector< QPair<Matrix,double> >& get_ac_phase();
+        const ac_report& get_ac_report();
+        bool sensitivity_analysis(int node,double t = 0,double maxtimestep = -1);//d V(node, t) for every element value, t = 0 at the operating point
+        const sensitivity_report& get_sensitivity_report();
         Matrix dc_analysis();
+        Matrix dc_operating_point(const Matrix &A,const Matrix &b,const Matrix &guess);
+        void set_dc_time_budget(double ms);
+        const dc_report& get_dc_report();
+        bool dc_sweep(QString component,double start,double stop,int points);//resistor or independent source, warm started
+        const QVector< QPair<Matrix,double> >& get_dc_sweep();//one row per requested point
+        const dc_sweep_report& get_dc_sweep_report();
+        bool step_analysis(const QVector<step_parameter> &steps,double t,double maxtimestep = -1);//a transient for every combination, in parallel
+        const QVector<step_run>& get_step_runs();
+        const step_report& get_step_report();
+        //t = 0: dc trials, otherwise transients; only the probe measurements of every trial are kept
+        bool monte_carlo_analysis(const QVector<tolerance_spec> &tolerances,const QVector<monte_carlo_probe> &probes,int trials,double t = 0,double maxtimestep = -1,unsigned seed = 1,int bins = 20);
+        const monte_carlo_report& get_monte_carlo_report();
         double calculate_maxtimestep();
-        void update_A_b(Matrix &A,Matrix &b,Matrix last_state,double timestep,double current_time);
+        void update_A_b(Matrix &A,Matrix &b,const Matrix &last_state,double timestep,double current_time);
         //QVector<Matrix> analysis_circuit_timeinterval(double t);
         //Matrix analysis_circuit(double t,double timestep);
         void sort_the_allcomponent();
+        bool check_structure();//maximum matching on the mna pattern, false and singular_structure when it is rank deficient
+        const structure_report& get_structure_report();
         void push_backComponent(Component *);
         void push_backGround(Ground*);
-        void push_backLine(LineNodeitem *);
+        void push_backLine(NodeLine *);
         void deleteComponent(int index);
         void deleteAllComponent();
         void resetAllNodeIndex();
         void find_initial_condition();
         int get_circuit_state();
+        void set_newton_mode(int mode,double contraction = 0.5);
+        void set_schur_reduction(bool on);
+        void set_predictor_order(int order);
+        void set_device_bypass(bool on,double tolerance = 1e-6);
+        void set_assembly_threads(int threads);//0 = all cores, 1 (the default) runs without a pool
+        void set_structured_solver(bool on);//cholesky, banded and tridiagonal paths for linear steps
+        void set_equilibration(bool on,int refinement_steps = 0);//scaled lu for the general path and newton, refinement for linear steps
+        void set_exponential_stepping(bool on);//exact stepping for circuits without diodes, off: adaptive backward euler
+        void set_model_reduction(int moments,int max_size = -1,const QVector<int> &probes = QVector<int>());//0 moments = off
+        const reduction_report& get_reduction_report();
+        int get_assembly_threads();
+        const newton_statistics& get_newton_statistics();
+        void report_newton_statistics();
         int getDependantNode(QString a);
         Component* getDependantBranch(QString a);
+        const QString& get_unresolved_control();//reference of the first control that did not resolve
         ~Circuit();
 };
 
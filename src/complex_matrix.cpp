@@ -0,0 +1,120 @@
+#include "complex_matrix.h"
+#include <QDebug>
+#include <algorithm>
+
+static const double pivot_threshold = 0.1;
+
+ComplexMatrix::ComplexMatrix():row(1),col(1),data(1)
+{
+}
+ComplexMatrix::ComplexMatrix(int r,int c):row(r),col(c),data(r*c)
+{
+}
+void ComplexMatrix::add_ij(int i,int j,std::complex<double> add_value)
+{
+    //ground (-1) is dropped like in Matrix
+    if(i<0 || j<0 || i>=row || j>=col)
+        return;
+    data[i*col+j] += add_value;
+}
+void ComplexMatrix::set_ij(int i,int j,std::complex<double> set_value)
+{
+    if(i<0 || j<0 || i>=row || j>=col)
+        return;
+    data[i*col+j] = set_value;
+}
+int ComplexMatrix::get_row_num()const
+{
+    return row;
+}
+int ComplexMatrix::get_col_num()const
+{
+    return col;
+}
+std::complex<double> ComplexMatrix::operator()(int i,int j)const
+{
+    if(i<0 || j<0 || i>=row || j>=col)
+        return 0;
+    return data[i*col+j];
+}
+complex_LU_factor ComplexMatrix::lu_factorize(const std::vector<int>* order)const
+{
+    complex_LU_factor f;
+    if(row!=col){
+        qDebug()<<"Row col not matching";
+        return f;
+    }
+    int n = row;
+    if(order && (int)order->size()!=n)
+        order = nullptr;
+    f.LU = *this;
+    f.perm.resize(n);
+    std::vector<int> where(n);//current position of every original row
+    for(int i=0;i<n;i++){
+        f.perm[i] = i;
+        where[i] = i;
+    }
+    std::complex<double> *lu = f.LU.data.data();
+    for(int k=0;k<n;k++){
+        int p = k;
+        double largest = 0;
+        for(int i=k;i<n;i++){
+            double a = std::abs(lu[i*n+k]);
+            if(a>largest){
+                largest = a;
+                p = i;
+            }
+        }
+        if(largest==0)
+            return f;
+        if(order){
+            int q = where[(*order)[k]];
+            if(q>=k && std::abs(lu[q*n+k])>=pivot_threshold*largest)
+                p = q;
+            else
+                f.repivoted++;
+        }
+        if(p!=k){
+            std::swap_ranges(lu+p*n,lu+p*n+n,lu+k*n);
+            std::swap(f.perm[p],f.perm[k]);
+            where[f.perm[p]] = p;
+            where[f.perm[k]] = k;
+        }
+        std::complex<double> pivot = lu[k*n+k];
+        for(int i=k+1;i<n;i++){
+            if(lu[i*n+k]==0.0)
+                continue;
+            std::complex<double> s = lu[i*n+k]/pivot;
+            lu[i*n+k] = s;
+            for(int j=k+1;j<n;j++)
+                lu[i*n+j] -= s*lu[k*n+j];
+        }
+    }
+    f.singular = false;
+    return f;
+}
+ComplexMatrix ComplexMatrix::lu_solve(const complex_LU_factor& f,const ComplexMatrix& b)
+{
+    int n = f.LU.row;
+    if(f.singular || b.row!=n){
+        qDebug()<<"singular or not matching factorization";
+        return ComplexMatrix(n,b.col);
+    }
+    const std::complex<double> *lu = f.LU.data.data();
+    ComplexMatrix ans(n,b.col);
+    for(int c=0;c<b.col;c++){
+        for(int i=0;i<n;i++){
+            std::complex<double> s = b.data[f.perm[i]*b.col+c];
+            for(int j=0;j<i;j++)
+                s -= lu[i*n+j]*ans.data[j*b.col+c];
+            ans.data[i*b.col+c] = s;
+        }
+        for(int i=n-1;i>=0;i--){
+            std::complex<double> s = ans.data[i*b.col+c];
+            for(int j=i+1;j<n;j++)
+                s -= lu[i*n+j]*ans.data[j*b.col+c];
+            ans.data[i*b.col+c] = s/lu[i*n+i];
+        }
+    }
+    return ans;
+}
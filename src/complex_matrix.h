@@ -0,0 +1,35 @@
+#ifndef COMPLEX_MATRIX_H
+#define COMPLEX_MATRIX_H
+#include <vector>
+#include <complex>
+struct complex_LU_factor;
+//dense complex matrix for the frequency domain, row major
+class ComplexMatrix
+{
+    private:
+        int row;
+        int col;
+        std::vector< std::complex<double> > data;
+    public:
+        ComplexMatrix();
+        ComplexMatrix(int r,int c);
+        void add_ij(int i,int j,std::complex<double> add_value);
+        void set_ij(int i,int j,std::complex<double> set_value);
+        int get_row_num()const;
+        int get_col_num()const;
+
+        std::complex<double> operator()(int i,int j)const;
+
+        //PA = LU, order is a pivot sequence from an earlier factorization of the same pattern
+        //its pivots are kept while they stay within pivot_threshold of the column max
+        complex_LU_factor lu_factorize(const std::vector<int>* order = nullptr)const;
+        static ComplexMatrix lu_solve(const complex_LU_factor& f,const ComplexMatrix& b);
+};
+struct complex_LU_factor{
+    ComplexMatrix LU;//L below the diagonal (unit diagonal), U on and above
+    std::vector<int> perm;//row i of LU is row perm[i] of A
+    bool singular = true;
+    int repivoted = 0;//columns where the given order was rejected
+};
+
+#endif // COMPLEX_MATRIX_H
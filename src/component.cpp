@@ -20,15 +20,13 @@
 
 Component::Component()
 {
-
+    image = nullptr;
+    currentRotateAngle = 0;
 }
 
-Component::Component(const QString &s, QRect &r,QGraphicsScene *sc)
+Component::Component(ComponentView *view)
 {
-    image = new ImageItem(s,r);
-    scene = sc;
-    sc->addItem(image);
-
+    image = view;
     currentRotateAngle = 0;
 
     //setPos(100,100);
@@ -37,7 +35,8 @@ Component::Component(const QString &s, QRect &r,QGraphicsScene *sc)
 void Component::setName(const QString &s)
 {
     name = s;
-    image->setName(s);
+    if(image)
+        image->setName(s);
     //qDebug()<<name;
 }
 
@@ -124,7 +123,7 @@ double  Component::getReactance()
 
 void Component::setPos(int x,int y)
 {
-    image->setPos(x,y);
+    image->moveTo(x,y);
 
     //
 
@@ -132,10 +131,6 @@ void Component::setPos(int x,int y)
 void Component::Delete()
 {
 
-}
-void Component::InputValue()
-{
-
 }
 bool Component::isDependant()
 {
@@ -145,13 +140,13 @@ const QString& Component::getname()const
 {
     return name;
 }
-ImageItem* Component::getimage()const
+ComponentView* Component::getimage()const
 {
     return image;
 }
 void Component::setPos(QPoint& p )
 {
-    image->setPos(p);
+    image->moveTo(p.x(),p.y());
 }
 void Component::setNodeRotation(int rotateA)
 {
@@ -1,22 +1,22 @@
 #ifndef COMPONENT_H
 #define COMPONENT_H
 #include <QString>
-#include <QGraphicsScene>
-#include "imageItem.h"
+#include <QVector>
+#include <QDebug>
+#include "componentview.h"
 #include "node.h"
 class Component
 {
     private:
         QString name;
     protected:
-        ImageItem *image;
-        QGraphicsScene* scene;
+        ComponentView *image;//owned, nullptr without a schematic
         QVector<Node*> nodes;
         int currentRotateAngle;
         double reactance;           //Z
     public:
         Component();
-        Component(const QString &s, QRect &r,QGraphicsScene *sc);
+        Component(ComponentView *view);
         void setName(const QString &);
         void setImage(const QString &);
         void setRect(QRect &r);
@@ -29,17 +29,16 @@ class Component
         int getCurrentRotateAngle();
         bool connect_the_node(Node &n);
         const QString& getname()const;
-        ImageItem* getimage()const;
+        ComponentView* getimage()const;
         QVector<Node*>& getNodes();
         void resetNodeIndex();     
         virtual void setPos(int x,int y);
         virtual void setPos(QPoint& p);
         virtual void setNodeRotation(int rotateA);
         virtual void Delete();
-        virtual void InputValue();
         virtual bool isDependant();
         bool judgeSelectItem(QRect &r);
-        ~Component();
+        virtual ~Component();
 };
 
 #endif // COMPONENT_H
@@ -0,0 +1,104 @@
+#include "componenteditor.h"
+#include "imageItem.h"
+#include "resistor.h"
+#include "capacitor.h"
+#include "inductor.h"
+#include "diode.h"
+#include "voltage_source.h"
+#include "current_source.h"
+#include "current_control_current_source.h"
+#include "current_control_voltage_source.h"
+#include "voltage_control_current_source.h"
+#include "voltage_control_voltage_source.h"
+#include "resistordialog.h"
+#include "capacitordialog.h"
+#include "inductordialog.h"
+#include "diado_dialog.h"
+#include "voltagesourcedialog.h"
+#include "currentsourcedialog.h"
+#include "current_control_current_source_dialog.h"
+#include "current_control_voltage_source_dialog.h"
+#include "voltage_control_current_source_dialog.h"
+#include "voltage_control_voltage_source_dialog.h"
+
+//the dialog stays with the symbol, so reopening it shows the last input
+template<class T>
+static T* dialog_of(ImageItem *image)
+{
+    T* d = dynamic_cast<T*>(image->getDialog());
+    if(!d){
+        d = new T();
+        d->setModal(true);
+        image->setDialog(d);
+    }
+    return d;
+}
+
+void ComponentEditor::edit(Component *c)
+{
+    ImageItem *image = dynamic_cast<ImageItem*>(c->getimage());
+    if(!image || !image->getInput())
+        return;
+    if(Resistor *r = dynamic_cast<Resistor*>(c)){
+        Resistordialog *d = dialog_of<Resistordialog>(image);
+        d->exec();
+        r->setInputValue(d->getInput());
+    }else if(Capacitor *cap = dynamic_cast<Capacitor*>(c)){
+        Capacitordialog *d = dialog_of<Capacitordialog>(image);
+        d->exec();
+        cap->setInputValue(d->getInput());
+    }else if(Inductor *l = dynamic_cast<Inductor*>(c)){
+        Inductordialog *d = dialog_of<Inductordialog>(image);
+        d->exec();
+        l->setInputValue(d->getInput());
+    }else if(Diode *diode = dynamic_cast<Diode*>(c)){
+        Diado_dialog *d = dialog_of<Diado_dialog>(image);
+        d->exec();
+        diode->setInputValue(d->getInput());
+    }else if(voltage_source *v = dynamic_cast<voltage_source*>(c)){
+        Voltagesourcedialog *d = dialog_of<Voltagesourcedialog>(image);
+        d->exec();
+        voltageSourcedata data;
+        double frequency;
+        int mode;
+        d->getInput(data,frequency,mode);
+        v->setInputValue(data,frequency,mode);
+    }else if(current_source *i = dynamic_cast<current_source*>(c)){
+        Currentsourcedialog *d = dialog_of<Currentsourcedialog>(image);
+        d->exec();
+        currentSourcedata data;
+        double frequency;
+        int mode;
+        d->getInput(data,frequency,mode);
+        i->setInputValue(data,frequency,mode);
+    }else if(Current_control_current_source *cccs = dynamic_cast<Current_control_current_source*>(c)){
+        Current_control_current_source_dialog *d = dialog_of<Current_control_current_source_dialog>(image);
+        d->exec();
+        double coefficient;
+        QString branch;
+        d->getInput(coefficient,branch);
+        cccs->setInputValue(coefficient,branch);
+    }else if(Current_control_voltage_source *ccvs = dynamic_cast<Current_control_voltage_source*>(c)){
+        Current_control_voltage_source_dialog *d = dialog_of<Current_control_voltage_source_dialog>(image);
+        d->exec();
+        double coefficient;
+        QString branch;
+        d->getInput(coefficient,branch);
+        ccvs->setInputValue(coefficient,branch);
+    }else if(Voltage_control_current_source *vccs = dynamic_cast<Voltage_control_current_source*>(c)){
+        Voltage_control_current_source_dialog *d = dialog_of<Voltage_control_current_source_dialog>(image);
+        d->exec();
+        double coefficient;
+        QString node1,node2;
+        d->getInput(coefficient,node1,node2);
+        vccs->setInputValue(coefficient,node1,node2);
+    }else if(Voltage_control_voltage_source *vcvs = dynamic_cast<Voltage_control_voltage_source*>(c)){
+        Voltage_control_voltage_source_dialog *d = dialog_of<Voltage_control_voltage_source_dialog>(image);
+        d->exec();
+        double coefficient;
+        QString node1,node2;
+        d->getInput(coefficient,node1,node2);
+        vcvs->setInputValue(coefficient,node1,node2);
+    }
+    image->setInput(false);
+}
@@ -0,0 +1,13 @@
+#ifndef COMPONENTEDITOR_H
+#define COMPONENTEDITOR_H
+
+#include "component.h"
+
+//value dialogs of the schematic, the simulation classes only see the values they return
+class ComponentEditor
+{
+public:
+    static void edit(Component *c);//runs the dialog of c when its symbol is marked for input
+};
+
+#endif // COMPONENTEDITOR_H
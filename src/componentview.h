@@ -0,0 +1,23 @@
+#ifndef COMPONENTVIEW_H
+#define COMPONENTVIEW_H
+#include <QString>
+#include <QRect>
+
+//schematic symbol of a component, ImageItem draws it in the gui, headless components have none
+class ComponentView
+{
+    public:
+        virtual void setPixmap(const QString &s) = 0;
+        virtual void setRect(const QRect &r) = 0;
+        virtual void setName(const QString &s) = 0;
+        virtual void setCharacteristic(const QString &c) = 0;
+        virtual void moveTo(int x,int y) = 0;
+        virtual void rotate90(int rotateA) = 0;
+        virtual void Delete() = 0;
+        virtual void setInput(bool) = 0;
+        virtual bool getDelete() = 0;
+        virtual bool getInput() = 0;
+        virtual ~ComponentView(){}
+};
+
+#endif // COMPONENTVIEW_H
@@ -6,7 +6,7 @@ Current_control_current_source::Current_control_current_source()
     nodes.push_back(new Node());
 }
 
-Current_control_current_source::Current_control_current_source(const QString &s,QRect &r,QGraphicsScene *sc):Component(s,r,sc)
+Current_control_current_source::Current_control_current_source(ComponentView *view,QRect &r):Component(view)
 {
     nodes.push_back(new Node());
     nodes.push_back(new Node());
@@ -27,8 +27,6 @@ Current_control_current_source::Current_control_current_source(const QString &s,
 
     setName(QString("CCIS")+QString::number(num+1));
     image->setCharacteristic(QString("IS"));
-    current_control_current_source_dialog = new Current_control_current_source_dialog();
-    current_control_current_source_dialog->setModal(true);
 }
 double Current_control_current_source::getCoefficient()
 {
@@ -48,19 +46,17 @@ bool Current_control_current_source::isDependant()
 {
     return true;
 }
-void Current_control_current_source::InputValue()
+void Current_control_current_source::setInputValue(double coefficient_value,const QString &branch)
 {
-    current_control_current_source_dialog->exec();
-    current_control_current_source_dialog->getInput(coefficient,branchName);
+    coefficient = coefficient_value;
+    branchName = branch;
     qDebug() << coefficient;
     qDebug() << branchName;
-    image->setInput(false);
-    image->setCharacteristic(QString::number(coefficient) + branchName);
-
+    if(image)
+        image->setCharacteristic(QString::number(coefficient) + branchName);
 }
 Current_control_current_source::~Current_control_current_source()
 {
-    delete current_control_current_source_dialog;
 }
 const QPair<Node*,Node*> Current_control_current_source::getNodePos()
 {
@@ -81,13 +77,13 @@ QString Current_control_current_source::getDependantBranchName()
 }
 void Current_control_current_source::setPos(int x,int y)
 {
-    image->setPos(x,y);
+    image->moveTo(x,y);
     nodes[0]->setPosition(x,y+  rect.height()/2);
     nodes[1]->setPosition(x+rect.width(),y+rect.height()/2);
 }
 void Current_control_current_source::setPos(QPoint& p)
 {
-    image->setPos(p.x(),p.y());
+    image->moveTo(p.x(),p.y());
     nodes[0]->setPosition(p.x(),p.y() + rect.height()/2);
     nodes[1]->setPosition(p.x()+rect.width(),p.y()+rect.height()/2);
 }
@@ -6,7 +6,7 @@ Current_control_voltage_source::Current_control_voltage_source()
     nodes.push_back(new Node());
 }
 
-Current_control_voltage_source::Current_control_voltage_source(const QString &s,QRect &r,QGraphicsScene *sc):Component(s,r,sc)
+Current_control_voltage_source::Current_control_voltage_source(ComponentView *view,QRect &r):Component(view)
 {
     nodes.push_back(new Node());
     nodes.push_back(new Node());
@@ -27,8 +27,6 @@ Current_control_voltage_source::Current_control_voltage_source(const QString &s,
 
     setName(QString("CCVS")+QString::number(num+1));
     image->setCharacteristic(QString("IS"));
-    current_control_voltage_source_dialog = new Current_control_voltage_source_dialog();
-    current_control_voltage_source_dialog->setModal(true);
 }
 void Current_control_voltage_source::Delete()
 {
@@ -44,16 +42,15 @@ bool Current_control_voltage_source::isDependant()
 {
     return true;
 }
-void Current_control_voltage_source::InputValue()
+void Current_control_voltage_source::setInputValue(double coefficient_value,const QString &branch)
 {
-    current_control_voltage_source_dialog->exec();current_control_voltage_source_dialog->getInput(coefficient,branchName);
-    image->setInput(false);
-    image->setCharacteristic(QString::number(coefficient) + branchName);
-
+    coefficient = coefficient_value;
+    branchName = branch;
+    if(image)
+        image->setCharacteristic(QString::number(coefficient) + branchName);
 }
 Current_control_voltage_source::~Current_control_voltage_source()
 {
-    delete current_control_voltage_source_dialog;
 }
 const QPair<Node*,Node*> Current_control_voltage_source::getNodePos()
 {
@@ -78,13 +75,13 @@ QString Current_control_voltage_source::getDependantBranchName()
 }
 void Current_control_voltage_source::setPos(int x,int y)
 {
-    image->setPos(x,y);
+    image->moveTo(x,y);
     nodes[0]->setPosition(x,y+  rect.height()/2);
     nodes[1]->setPosition(x+rect.width(),y+rect.height()/2);
 }
 void Current_control_voltage_source::setPos(QPoint& p)
 {
-    image->setPos(p.x(),p.y());
+    image->moveTo(p.x(),p.y());
     nodes[0]->setPosition(p.x(),p.y() + rect.height()/2);
     nodes[1]->setPosition(p.x()+rect.width(),p.y()+rect.height()/2);
 }
@@ -3,7 +3,6 @@
 
 #include "component.h"
 #include "node.h"
-#include "current_control_voltage_source_dialog.h"
 #include "Constant.h"
 
 class Current_control_voltage_source : public Component
@@ -15,12 +14,11 @@ private:
     QRect rect;
     int num;
     static QVector<bool> num_list; //1 for exist 0 for not
-    Current_control_voltage_source_dialog *current_control_voltage_source_dialog;
     int mode;
     enum mode{DC,Sine,Square};
 public:
     Current_control_voltage_source();
-    Current_control_voltage_source(const QString &s,QRect &r,QGraphicsScene *sc);
+    Current_control_voltage_source(ComponentView *view,QRect &r);
     const QPair<Node*,Node*> getNodePos();
     int getNodeindex1();//-
     int getNodeindex2();//+
@@ -31,7 +29,7 @@ public:
     void setPos(QPoint& p);
     void setNodeRotation(int rotateA);
     void Delete();
-    void InputValue();
+    void setInputValue(double coefficient_value,const QString &branch);//coefficient and the controlling branch
     bool isDCsource();
     bool isDependant();
     ~Current_control_voltage_source();
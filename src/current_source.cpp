@@ -5,7 +5,7 @@ current_source::current_source()
     nodes.push_back(new Node());
     nodes.push_back(new Node());
 }
-current_source::current_source(const QString &s,QRect &r,QGraphicsScene *sc):Component(s,r,sc)
+current_source::current_source(ComponentView *view,QRect &r):Component(view)
 {
     nodes.push_back(new Node());
     nodes.push_back(new Node());
@@ -26,8 +26,6 @@ current_source::current_source(const QString &s,QRect &r,QGraphicsScene *sc):Com
 
     setName(QString("IS")+QString::number(num+1));
     image->setCharacteristic(QString("IS"));
-    currentsourcedialog = new Currentsourcedialog();
-    currentsourcedialog->setModal(true);
 
 
 }
@@ -41,16 +39,37 @@ bool current_source::isDCsource()
         return true;
     return false;
 }
+bool current_source::isSquaresource()
+{
+    if(mode == Square)
+        return true;
+    return false;
+}
+double current_source::getNextBreakpoint(double t)
+{
+    if(mode != Square)
+        return INFINITY;
+    double period = currentsourcedata.squareData.Tperiod;
+    double on = currentsourcedata.squareData.Ton;
+    double start = floor(t/period)*period;
+    //each period starts with the on phase, same as get_current
+    if(start+on>t+1e-12*period)
+        return start+on;
+    if(start+period>t+1e-12*period)
+        return start+period;
+    return start+period+on;
+}
 bool current_source::isDependant()
 {
     return false;
 }
-void current_source::InputValue()
+void current_source::setInputValue(const currentSourcedata &data,double source_frequency,int source_mode)
 {
-    currentsourcedialog->exec();
-    //currentsourcedialog->getInput(curDCorAmporIon,offsetDCorIoff,frequencyorTperiod,phaseorTon,mode);
-    currentsourcedialog->getInput(currentsourcedata,frequency,mode);
-    image->setInput(false);
+    currentsourcedata = data;
+    frequency = source_frequency;
+    mode = source_mode;
+    if(!image)
+        return;
     if(mode == DC){
         image->setCharacteristic(QString::number(currentsourcedata.dcData.current));
     }else if(mode == Sine){
@@ -61,7 +80,6 @@ void current_source::InputValue()
 }
 current_source::~current_source()
 {
-    delete currentsourcedialog;
 }
 const QPair<Node*,Node*> current_source::getNodePos()
 {
@@ -78,7 +96,7 @@ int current_source::getNodeindex2()
 }
 void current_source::setPos(int x,int y)
 {
-    image->setPos(x,y);
+    image->moveTo(x,y);
     nodes[0]->setPosition(x,y+  rect.height()/2);
     nodes[1]->setPosition(x+rect.width(),y+rect.height()/2);
 
@@ -88,7 +106,7 @@ void current_source::setPos(int x,int y)
 }
 void current_source::setPos(QPoint& p)
 {
-    image->setPos(p.x(),p.y());
+    image->moveTo(p.x(),p.y());
     nodes[0]->setPosition(p.x(),p.y() + rect.height()/2);
     nodes[1]->setPosition(p.x()+rect.width(),p.y()+rect.height()/2);
 
@@ -123,6 +141,35 @@ double current_source::get_current(double t)
             break;
     }
 }
+double current_source::get_amplitude()
+{
+    if(mode == Sine)
+        return currentsourcedata.sineData.amplitude;
+    else if(mode == Square)
+        return currentsourcedata.squareData.Ion;
+    return currentsourcedata.dcData.current;
+}
+void current_source::set_amplitude(double value)
+{
+    if(mode == Sine)
+        currentsourcedata.sineData.amplitude = value;
+    else if(mode == Square)
+        currentsourcedata.squareData.Ion = value;
+    else
+        currentsourcedata.dcData.current = value;
+}
+current_source* current_source::solver_copy()const
+{
+    current_source* c = new current_source();
+    c->setName(getname());
+    c->num = num;
+    c->currentsourcedata = currentsourcedata;
+    c->frequency = frequency;
+    c->mode = mode;
+    for(int i=0;i<nodes.size();i++)
+        c->nodes[i]->setNodeIndex(nodes[i]->getNodeIndex());
+    return c;
+}
 double current_source::getFrequency()
 {
     return frequency;
@@ -3,7 +3,7 @@
 
 #include "component.h"
 #include "node.h"
-#include "currentsourcedialog.h"
+#include "sourcedata.h"
 #include "Constant.h"
 
 class current_source : public Component
@@ -12,7 +12,6 @@ class current_source : public Component
         QRect rect;
         int num;
         static QVector<bool> num_list; //1 for exist 0 for not
-        Currentsourcedialog *currentsourcedialog;
         currentSourcedata currentsourcedata;
         double frequency;
         int mode;
@@ -20,19 +19,24 @@ class current_source : public Component
 
     public:
         current_source();
-        current_source(const QString &s,QRect &r,QGraphicsScene *sc);
+        current_source(ComponentView *view,QRect &r);
         const QPair<Node*,Node*> getNodePos();
         int getNodeindex1();//-
         int getNodeindex2();//+
         double get_current(double t);
+        double get_amplitude();//dc value, sine amplitude or square on level
+        void set_amplitude(double value);
+        current_source* solver_copy()const;//waveform and node indices only, for runs on another thread
         double getFrequency();
         void Delete();
-        void InputValue();
+        void setInputValue(const currentSourcedata &data,double source_frequency,int source_mode);//what the source dialog returns
         double getValueTime(double t);
         void setPos(int x,int y);
         void setPos(QPoint& p);
         void setNodeRotation(int rotateA);
         bool isDCsource();
+        bool isSquaresource();
+        double getNextBreakpoint(double t);//next switching time after t, INFINITY if none
         bool isDependant();
         ~current_source();
 };
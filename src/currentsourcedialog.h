@@ -4,33 +4,7 @@
 #include <QDialog>
 #include <QLineEdit>
 #include <QLabel>
-
-struct currentDCdata
-{
-    double current;
-};
-
-struct currentSinedata
-{
-    double amplitude;
-    double offset;
-    double phase;
-};
-
-struct currentSquaredata
-{
-    double Ion;
-    double Ioff;
-    double Tperiod;
-    double Ton;
-};
-
-union currentSourcedata
-{
-    currentDCdata dcData;
-    currentSinedata sineData;
-    currentSquaredata squareData;
-};
+#include "sourcedata.h"
 
 namespace Ui {
 class Currentsourcedialog;
@@ -4,8 +4,9 @@ Diode::Diode()
 {
     nodes.push_back(new Node());
     nodes.push_back(new Node());
+    staturationCurrent = 1e-12;
 }
-Diode::Diode(const QString &s,QRect &r,QGraphicsScene *sc):Component(s,r,sc)
+Diode::Diode(ComponentView *view,QRect &r):Component(view)
 {
     rect = r;
     nodes.push_back(new Node());
@@ -28,9 +29,6 @@ Diode::Diode(const QString &s,QRect &r,QGraphicsScene *sc):Component(s,r,sc)
 
     setName(QString("D")+QString::number(num+1));
     image->setCharacteristic(QString("D"));
-
-    diado_dialog = new Diado_dialog();
-    diado_dialog->setModal(true);
 }
 void Diode::Delete()
 {
@@ -55,13 +53,13 @@ double Diode::get_Isat()
 }
 void Diode::setPos(int x,int y)
 {
-    image->setPos(x,y);
+    image->moveTo(x,y);
     nodes[0]->setPosition(x,y+  rect.height()/2);
     nodes[1]->setPosition(x+rect.width(),y+rect.height()/2);
 }
 void Diode::setPos(QPoint& p)
 {
-    image->setPos(p.x(),p.y());
+    image->moveTo(p.x(),p.y());
     nodes[0]->setPosition(p.x(),p.y() + rect.height()/2);
     nodes[1]->setPosition(p.x()+rect.width(),p.y()+rect.height()/2);
 }
@@ -90,12 +88,11 @@ void Diode::setNodeRotation(int rotateA)
             ;
     }
 }
-void Diode::InputValue()
+void Diode::setInputValue(const QString &input)
 {
-    diado_dialog->exec();
-    staturationCurrent = unit_transformer::transform(diado_dialog->getInput());
-    image->setCharacteristic(diado_dialog->getInput());
-    image->setInput(false);
+    staturationCurrent = unit_transformer::transform(input);
+    if(image)
+        image->setCharacteristic(input);
     qDebug() << staturationCurrent;
 }
 bool Diode::isDependant()
@@ -104,6 +101,5 @@ bool Diode::isDependant()
 }
 Diode::~Diode()
 {
-    delete diado_dialog;
 }
 QVector<bool> Diode::num_list;
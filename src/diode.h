@@ -3,7 +3,6 @@
 
 #include "component.h"
 #include "node.h"
-#include "diado_dialog.h"
 #include "Constant.h"
 
 class Diode : public Component
@@ -13,16 +12,15 @@ private:
     int num;
     static QVector<bool> num_list;
     double staturationCurrent;
-    Diado_dialog *diado_dialog;
 public:
     Diode();
-    Diode(const QString &s,QRect &r,QGraphicsScene *sc);
+    Diode(ComponentView *view,QRect &r);
     const QPair<Node*,Node*> getNodePos();
     int getNodeindex1();//-
     int getNodeindex2();//+
     double get_Isat();
+    void setInputValue(const QString &input);//saturation current as typed
     void Delete();
-    void InputValue();
     bool isDependant();
     void setPos(int x,int y);
     void setPos(QPoint& p);
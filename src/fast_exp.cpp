@@ -0,0 +1,96 @@
+#include "fast_exp.h"
+#include <cmath>
+#include <cstring>
+//the avx2 kernel is compiled for every x86 gcc/clang build and picked at run time,
+//so the default flags still give the vectorized path on machines that have it
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define FAST_EXP_AVX2
+#include <immintrin.h>
+#endif
+
+//exp(x) = 2^n * exp(r), n = round(x/ln2), |r| <= ln2/2
+//exp(r) by a degree 13 taylor polynomial, 2^n written straight into the exponent bits
+namespace {
+const double log2e = 1.4426950408889634074;
+const double ln2_hi = 6.93147180369123816490e-01;
+const double ln2_lo = 1.90821492927058770002e-10;
+const double round_magic = 6755399441055744.0;//1.5*2^52, adding it rounds to an integer
+const double exp_max = 709.782712893384;
+const double exp_min = -708.0;
+const double c[14] = {
+    1.0,1.0,1.0/2,1.0/6,1.0/24,1.0/120,1.0/720,1.0/5040,1.0/40320,1.0/362880,
+    1.0/3628800,1.0/39916800,1.0/479001600,1.0/6227020800.0
+};
+
+#ifdef FAST_EXP_AVX2
+//evaluates whole blocks of 4, returns how many were done
+__attribute__((target("avx2,fma")))
+int evaluate_avx2(const double* x,double* y,int n)
+{
+    int i = 0;
+    const __m256d v_log2e = _mm256_set1_pd(log2e);
+    const __m256d v_hi = _mm256_set1_pd(ln2_hi);
+    const __m256d v_lo = _mm256_set1_pd(ln2_lo);
+    const __m256d v_magic = _mm256_set1_pd(round_magic);
+    const __m256d v_max = _mm256_set1_pd(exp_max);
+    const __m256d v_min = _mm256_set1_pd(exp_min);
+    const __m256d v_inf = _mm256_set1_pd(INFINITY);
+    const __m256i v_bias = _mm256_set1_epi64x(1022);
+    for(;i+4<=n;i+=4){
+        __m256d v = _mm256_loadu_pd(x+i);
+        __m256d xc = _mm256_min_pd(_mm256_max_pd(v,v_min),v_max);
+        __m256d t = _mm256_fmadd_pd(xc,v_log2e,v_magic);
+        __m256d k = _mm256_sub_pd(t,v_magic);
+        __m256d r = _mm256_fnmadd_pd(k,v_hi,xc);
+        r = _mm256_fnmadd_pd(k,v_lo,r);
+        __m256d p = _mm256_set1_pd(c[13]);
+        for(int j=12;j>=0;j--)
+            p = _mm256_fmadd_pd(p,r,_mm256_set1_pd(c[j]));
+        //low bits of t hold n; scale by 2^(n-1) then 2 so n = 1024 stays finite
+        __m256i bits = _mm256_slli_epi64(_mm256_add_epi64(_mm256_castpd_si256(t),v_bias),52);
+        __m256d y4 = _mm256_mul_pd(_mm256_mul_pd(p,_mm256_castsi256_pd(bits)),_mm256_set1_pd(2.0));
+        y4 = _mm256_blendv_pd(y4,v_inf,_mm256_cmp_pd(v,v_max,_CMP_GT_OQ));
+        y4 = _mm256_blendv_pd(y4,_mm256_setzero_pd(),_mm256_cmp_pd(v,v_min,_CMP_LT_OQ));
+        //max/min above turned a nan into exp(-708), hand it back like exp() does
+        y4 = _mm256_blendv_pd(y4,v,_mm256_cmp_pd(v,v,_CMP_UNORD_Q));
+        _mm256_storeu_pd(y+i,y4);
+    }
+    return i;
+}
+bool has_avx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+}
+#endif
+}
+
+bool fast_exp::simd()
+{
+#ifdef FAST_EXP_AVX2
+    return has_avx2();
+#else
+    return false;
+#endif
+}
+void fast_exp::evaluate(const double* x,double* y,int n)
+{
+    int i = 0;
+#ifdef FAST_EXP_AVX2
+    if(has_avx2()){
+        i = evaluate_avx2(x,y,n);
+        //the tail runs through the same fma lanes, padded to a block, so every element rounds alike
+        if(i<n){
+            double in[4] = {0,0,0,0};
+            double out[4];
+            std::memcpy(in,x+i,(n-i)*sizeof(double));
+            evaluate_avx2(in,out,4);
+            std::memcpy(y+i,out,(n-i)*sizeof(double));
+        }
+        return;
+    }
+#endif
+    //without simd the library exp is faster than the polynomial
+    for(;i<n;i++)
+        y[i] = exp(x[i]);
+}
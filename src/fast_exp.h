@@ -0,0 +1,13 @@
+#ifndef FAST_EXP_H
+#define FAST_EXP_H
+
+class fast_exp
+{
+public:
+    //y[i] = exp(x[i]), relative error within 2.3e-16, overflow gives inf like exp()
+    //(the avx2 path flushes arguments below -708 to 0), nan stays nan
+    static void evaluate(const double* x,double* y,int n);
+    static bool simd();//true when evaluate runs the avx2 kernel on this cpu
+};
+
+#endif // FAST_EXP_H
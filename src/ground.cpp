@@ -2,14 +2,12 @@
 
 Ground::Ground():node()
 {
-
+    image = nullptr;
 }
 
-Ground::Ground(const QString &s,QRect &r,QGraphicsScene *sc):node()
+Ground::Ground(ComponentView *view,QRect &r):node()
 {
-    image = new ImageItem(s,r);
-    scene = sc;
-    sc->addItem(image);
+    image = view;
     rect = r;
     node.setVoltage(0);
 }
@@ -26,7 +24,7 @@ void Ground::setRect(QRect &r)
 
 void Ground::setPos(int x,int y)
 {
-    image->setPos(x,y);
+    image->moveTo(x,y);
     node.setPosition(x+rect.width()/2,y);
 }
 void Ground::setNodeIndex(int n)
@@ -63,7 +61,7 @@ const QPoint& Ground::getNodePos()
 }
 void Ground::setPos(QPoint& p )
 {
-    image->setPos(p);
+    image->moveTo(p.x(),p.y());
     node.setPosition(p.x()+rect.width()/2,p.y());
 }
 
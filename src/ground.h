@@ -2,19 +2,17 @@
 #define GROUND_H
 
 #include "node.h"
-#include <imageItem.h>
-#include <QGraphicsScene>
+#include "componentview.h"
 
 class Ground
 {
 private:
-    QGraphicsScene *scene;
     Node node;
-    ImageItem *image;
+    ComponentView *image;
     QRect rect;
 public:
     Ground();
-    Ground(const QString &s,QRect &r,QGraphicsScene *sc);
+    Ground(ComponentView *view,QRect &r);
     void setImage(const QString &);
     void Delete();
     bool getDelete();
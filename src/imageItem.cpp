@@ -11,6 +11,7 @@ ImageItem::ImageItem()
     QGraphicsItem::setAcceptHoverEvents(true);
     deleted = false;
     inputed = false;
+    dialog = nullptr;
     pixmap = nullptr;                  // مهم: مقداردهی
     rect = QRect(0, 0, 0, 0);
 }
@@ -24,6 +25,7 @@ ImageItem::ImageItem(const QString& s)
     QGraphicsItem::setAcceptHoverEvents(true);
     deleted = false;
     inputed = false;
+    dialog = nullptr;
 }
 
 ImageItem::ImageItem(const QString& s, const QRect &r)
@@ -35,6 +37,7 @@ ImageItem::ImageItem(const QString& s, const QRect &r)
     QGraphicsItem::setAcceptHoverEvents(true);
     deleted = false;
     inputed = false;
+    dialog = nullptr;
 }
 
 void ImageItem::setPixmap(const QString &s)
@@ -88,6 +91,11 @@ void ImageItem::rotate90(int rotateA)
     this->setTransform(trans);
 }
 
+void ImageItem::moveTo(int x,int y)
+{
+    setPos(x,y);
+}
+
 void ImageItem::Delete()
 {
     deleted = true;
@@ -110,6 +118,17 @@ bool ImageItem::getDelete()
     return deleted;
 }
 
+QDialog* ImageItem::getDialog()
+{
+    return dialog;
+}
+
+void ImageItem::setDialog(QDialog *d)
+{
+    delete dialog;
+    dialog = d;
+}
+
 void ImageItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* /*option*/, QWidget* /*widget*/)
 {
     if (!pixmap || pixmap->isNull()) return;   // جلوگیری از کرش
@@ -141,4 +160,5 @@ void ImageItem::mousePressEvent(QGraphicsSceneMouseEvent* e)
 ImageItem::~ImageItem()
 {
     delete pixmap;
+    delete dialog;
 }
@@ -7,10 +7,12 @@
 #include <QString>
 #include <QRect>
 #include <QDebug>
+#include <QDialog>
+#include "componentview.h"
 
 class Workspace;
 
-class ImageItem : public QGraphicsItem
+class ImageItem : public QGraphicsItem, public ComponentView
 {
     private:
         QPixmap *pixmap;
@@ -20,23 +22,27 @@ class ImageItem : public QGraphicsItem
         QString characteristic;
         bool deleted;
         bool inputed;
+        QDialog *dialog;//value dialog of the component, kept so it remembers the last input
     protected:
         void mousePressEvent(QGraphicsSceneMouseEvent*)override;
     public:
         ImageItem();
         ImageItem(const QString& s);
         ImageItem(const QString& s,const QRect &r);
-        void setPixmap(const QString &s);
-        void setRect(const QRect &r);
-        void setName(const QString &s);
-        void setCharacteristic(const QString &c);
+        void setPixmap(const QString &s)override;
+        void setRect(const QRect &r)override;
+        void setName(const QString &s)override;
+        void setCharacteristic(const QString &c)override;
+        void moveTo(int x,int y)override;
         QString getimagePath();
         const QRect& getRect();
-        void rotate90(int rotateA);
-        void Delete();
-        void setInput(bool);
-        bool getDelete();
-        bool getInput();
+        void rotate90(int rotateA)override;
+        void Delete()override;
+        void setInput(bool)override;
+        bool getDelete()override;
+        bool getInput()override;
+        QDialog* getDialog();
+        void setDialog(QDialog *d);
         void paint( QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)override;
         QRectF boundingRect()const override;
         ~ImageItem();
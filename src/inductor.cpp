@@ -5,7 +5,7 @@ Inductor::Inductor()
 
 }
 
-Inductor::Inductor(const QString &s,QRect &r,QGraphicsScene *sc):RLCComponent(s,r,sc)
+Inductor::Inductor(ComponentView *view,QRect &r):RLCComponent(view,r)
 {
     bool find = false;
     for(int i=0;i<num_list.size();i++){
@@ -23,8 +23,6 @@ Inductor::Inductor(const QString &s,QRect &r,QGraphicsScene *sc):RLCComponent(s,
 
     setName(QString("L")+QString::number(num+1));
     image->setCharacteristic(QString("L"));
-    inductordialog = new Inductordialog();
-    inductordialog->setModal(true);
 }
 void setReactance()
 {
@@ -34,16 +32,29 @@ double Inductor::getInductance()
 {
     return inductance;
 }
+void Inductor::setInductance(double value)
+{
+    inductance = value;
+}
+Inductor* Inductor::solver_copy()const
+{
+    Inductor* c = new Inductor();
+    c->setName(getname());
+    c->inductance = inductance;
+    c->num = num;
+    for(int i=0;i<nodes.size();i++)
+        c->nodes[i]->setNodeIndex(nodes[i]->getNodeIndex());
+    return c;
+}
 void Inductor::Delete()
 {
     num_list[num] = 0;
 }
-void Inductor::InputValue()
+void Inductor::setInputValue(const QString &input)
 {
-    inductordialog->exec();
-    inductance = unit_transformer::transform(inductordialog->getInput());
-    image->setCharacteristic(inductordialog->getInput());
-    image->setInput(false);
+    inductance = unit_transformer::transform(input);
+    if(image)
+        image->setCharacteristic(input);
     qDebug() << inductance;
 }
 bool Inductor::isDependant()
@@ -52,6 +63,5 @@ bool Inductor::isDependant()
 }
 Inductor::~Inductor()
 {
-    delete inductordialog;
 }
 QVector<bool> Inductor::num_list;
@@ -2,21 +2,21 @@
 #define INDUCTOR_H
 
 #include "rlccomponent.h"
-#include "inductordialog.h"
 class Inductor:public RLCComponent
 {
     private:
         double inductance;
         int num;
         static QVector<bool> num_list; //1 for exist 0 for not
-        Inductordialog *inductordialog;
     public:
         Inductor();
-        Inductor(const QString &s,QRect &r,QGraphicsScene *sc);
+        Inductor(ComponentView *view,QRect &r);
         void setReactance();
         double getInductance();
+        void setInductance(double value);
+        Inductor* solver_copy()const;//value and node indices only, for runs on another thread
         void Delete();
-        void InputValue();
+        void setInputValue(const QString &input);//value as typed, unit suffixes allowed
         bool isDependant();
         ~Inductor();
 };
@@ -1,5 +1,6 @@
 #include "matrix.h"
 #include <QDebug>
+static const double pivot_threshold = 0.1;
 Matrix::Matrix():pivots(1,col)
 {
     row = 1;
@@ -90,20 +91,18 @@ double Matrix::operator()(int i, int j)const
     else
         return 0;
 }
+//pivots are refreshed by sort_by_row before they are used, so writes stay
+//O(1) and writes to different entries can run on different threads
 void Matrix::add_ij(int i,int j,double add_value)
 {
     if( (i>=0&&i<row) && (j>=0&&j<col))
         data[i][j]+=add_value;
-    if(data[i][j]==0)
-        update_pivots();
     //qDebug()<<"i: "<<i<<" j: "<<j<<" data: "<<data[i][j];
 }
 void Matrix::set_ij(int i,int j,double set_value)
 {
     if( (i>=0&&i<row) && (j>=0&&j<col))
         data[i][j] = set_value;
-    if(data[i][j]==0)
-        update_pivots();
 }
 void Matrix::setall(double value)
 {
@@ -171,6 +170,7 @@ void Matrix::operator=(const Matrix& m)
     //qDebug()<<"hello";
     row = m.get_row_num();
     col = m.get_col_num();
+    pivots.assign(row,0);
     data = new double*[row];
     for(int i=0;i<row;i++){
         data[i] = new double[col];
@@ -415,6 +415,715 @@ Matrix Matrix::solve_gauss_elimination(const Matrix& bababao)
     }
     return ans;
 }
+LU_factor Matrix::lu_factorize(const std::vector<int>* order,bool equilibrate)const
+{
+    LU_factor f;
+    if(row!=col){
+        qDebug()<<"Row col not matching";
+        return f;
+    }
+    if(order && (int)order->size()!=row)
+        order = nullptr;
+    f.LU = *this;
+    if(equilibrate){
+        this->equilibrate(f.row_scale,f.col_scale);
+        for(int i=0;i<row;i++)
+            for(int j=0;j<col;j++)
+                f.LU.data[i][j] *= f.row_scale[i]*f.col_scale[j];
+    }
+    f.perm.resize(row);
+    std::vector<int> where(row);//current position of every original row
+    for(int i=0;i<row;i++){
+        f.perm[i] = i;
+        where[i] = i;
+    }
+    double **lu = f.LU.data;
+    for(int k=0;k<row;k++){
+        int p = k;
+        for(int i=k+1;i<row;i++){
+            if(fabs(lu[i][k])>fabs(lu[p][k]))
+                p = i;
+        }
+        if(lu[p][k]==0)
+            return f;
+        if(order){
+            int q = (*order)[k]<0 ? -1 : where[(*order)[k]];
+            if(q>=k && fabs(lu[q][k])>=pivot_threshold*fabs(lu[p][k]))
+                p = q;
+            else
+                f.repivoted++;
+        }
+        if(p!=k){
+            std::swap(lu[p],lu[k]);
+            std::swap(f.perm[p],f.perm[k]);
+            where[f.perm[p]] = p;
+            where[f.perm[k]] = k;
+        }
+        for(int i=k+1;i<row;i++){
+            double s = lu[i][k]/lu[k][k];
+            lu[i][k] = s;
+            if(s==0)
+                continue;
+            for(int j=k+1;j<col;j++)
+                lu[i][j] -= s*lu[k][j];
+        }
+    }
+    f.singular = false;
+    return f;
+}
+std::vector<int> Matrix::structural_matching()const
+{
+    //rows on the left, columns on the right, every augmenting path found in one bfs phase is used
+    std::vector< std::vector<int> > adj(row);
+    for(int i=0;i<row;i++)
+        for(int j=0;j<col;j++)
+            if(data[i][j]!=0)
+                adj[i].push_back(j);
+    std::vector<int> row_match(row,-1);
+    std::vector<int> col_match(col,-1);
+    std::vector<int> dist(row);
+    std::vector<int> queue(row);
+    std::vector<size_t> next(row);
+    const int unreached = row+1;
+    while(true){
+        int head = 0,tail = 0;
+        for(int i=0;i<row;i++){
+            if(row_match[i]<0){
+                dist[i] = 0;
+                queue[tail++] = i;
+            }else{
+                dist[i] = unreached;
+            }
+        }
+        bool augmenting = false;
+        while(head<tail){
+            int i = queue[head++];
+            for(int j : adj[i]){
+                int r = col_match[j];
+                if(r<0)
+                    augmenting = true;
+                else if(dist[r]==unreached){
+                    dist[r] = dist[i]+1;
+                    queue[tail++] = r;
+                }
+            }
+        }
+        if(!augmenting)
+            break;
+        //depth first along the layers, iterative so deep chains cannot overflow the stack
+        std::fill(next.begin(),next.end(),0);
+        for(int root=0;root<row;root++){
+            if(row_match[root]>=0)
+                continue;
+            std::vector<int> path(1,root);
+            while(!path.empty()){
+                int i = path.back();
+                if(next[i]==adj[i].size()){
+                    dist[i] = unreached;//dead end for the rest of this phase
+                    path.pop_back();
+                    continue;
+                }
+                int j = adj[i][next[i]++];
+                int r = col_match[j];
+                if(r<0){
+                    //flip the path, each row takes the column it was trying
+                    for(int k=path.size()-1;k>=0;k--){
+                        int pi = path[k];
+                        int pj = adj[pi][next[pi]-1];
+                        row_match[pi] = pj;
+                        col_match[pj] = pi;
+                    }
+                    break;
+                }
+                if(dist[r]==dist[i]+1)
+                    path.push_back(r);
+            }
+        }
+    }
+    return col_match;
+}
+Matrix Matrix::lu_solve(const LU_factor& f,const Matrix& b)
+{
+    int n = f.LU.row;
+    if(f.singular || b.get_row_num()!=n){
+        qDebug()<<"singular or not matching factorization";
+        return Matrix(n,b.get_col_num());
+    }
+    if(b.get_col_num()>1)
+        return lu_solve_blocked(f,b);
+    double **lu = f.LU.data;
+    Matrix ans(n,b.get_col_num());
+    double **x = ans.data;
+    bool scaled = !f.row_scale.empty();
+    for(int c=0;c<b.get_col_num();c++){
+        for(int i=0;i<n;i++){
+            double s = b.data[f.perm[i]][c];
+            if(scaled)
+                s *= f.row_scale[f.perm[i]];
+            for(int j=0;j<i;j++)
+                s -= lu[i][j]*x[j][c];
+            x[i][c] = s;
+        }
+        for(int i=n-1;i>=0;i--){
+            double s = x[i][c];
+            for(int j=i+1;j<n;j++)
+                s -= lu[i][j]*x[j][c];
+            x[i][c] = s/lu[i][i];
+        }
+    }
+    if(scaled){
+        for(int i=0;i<n;i++)
+            x[i][0] *= f.col_scale[i];
+    }
+    return ans;
+}
+Matrix Matrix::lu_solve_transposed(const LU_factor& f,const Matrix& b)
+{
+    //P Dr A Dc = L U, so A^T = Dc^-1 U^T L^T P Dr^-1: U^T forward, L^T backward, then undo P and Dr
+    int n = f.LU.row;
+    if(f.singular || b.get_row_num()!=n){
+        qDebug()<<"singular or not matching factorization";
+        return Matrix(n,b.get_col_num());
+    }
+    double **lu = f.LU.data;
+    bool scaled = !f.row_scale.empty();
+    Matrix ans(n,b.get_col_num());
+    std::vector<double> w(n);
+    for(int c=0;c<b.get_col_num();c++){
+        for(int i=0;i<n;i++){
+            double s = b.data[i][c];
+            if(scaled)
+                s *= f.col_scale[i];
+            for(int j=0;j<i;j++)
+                s -= lu[j][i]*w[j];
+            w[i] = s/lu[i][i];
+        }
+        for(int i=n-1;i>=0;i--){
+            double s = w[i];
+            for(int j=i+1;j<n;j++)
+                s -= lu[j][i]*w[j];
+            w[i] = s;
+        }
+        for(int i=0;i<n;i++)
+            ans.data[f.perm[i]][c] = scaled ? w[i]*f.row_scale[f.perm[i]] : w[i];
+    }
+    return ans;
+}
+Matrix Matrix::lu_solve_blocked(const LU_factor& f,const Matrix& b)
+{
+    int n = f.LU.row;
+    int m = b.get_col_num();
+    if(f.singular || b.get_row_num()!=n){
+        qDebug()<<"singular or not matching factorization";
+        return Matrix(n,m);
+    }
+    //row blocks of the triangles times row blocks of X, the inner loops run
+    //along contiguous rows of X so every entry of L and U is used for a whole tile of columns
+    const int row_block = 64;
+    const int col_block = 256;
+    double **lu = f.LU.data;
+    Matrix ans(n,m);
+    double **x = ans.data;
+    bool scaled = !f.row_scale.empty();
+    for(int i=0;i<n;i++){
+        double r = scaled ? f.row_scale[f.perm[i]] : 1;
+        for(int c=0;c<m;c++)
+            x[i][c] = b.data[f.perm[i]][c]*r;
+    }
+    auto axpy = [](double *y,const double *v,double s,int c0,int c1){
+        for(int c=c0;c<c1;c++)
+            y[c] -= s*v[c];
+    };
+    //y -= sum over j of a[j]*x[j], four rows of x per pass over y
+    auto block_update = [&](double *y,const double *a,double **v,int j0,int j1,int c0,int c1){
+        int j = j0;
+        for(;j+4<=j1;j+=4){
+            double s0 = a[j], s1 = a[j+1], s2 = a[j+2], s3 = a[j+3];
+            if(s0==0 && s1==0 && s2==0 && s3==0)
+                continue;
+            const double *v0 = v[j], *v1 = v[j+1], *v2 = v[j+2], *v3 = v[j+3];
+            for(int c=c0;c<c1;c++)
+                y[c] -= s0*v0[c]+s1*v1[c]+s2*v2[c]+s3*v3[c];
+        }
+        for(;j<j1;j++){
+            if(a[j]!=0)
+                axpy(y,v[j],a[j],c0,c1);
+        }
+    };
+    for(int c0=0;c0<m;c0+=col_block){
+        int c1 = std::min(m,c0+col_block);
+        //L Y = P B, unit diagonal
+        for(int kb=0;kb<n;kb+=row_block){
+            int ke = std::min(n,kb+row_block);
+            for(int i=kb;i<ke;i++){
+                for(int j=kb;j<i;j++){
+                    if(lu[i][j]!=0)
+                        axpy(x[i],x[j],lu[i][j],c0,c1);
+                }
+            }
+            for(int i=ke;i<n;i++)
+                block_update(x[i],lu[i],x,kb,ke,c0,c1);
+        }
+        //U X = Y, blocks from the bottom
+        int last = ((n-1)/row_block)*row_block;
+        for(int kb=last;kb>=0;kb-=row_block){
+            int ke = std::min(n,kb+row_block);
+            for(int i=ke-1;i>=kb;i--){
+                for(int j=i+1;j<ke;j++){
+                    if(lu[i][j]!=0)
+                        axpy(x[i],x[j],lu[i][j],c0,c1);
+                }
+                double d = 1/lu[i][i];
+                for(int c=c0;c<c1;c++)
+                    x[i][c] *= d;
+            }
+            for(int i=0;i<kb;i++)
+                block_update(x[i],lu[i],x,kb,ke,c0,c1);
+        }
+    }
+    if(scaled){
+        for(int i=0;i<n;i++)
+            for(int c=0;c<m;c++)
+                x[i][c] *= f.col_scale[i];
+    }
+    return ans;
+}
+void Matrix::equilibrate(std::vector<double>& row_scale,std::vector<double>& col_scale)const
+{
+    //rows to a max entry in [1,2), then the columns of the scaled matrix, powers of two so scaling rounds nothing
+    auto power_of_two = [](double largest){
+        if(largest==0 || !std::isfinite(largest))
+            return 1.0;
+        int e;
+        frexp(largest,&e);
+        return ldexp(1.0,1-e);
+    };
+    row_scale.assign(row,1);
+    col_scale.assign(col,1);
+    for(int i=0;i<row;i++){
+        double largest = 0;
+        for(int j=0;j<col;j++)
+            largest = std::max(largest,fabs(data[i][j]));
+        row_scale[i] = power_of_two(largest);
+    }
+    for(int j=0;j<col;j++){
+        double largest = 0;
+        for(int i=0;i<row;i++)
+            largest = std::max(largest,fabs(data[i][j])*row_scale[i]);
+        col_scale[j] = power_of_two(largest);
+    }
+}
+double Matrix::condition_estimate(const Matrix& A,const LU_factor& f)
+{
+    int n = f.LU.row;
+    if(f.singular || A.row!=n || n==0)
+        return INFINITY;
+    double norm = 0;
+    for(int j=0;j<n;j++){
+        double s = 0;
+        for(int i=0;i<n;i++)
+            s += fabs(A.data[i][j]);
+        norm = std::max(norm,s);
+    }
+    //A^-T v = Dr (Dr A Dc)^-T Dc v, and (P^T L U)^T = U^T L^T P
+    bool scaled = !f.row_scale.empty();
+    double **lu = f.LU.data;
+    auto solve_transposed = [&](const std::vector<double>& v){
+        std::vector<double> w(n);
+        for(int i=0;i<n;i++){
+            double s = scaled ? v[i]*f.col_scale[i] : v[i];
+            for(int j=0;j<i;j++)
+                s -= lu[j][i]*w[j];
+            w[i] = s/lu[i][i];
+        }
+        for(int i=n-1;i>=0;i--){
+            double s = w[i];
+            for(int j=i+1;j<n;j++)
+                s -= lu[j][i]*w[j];
+            w[i] = s;
+        }
+        std::vector<double> x(n);
+        for(int i=0;i<n;i++)
+            x[f.perm[i]] = scaled ? w[i]*f.row_scale[f.perm[i]] : w[i];
+        return x;
+    };
+    //hager: climb ||A^-1 x||_1 over the unit ball, a few solves instead of the inverse
+    Matrix x(n,1);
+    for(int i=0;i<n;i++)
+        x.data[i][0] = 1.0/n;
+    double estimate = 0;
+    for(int iteration=0;iteration<5;iteration++){
+        Matrix y = lu_solve(f,x);
+        double y_norm = 0;
+        for(int i=0;i<n;i++)
+            y_norm += fabs(y.data[i][0]);
+        if(iteration>0 && y_norm<=estimate)
+            break;
+        estimate = y_norm;
+        std::vector<double> sign(n);
+        for(int i=0;i<n;i++)
+            sign[i] = y.data[i][0]>=0 ? 1 : -1;
+        std::vector<double> z = solve_transposed(sign);
+        int j = 0;
+        double ztx = 0;
+        for(int i=0;i<n;i++){
+            ztx += z[i]*x.data[i][0];
+            if(fabs(z[i])>fabs(z[j]))
+                j = i;
+        }
+        if(iteration>0 && fabs(z[j])<=ztx)
+            break;
+        x.setall(0);
+        x.data[j][0] = 1;
+    }
+    return norm*estimate;
+}
+Matrix Matrix::lu_refine(const Matrix& A,const LU_factor& f,const Matrix& b,const Matrix& x,int steps,int* used)
+{
+    //residual in working precision, stops once a correction no longer halves it
+    Matrix ans = x;
+    double last = INFINITY;
+    int n = A.row;
+    for(int k=0;k<steps;k++){
+        Matrix r(n,b.col);
+        double r_norm = 0;
+        for(int i=0;i<n;i++){
+            for(int c=0;c<b.col;c++){
+                double s = b.data[i][c];
+                for(int j=0;j<A.col;j++)
+                    s -= A.data[i][j]*ans.data[j][c];
+                r.data[i][c] = s;
+                r_norm = std::max(r_norm,fabs(s));
+            }
+        }
+        if(r_norm==0 || r_norm>0.5*last)
+            break;
+        last = r_norm;
+        ans += lu_solve(f,r);
+        if(used)
+            (*used)++;
+    }
+    return ans;
+}
+const char* Matrix::solver_path_name(int path)
+{
+    const char* names[] = {"general","cholesky","ldlt","banded lu","tridiagonal"};
+    if(path<solver_general || path>solver_tridiagonal)
+        return "unknown";
+    return names[path];
+}
+matrix_structure Matrix::analyze_structure()const
+{
+    matrix_structure s;
+    int n = row;
+    if(row!=col || n==0)
+        return s;
+    //symmetric pattern of A + A^T, bandwidths in the natural order
+    std::vector< std::vector<int> > adjacent(n);
+    s.symmetric = true;
+    s.dominant = true;
+    bool positive_diagonal = true;
+    bool nonzero_diagonal = true;
+    for(int i=0;i<n;i++){
+        if(data[i][i]<=0)
+            positive_diagonal = false;
+        if(data[i][i]==0)
+            nonzero_diagonal = false;
+        double off_diagonal = 0;
+        for(int j=0;j<n;j++)
+            off_diagonal += j==i ? 0 : fabs(data[i][j]);
+        if(fabs(data[i][i])<off_diagonal)
+            s.dominant = false;
+        for(int j=i+1;j<n;j++){
+            double a = data[i][j];
+            double b = data[j][i];
+            if(fabs(a-b)>1e-12*(fabs(a)+fabs(b)))
+                s.symmetric = false;
+            if(a!=0 || b!=0){
+                adjacent[i].push_back(j);
+                adjacent[j].push_back(i);
+            }
+        }
+    }
+    auto bandwidths = [&](const std::vector<int> &position,int &lower,int &upper){
+        lower = upper = 0;
+        for(int i=0;i<n;i++){
+            for(int j=0;j<n;j++){
+                if(i==j || data[i][j]==0)
+                    continue;
+                int d = position[i]-position[j];
+                lower = std::max(lower,d);
+                upper = std::max(upper,-d);
+            }
+        }
+    };
+    std::vector<int> natural(n);
+    for(int i=0;i<n;i++)
+        natural[i] = i;
+    bandwidths(natural,s.lower,s.upper);
+
+    //mna puts branch currents after all nodes, reverse cuthill mckee pulls them next to their nodes
+    if(s.lower+s.upper>2){
+        std::vector<int> order;
+        std::vector<char> visited(n,0);
+        auto degree_less = [&](int a,int b){
+            return adjacent[a].size()<adjacent[b].size();
+        };
+        while((int)order.size()<n){
+            int start = -1;
+            for(int i=0;i<n;i++){
+                if(!visited[i] && (start<0 || adjacent[i].size()<adjacent[start].size()))
+                    start = i;
+            }
+            visited[start] = 1;
+            int head = order.size();
+            order.push_back(start);
+            while(head<(int)order.size()){
+                int v = order[head++];
+                std::vector<int> next;
+                for(int w : adjacent[v]){
+                    if(!visited[w]){
+                        visited[w] = 1;
+                        next.push_back(w);
+                    }
+                }
+                std::stable_sort(next.begin(),next.end(),degree_less);
+                order.insert(order.end(),next.begin(),next.end());
+            }
+        }
+        std::reverse(order.begin(),order.end());
+        std::vector<int> position(n);
+        for(int i=0;i<n;i++)
+            position[order[i]] = i;
+        int lower,upper;
+        bandwidths(position,lower,upper);
+        if(lower+upper<s.lower+s.upper){
+            s.order = order;
+            s.lower = lower;
+            s.upper = upper;
+        }
+    }
+
+    //unpivoted paths only where the pivots cannot grow: dominant rows, or positive definite,
+    //which the cholesky pivots confirm. a 1e-12 S conductance next to a unit incidence is neither
+    if(s.lower<=1 && s.upper<=1 && s.dominant && nonzero_diagonal)
+        s.path = solver_tridiagonal;
+    else if(s.symmetric && positive_diagonal)
+        s.path = solver_cholesky;
+    else if(s.symmetric && nonzero_diagonal && s.dominant)
+        s.path = solver_ldlt;
+    else if(4*(s.lower+s.upper+1)<=n)
+        s.path = solver_banded;
+    else
+        s.path = solver_general;
+    return s;
+}
+Matrix Matrix::solve_structured(const Matrix& b,matrix_structure& s)const
+{
+    int n = row;
+    if(row!=col || b.get_row_num()!=n){
+        qDebug()<<"Row col not matching";
+        return Matrix();
+    }
+    if(s.path==solver_general)
+        return const_cast<Matrix*>(this)->solve_gauss_elimination(b);
+    //P A P^T (P x) = P b, then every path works inside the band
+    std::vector<int> order = s.order;
+    if(order.empty()){
+        order.resize(n);
+        for(int i=0;i<n;i++)
+            order[i] = i;
+    }
+    Matrix a(n,n);
+    std::vector<double> y(n);
+    for(int i=0;i<n;i++){
+        for(int j=std::max(0,i-s.lower);j<=std::min(n-1,i+s.upper);j++)
+            a.data[i][j] = data[order[i]][order[j]];
+        y[i] = b(order[i],0);
+    }
+    double **m = a.data;
+    int l = s.lower;
+    int u = s.upper;
+    double scale = 0;
+    for(int i=0;i<n;i++){
+        for(int j=std::max(0,i-l);j<=std::min(n-1,i+u);j++)
+            scale = std::max(scale,fabs(m[i][j]));
+    }
+    double tiny = 1e-14*scale;
+    //a positive definite or dominant matrix keeps every reduced entry within scale,
+    //anything past this means the pattern was right but the values need pivoting
+    double huge = 8*scale;
+    bool done = false;
+
+    if(s.path==solver_tridiagonal){
+        //thomas, no pivoting: a small pivot sends it to the banded lu
+        std::vector<double> c(n,0);
+        done = true;
+        double d = m[0][0];
+        for(int i=0;i<n && done;i++){
+            if(i>0)
+                d = m[i][i]-m[i][i-1]*c[i-1];
+            if(fabs(d)<=tiny || fabs(d)>huge){
+                done = false;
+                break;
+            }
+            c[i] = i+1<n ? m[i][i+1]/d : 0;
+            y[i] = (y[i]-(i>0 ? m[i][i-1]*y[i-1] : 0))/d;
+        }
+        if(done){
+            for(int i=n-2;i>=0;i--)
+                y[i] -= c[i]*y[i+1];
+        }else{
+            for(int i=0;i<n;i++)
+                y[i] = b(order[i],0);
+            s.path = solver_banded;
+        }
+    }
+    if(!done && (s.path==solver_cholesky || s.path==solver_ldlt)){
+        //L D L^T in the band, d > 0 everywhere is the cholesky case
+        std::vector<double> d(n);
+        Matrix L(n,n);
+        double **lo = L.data;
+        done = true;
+        for(int j=0;j<n && done;j++){
+            double dj = m[j][j];
+            for(int k=std::max(0,j-l);k<j;k++)
+                dj -= lo[j][k]*lo[j][k]*d[k];
+            if(fabs(dj)<=tiny || fabs(dj)>huge || (s.path==solver_cholesky && dj<=0)){
+                done = false;
+                break;
+            }
+            d[j] = dj;
+            for(int i=j+1;i<=std::min(n-1,j+l) && done;i++){
+                double v = m[i][j];
+                for(int k=std::max(0,i-l);k<j;k++)
+                    v -= lo[i][k]*lo[j][k]*d[k];
+                //v is the reduced entry (i,j)
+                if(fabs(v)>huge)
+                    done = false;
+                lo[i][j] = v/dj;
+            }
+        }
+        if(done){
+            for(int i=0;i<n;i++){
+                for(int k=std::max(0,i-l);k<i;k++)
+                    y[i] -= lo[i][k]*y[k];
+            }
+            for(int i=0;i<n;i++)
+                y[i] /= d[i];
+            for(int i=n-1;i>=0;i--){
+                for(int k=i+1;k<=std::min(n-1,i+l);k++)
+                    y[i] -= lo[k][i]*y[k];
+            }
+        }else{
+            s.path = solver_banded;
+        }
+    }
+    if(!done && s.path==solver_banded){
+        //partial pivoting inside the band, row swaps widen the upper band to l+u
+        int w = std::min(n-1,l+u);
+        done = true;
+        for(int k=0;k<n && done;k++){
+            int last = std::min(n-1,k+l);
+            int p = k;
+            for(int i=k+1;i<=last;i++){
+                if(fabs(m[i][k])>fabs(m[p][k]))
+                    p = i;
+            }
+            if(fabs(m[p][k])<=tiny){
+                done = false;
+                break;
+            }
+            if(p!=k){
+                std::swap(m[p],m[k]);
+                std::swap(y[p],y[k]);
+            }
+            int end = std::min(n-1,k+w);
+            for(int i=k+1;i<=last;i++){
+                double f = m[i][k]/m[k][k];
+                if(f==0)
+                    continue;
+                m[i][k] = 0;
+                for(int j=k+1;j<=end;j++)
+                    m[i][j] -= f*m[k][j];
+                y[i] -= f*y[k];
+            }
+        }
+        if(done){
+            for(int i=n-1;i>=0;i--){
+                double v = y[i];
+                for(int j=i+1;j<=std::min(n-1,i+w);j++)
+                    v -= m[i][j]*y[j];
+                y[i] = v/m[i][i];
+            }
+        }else{
+            s.path = solver_general;
+        }
+    }
+    if(!done){
+        s.path = solver_general;
+        return const_cast<Matrix*>(this)->solve_gauss_elimination(b);
+    }
+    Matrix ans(n,1);
+    for(int i=0;i<n;i++)
+        ans.data[order[i]][0] = y[i];
+    return ans;
+}
+Matrix Matrix::sub_matrix(const std::vector<int>& rows,const std::vector<int>& cols)const
+{
+    Matrix ans(rows.size(),cols.size());
+    for(size_t i=0;i<rows.size();i++){
+        for(size_t j=0;j<cols.size();j++){
+            ans.data[i][j] = data[rows[i]][cols[j]];
+        }
+    }
+    return ans;
+}
+Matrix Matrix::exponential()const
+{
+    int n = row;
+    //scale so that ||A/2^s||_1 <= 0.5
+    double norm = 0;
+    for(int j=0;j<n;j++){
+        double sum = 0;
+        for(int i=0;i<n;i++)
+            sum += fabs(data[i][j]);
+        norm = std::max(norm,sum);
+    }
+    int s = norm>0.5 ? int(ceil(log2(norm/0.5))) : 0;
+    Matrix X(*this);
+    double scale = ldexp(1.0,-s);
+    for(int i=0;i<n;i++)
+        for(int j=0;j<n;j++)
+            X.data[i][j] *= scale;
+
+    //N = sum c_k X^k, D = sum (-1)^k c_k X^k
+    const int q = 6;
+    Matrix power(n,n,0);
+    Matrix N(n,n,0);
+    Matrix D(n,n,0);
+    for(int i=0;i<n;i++){
+        power.data[i][i] = 1;
+        N.data[i][i] = 1;
+        D.data[i][i] = 1;
+    }
+    double c = 1;
+    for(int k=1;k<=q;k++){
+        c = c*(q-k+1)/(k*(2.0*q-k+1));
+        power = power*X;
+        double sign = (k%2) ? -1 : 1;
+        for(int i=0;i<n;i++){
+            for(int j=0;j<n;j++){
+                N.data[i][j] += c*power.data[i][j];
+                D.data[i][j] += sign*c*power.data[i][j];
+            }
+        }
+    }
+    Matrix E = Matrix::lu_solve(D.lu_factorize(),N);
+    for(int k=0;k<s;k++)
+        E = E*E;
+    return E;
+}
 void Matrix::debug()const
 {
     QDebug deb = qDebug();
@@ -3,6 +3,15 @@
 #include<vector>
 #include<math.h>
 #include <algorithm>
+struct LU_factor;
+struct matrix_structure;
+enum solver_path{
+    solver_general = 0,//solve_gauss_elimination
+    solver_cholesky,//symmetric positive definite
+    solver_ldlt,//symmetric and diagonally dominant
+    solver_banded,//LU with partial pivoting inside the band
+    solver_tridiagonal,//thomas algorithm, diagonally dominant
+};
 class Matrix
 {
     private:
@@ -47,11 +56,42 @@ class Matrix
         Matrix transpose();
         Matrix solve(const Matrix& b);//Ax = b, this is A return x
         Matrix solve_gauss_elimination(const Matrix& b);
+        //PA = LU with partial pivoting, order[k] is the preferred pivot row of column k and is kept while it stays
+        //within pivot_threshold of the column max, equilibrate factors Dr A Dc and lu_solve undoes the scaling
+        LU_factor lu_factorize(const std::vector<int>* order = nullptr,bool equilibrate = false)const;
+        void equilibrate(std::vector<double>& row_scale,std::vector<double>& col_scale)const;//max norm, powers of two
+        static double condition_estimate(const Matrix& A,const LU_factor& f);//1-norm, hager's estimator on the factors
+        static Matrix lu_refine(const Matrix& A,const LU_factor& f,const Matrix& b,const Matrix& x,int steps,int* used = nullptr);
+        std::vector<int> structural_matching()const;//hopcroft-karp on the nonzero pattern, matched row of every column or -1
+        static Matrix lu_solve(const LU_factor& f,const Matrix& b);//every column of b
+        static Matrix lu_solve_transposed(const LU_factor& f,const Matrix& b);//A^T x = b on the factors of A
+        static Matrix lu_solve_blocked(const LU_factor& f,const Matrix& b);//all columns at once, blocked triangular solves
+        matrix_structure analyze_structure()const;//cheapest path the pattern and values allow
+        Matrix solve_structured(const Matrix& b,matrix_structure& s)const;//s.path falls back when a pivot breaks down
+        static const char* solver_path_name(int path);
+        Matrix sub_matrix(const std::vector<int>& rows,const std::vector<int>& cols)const;
+        Matrix exponential()const;//e^A, scaling and squaring with a [6/6] pade approximant
 
         void debug()const;
 
         static double calculate_maxVdifference(const Matrix& a,const Matrix& b);
         ~Matrix();
 };
+struct LU_factor{
+    Matrix LU;//L below the diagonal (unit diagonal), U on and above
+    std::vector<int> perm;//row i of LU is row perm[i] of A
+    bool singular = true;
+    int repivoted = 0;//columns where the preferred pivot row was rejected
+    std::vector<double> row_scale;//Dr A Dc was factored, empty without equilibration
+    std::vector<double> col_scale;
+};
+struct matrix_structure{
+    int path = solver_general;
+    bool symmetric = false;
+    bool dominant = false;//every row diagonally dominant, elimination without pivoting cannot grow
+    int lower = 0;//bandwidths in the chosen order
+    int upper = 0;
+    std::vector<int> order;//row and column i of the ordered matrix is order[i], empty for the natural order
+};
 
 #endif // MATRIX_H
@@ -0,0 +1,450 @@
+#include "netlist.h"
+#include <fstream>
+#include <cctype>
+#include <cstdlib>
+#include "resistor.h"
+#include "capacitor.h"
+#include "inductor.h"
+#include "diode.h"
+#include "voltage_source.h"
+#include "current_source.h"
+#include "current_control_current_source.h"
+#include "current_control_voltage_source.h"
+#include "voltage_control_current_source.h"
+#include "voltage_control_voltage_source.h"
+
+namespace{
+enum source_mode{DC,Sine,Square};//same order as the source dialogs
+std::string lower(std::string s)
+{
+    for(auto &ch:s)
+        ch = std::tolower((unsigned char)ch);
+    return s;
+}
+}
+
+Netlist::Netlist()
+{
+
+}
+std::vector<std::string> Netlist::split(const std::string &line)
+{
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while(i<line.size()){
+        while(i<line.size() && std::isspace((unsigned char)line[i]))
+            i++;
+        size_t begin = i;
+        while(i<line.size() && !std::isspace((unsigned char)line[i]))
+            i++;
+        if(i>begin)
+            tokens.push_back(line.substr(begin,i-begin));
+    }
+    return tokens;
+}
+bool Netlist::parse_value(const std::string &s,double &value)
+{
+    const char* begin = s.c_str();
+    char* end = nullptr;
+    value = std::strtod(begin,&end);
+    if(end==begin)
+        return false;
+    std::string suffix(end);
+    if(suffix.empty())
+        return true;
+    if(lower(suffix)=="meg"){
+        value *= 1e+6;
+        return true;
+    }
+    if(suffix.size()!=1)
+        return false;
+    switch(suffix[0]){
+        case 'f': value *= 1e-15; break;
+        case 'p': value *= 1e-12; break;
+        case 'n': value *= 1e-9; break;
+        case 'u': value *= 1e-6; break;
+        case 'm': value *= 1e-3; break;
+        case 'k': case 'K': value *= 1e+3; break;
+        case 'M': value *= 1e+6; break;
+        case 'G': value *= 1e+9; break;
+        default: return false;
+    }
+    return true;
+}
+bool Netlist::parse_directive(const std::vector<std::string> &tokens,netlist_directive &d,QString &error)
+{
+    std::string name = lower(tokens[0]);
+    d = netlist_directive();
+    if(name==".op" && tokens.size()==1){
+        d.analysis = netlist_op;
+        return true;
+    }
+    if(name==".tran" && tokens.size()==3){
+        d.analysis = netlist_tran;
+        if(!parse_value(tokens[1],d.step) || !parse_value(tokens[2],d.stop) || d.step<=0 || d.stop<=0){
+            error = QString("bad .tran step or stop time");
+            return false;
+        }
+        return true;
+    }
+    if(name==".dc" && tokens.size()==5){
+        d.analysis = netlist_dc;
+        d.source = QString::fromStdString(tokens[1]);
+        if(!parse_value(tokens[2],d.start) || !parse_value(tokens[3],d.stop) || !parse_value(tokens[4],d.step) || d.step==0 || d.start==d.stop){
+            error = QString("bad .dc start, stop or step");
+            return false;
+        }
+        return true;
+    }
+    error = QString("unknown directive ")+QString::fromStdString(tokens[0])+QString(" (.op, .tran step stop, .dc source start stop step)");
+    return false;
+}
+bool Netlist::fail(int line,const QString &message)
+{
+    error = line>0 ? QString("line ")+QString::number(line)+QString(": ")+message : message;
+    return false;
+}
+bool Netlist::read_file(const QString &path,Circuit &circuit)
+{
+    std::ifstream in(path.toStdString());
+    if(!in)
+        return fail(0,QString("cannot open ")+path);
+    return read(in,circuit);
+}
+bool Netlist::read(std::istream &in,Circuit &circuit)
+{
+    std::string text;
+    int line = 0;
+    while(std::getline(in,text)){
+        line++;
+        std::vector<std::string> tokens = split(text);
+        if(tokens.empty() || tokens[0][0]=='*' || tokens[0][0]==';')
+            continue;
+        if(tokens[0][0]=='.'){
+            if(lower(tokens[0])==".end")
+                break;
+            netlist_directive d;
+            QString message;
+            if(!parse_directive(tokens,d,message))
+                return fail(line,message);
+            directives.push_back(d);
+            continue;
+        }
+        if(!parse_card(tokens,line))
+            return false;
+    }
+    return build(circuit);
+}
+bool Netlist::parse_card(std::vector<std::string> &tokens,int line)
+{
+    //phase 1 spellings: "add R1 ...", "VoltageSource V1 ...", "R R1 ..." and "GND n"
+    if(tokens[0]=="add")
+        tokens.erase(tokens.begin());
+    if(tokens.empty())
+        return fail(line,QString("nothing to add"));
+    if(tokens[0]=="VoltageSource" || tokens[0]=="CurrentSource")
+        tokens[0] = tokens[0].substr(0,1);
+    if(tokens[0]=="GND"){
+        if(tokens.size()!=2)
+            return fail(line,QString("GND takes one node"));
+        grounds.push_back(tokens[1]);
+        return true;
+    }
+    if(tokens.size()>1 && tokens[0].size()==1 && std::toupper((unsigned char)tokens[1][0])==std::toupper((unsigned char)tokens[0][0]))
+        tokens.erase(tokens.begin());
+
+    card c;
+    c.type = std::toupper((unsigned char)tokens[0][0]);
+    c.name = QString::fromStdString(tokens[0]);
+    c.line = line;
+    QString name = c.name;
+    auto value = [&](const std::string &s,double &v){
+        if(parse_value(s,v))
+            return true;
+        return fail(line,QString("bad value ")+QString::fromStdString(s)+QString(" for ")+name);
+    };
+    double v;
+    switch(c.type){
+        case 'R': case 'C': case 'L':
+            if(tokens.size()!=4)
+                return fail(line,name+QString(" needs two nodes and a value"));
+            if(!value(tokens[3],v))
+                return false;
+            if(v<=0)
+                return fail(line,name+QString(" must be positive"));
+            c.values.push_back(v);
+            break;
+        case 'D':
+            //one diode model, the model name is optional and ignored
+            if(tokens.size()!=3 && tokens.size()!=4)
+                return fail(line,name+QString(" needs an anode and a cathode"));
+            break;
+        case 'V': case 'I':
+            if(tokens.size()<4)
+                return fail(line,name+QString(" needs two nodes and a value"));
+            if(!parse_source(c,tokens,line))
+                return false;
+            break;
+        case 'E': case 'G':
+            if(tokens.size()!=6)
+                return fail(line,name+QString(" needs two nodes, two controlling nodes and a gain"));
+            c.nodes.push_back(tokens[3]);
+            c.nodes.push_back(tokens[4]);
+            if(!value(tokens[5],v))
+                return false;
+            c.values.push_back(v);
+            break;
+        case 'F': case 'H':
+            if(tokens.size()!=5)
+                return fail(line,name+QString(" needs two nodes, a controlling voltage source and a gain"));
+            c.control = tokens[3];
+            if(!value(tokens[4],v))
+                return false;
+            c.values.push_back(v);
+            break;
+        default:
+            return fail(line,QString("unknown element ")+name);
+    }
+    c.nodes.insert(c.nodes.begin(),{tokens[1],tokens[2]});
+    cards.push_back(c);
+    return true;
+}
+bool Netlist::parse_source(card &c,const std::vector<std::string> &tokens,int line)
+{
+    //DC value, SIN(offset amplitude frequency [delay damping phase]) or PULSE(v1 v2 delay rise fall width period)
+    std::string spec;
+    for(size_t i=3;i<tokens.size();i++)
+        spec += tokens[i]+" ";
+    for(auto &ch:spec)
+        if(ch=='(' || ch==')' || ch==',')
+            ch = ' ';
+    std::vector<std::string> words = split(spec);
+    if(words.empty())
+        return fail(line,c.name+QString(" needs a value"));
+    std::string kind = lower(words[0]);
+    if(kind=="dc")
+        words.erase(words.begin());
+    if(kind=="sin" || kind=="pulse")
+        words.erase(words.begin());
+    for(auto &w:words){
+        double v;
+        if(!parse_value(w,v))
+            return fail(line,QString("bad value ")+QString::fromStdString(w)+QString(" for ")+c.name);
+        c.values.push_back(v);
+    }
+    const std::vector<double> &v = c.values;
+    if(kind=="sin"){
+        if(v.size()<3 || v.size()>6)
+            return fail(line,c.name+QString(" SIN takes offset, amplitude, frequency and an optional delay, damping and phase"));
+        if((v.size()>3 && v[3]!=0) || (v.size()>4 && v[4]!=0))
+            return fail(line,c.name+QString(" SIN delay and damping are not supported"));
+        c.mode = Sine;
+    }else if(kind=="pulse"){
+        if(v.size()!=7)
+            return fail(line,c.name+QString(" PULSE takes v1 v2 delay rise fall width period"));
+        if(v[2]!=0 || v[3]!=0 || v[4]!=0)
+            return fail(line,c.name+QString(" PULSE delay and edges are not supported, the source switches ideally"));
+        if(v[5]<=0 || v[6]<=v[5])
+            return fail(line,c.name+QString(" PULSE width must be positive and shorter than the period"));
+        c.mode = Square;
+    }else{
+        if(v.size()!=1)
+            return fail(line,c.name+QString(" takes a single dc value"));
+        c.mode = DC;
+    }
+    return true;
+}
+int Netlist::node(const std::string &name)
+{
+    int id = node_symbols.intern(name);
+    if(id>=(int)node_number.size())
+        node_number.resize(id+1,-1);
+    if(node_number[id]<0){
+        node_number[id] = node_names.size();
+        node_names.push_back(QString::fromStdString(name));
+    }
+    return node_number[id];
+}
+int Netlist::find_node(const std::string &name)const
+{
+    int id = node_symbols.find(name);
+    return id>=0 ? node_number[id] : -1;
+}
+bool Netlist::build(Circuit &circuit)
+{
+    node_names.clear();
+    node_symbols.clear();
+    node_number.clear();
+    node("0");
+    grounds.insert(grounds.end(),{"gnd","GND"});
+    for(auto &g:grounds){
+        int id = node_symbols.intern(g);
+        node_number.resize(node_symbols.size(),-1);
+        node_number[id] = 0;
+    }
+
+    //element names are interned in card order, so the id of a name is its card
+    SymbolTable<std::string> names;
+    for(int i=0;i<(int)cards.size();i++){
+        std::string key = cards[i].name.toStdString();
+        if(names.find(key)>=0)
+            return fail(cards[i].line,QString("duplicate element ")+cards[i].name);
+        names.intern(key);
+    }
+
+    //spice terminal order: V, I, E and H list n+ first, which is node 2 of the engine's sources
+    QVector<Component*> components;
+    QVector<QString> terminal;//a getDependantNode reference on every node, "<name>L" or "<name>R"
+    int voltage_sources = 0;
+    for(auto &c:cards){
+        Component* comp = nullptr;
+        bool reversed = false;
+        switch(c.type){
+            case 'R':{
+                Resistor* r = new Resistor();
+                r->set_resistance(c.values[0]);
+                comp = r;
+                break;
+            }
+            case 'C':{
+                Capacitor* cap = new Capacitor();
+                cap->set_capacitance(c.values[0]);
+                comp = cap;
+                break;
+            }
+            case 'L':{
+                Inductor* l = new Inductor();
+                l->setInductance(c.values[0]);
+                comp = l;
+                break;
+            }
+            case 'D':
+                comp = new Diode();
+                break;
+            case 'V':{
+                voltage_source* vs = new voltage_source();
+                voltageSourcedata data;
+                double frequency = 0;
+                if(c.mode==DC){
+                    data.dcData.voltage = c.values[0];
+                }else if(c.mode==Sine){
+                    data.sineData.offset = c.values[0];
+                    data.sineData.amplitude = c.values[1];
+                    data.sineData.phase = c.values.size()>5 ? c.values[5] : 0;
+                    frequency = c.values[2];
+                }else{
+                    data.squareData.Voff = c.values[0];
+                    data.squareData.Von = c.values[1];
+                    data.squareData.Ton = c.values[5];
+                    data.squareData.Tperiod = c.values[6];
+                }
+                vs->setInputValue(data,frequency,c.mode);
+                vs->set_num(voltage_sources++);
+                comp = vs;
+                reversed = true;
+                break;
+            }
+            case 'I':{
+                current_source* is = new current_source();
+                currentSourcedata data;
+                double frequency = 0;
+                if(c.mode==DC){
+                    data.dcData.current = c.values[0];
+                }else if(c.mode==Sine){
+                    data.sineData.offset = c.values[0];
+                    data.sineData.amplitude = c.values[1];
+                    data.sineData.phase = c.values.size()>5 ? c.values[5] : 0;
+                    frequency = c.values[2];
+                }else{
+                    data.squareData.Ioff = c.values[0];
+                    data.squareData.Ion = c.values[1];
+                    data.squareData.Ton = c.values[5];
+                    data.squareData.Tperiod = c.values[6];
+                }
+                is->setInputValue(data,frequency,c.mode);
+                comp = is;
+                reversed = true;
+                break;
+            }
+            case 'E':
+                comp = new Voltage_control_voltage_source();
+                reversed = true;
+                break;
+            case 'G':
+                comp = new Voltage_control_current_source();
+                break;
+            case 'F':
+                comp = new Current_control_current_source();
+                break;
+            case 'H':
+                comp = new Current_control_voltage_source();
+                reversed = true;
+                break;
+        }
+        comp->setName(c.name);
+        int first = node(c.nodes[0]);
+        int second = node(c.nodes[1]);
+        comp->getNodes()[reversed ? 1 : 0]->setNodeIndex(first);
+        comp->getNodes()[reversed ? 0 : 1]->setNodeIndex(second);
+        for(int k=0;k<2;k++){
+            int index = comp->getNodes()[k]->getNodeIndex();
+            if(terminal.size()<=index)
+                terminal.resize(index+1);
+            if(terminal[index].isEmpty())
+                terminal[index] = c.name+QString(k==0 ? "L" : "R");
+        }
+        components.push_back(comp);
+    }
+
+    //controls refer to nodes and sources by name, so they are resolved once every card is numbered
+    for(int i=0;i<(int)cards.size();i++){
+        card &c = cards[i];
+        Component* comp = components[i];
+        if(c.type=='E' || c.type=='G'){
+            QString ref[2];
+            for(int k=0;k<2;k++){
+                int index = find_node(c.nodes[2+k]);
+                if(index<0 || index>=terminal.size() || terminal[index].isEmpty()){
+                    qDeleteAll(components);
+                    return fail(c.line,QString("controlling node ")+QString::fromStdString(c.nodes[2+k])+QString(" of ")+c.name+QString(" is not connected to any element"));
+                }
+                ref[k] = terminal[index];
+            }
+            if(c.type=='E')
+                static_cast<Voltage_control_voltage_source*>(comp)->setInputValue(c.values[0],ref[0],ref[1]);
+            else
+                static_cast<Voltage_control_current_source*>(comp)->setInputValue(c.values[0],ref[0],ref[1]);
+        }else if(c.type=='F' || c.type=='H'){
+            int source = names.find(c.control);
+            if(source<0 || cards[source].type!='V'){
+                qDeleteAll(components);
+                return fail(c.line,QString("controlling source ")+QString::fromStdString(c.control)+QString(" of ")+c.name+QString(" is not a voltage source"));
+            }
+            if(c.type=='F')
+                static_cast<Current_control_current_source*>(comp)->setInputValue(c.values[0],QString::fromStdString(c.control));
+            else
+                static_cast<Current_control_voltage_source*>(comp)->setInputValue(c.values[0],QString::fromStdString(c.control));
+        }
+    }
+    for(auto comp:components)
+        circuit.push_backComponent(comp);
+    circuit.netlist_connection(node_names.size());
+    circuit.sort_the_allcomponent();
+    return true;
+}
+const QVector<netlist_directive>& Netlist::get_directives()
+{
+    return directives;
+}
+const QVector<QString>& Netlist::get_node_names()
+{
+    return node_names;
+}
+const QString& Netlist::get_error()
+{
+    return error;
+}
+Netlist::~Netlist()
+{
+
+}
@@ -0,0 +1,63 @@
+#ifndef NETLIST_H
+#define NETLIST_H
+#include <QString>
+#include <QVector>
+#include <istream>
+#include <string>
+#include <vector>
+#include "circuit.h"
+#include "symboltable.h"
+
+enum netlist_analysis{
+    netlist_op = 0,
+    netlist_tran,//.tran step stop
+    netlist_dc,//.dc source start stop step
+};
+struct netlist_directive{
+    int analysis = netlist_op;
+    QString source;//swept element of .dc
+    double start = 0;
+    double stop = 0;
+    double step = 0;
+};
+//spice style cards without a schematic: R C L D V I E G F H, .op .tran .dc .end and * comments
+//node 0, gnd or a node named by a GND card is ground, the others are numbered in order of appearance
+class Netlist
+{
+    private:
+        struct card{
+            char type;
+            QString name;
+            std::vector<std::string> nodes;//terminals, then the controlling nodes of E and G
+            std::vector<double> values;
+            int mode = 0;//sources: dc, sine or square
+            std::string control;//controlling voltage source of F and H
+            int line = 0;
+        };
+        std::vector<card> cards;
+        std::vector<std::string> grounds;
+        QVector<QString> node_names;//index is the node number, 0 is ground
+        SymbolTable<std::string> node_symbols;
+        std::vector<int> node_number;//by symbol id, -1 until the name is used as a node
+        int find_node(const std::string &name)const;//-1 for a name no element is connected to
+        QVector<netlist_directive> directives;
+        QString error;
+        bool fail(int line,const QString &message);
+        bool parse_card(std::vector<std::string> &tokens,int line);
+        bool parse_source(card &c,const std::vector<std::string> &tokens,int line);
+        int node(const std::string &name);
+        bool build(Circuit &circuit);
+    public:
+        Netlist();
+        bool read_file(const QString &path,Circuit &circuit);
+        bool read(std::istream &in,Circuit &circuit);//cards become components of circuit, ready for analysis
+        static bool parse_value(const std::string &s,double &value);//f p n u m k M/Meg G suffixes, m is milli
+        static bool parse_directive(const std::vector<std::string> &tokens,netlist_directive &d,QString &error);
+        static std::vector<std::string> split(const std::string &line);
+        const QVector<netlist_directive>& get_directives();
+        const QVector<QString>& get_node_names();
+        const QString& get_error();
+        ~Netlist();
+};
+
+#endif // NETLIST_H
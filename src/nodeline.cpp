@@ -0,0 +1,111 @@
+#include "nodeline.h"
+#include <algorithm>
+NodeLine::NodeLine():node1(),node2()
+{
+    deleted = false;
+    node_num = -1;
+}
+NodeLine::NodeLine(const QPoint& p1,const QPoint& p2):node1(),node2()
+{
+    setEnds(p1,p2);
+    deleted = false;
+    node_num = -1;
+}
+void NodeLine::setEnds(const QPoint& p1,const QPoint& p2)
+{
+    if(p1.x()==p2.x()){
+        verticle = true;
+    }else if(p1.y()==p2.y()){
+        verticle = false;
+    }
+    node1.setPosition(p1);
+    node2.setPosition(p2);
+}
+bool NodeLine::on_the_line(const Node& n)
+{
+    QPoint p = n.getPosition();
+    if(verticle && p.x() == node1.getPosition().x()){
+        int bound1 = node1.getPosition().y();
+        int bound2 = node2.getPosition().y();
+        if(bound2>bound1)
+            std::swap(bound1,bound2);
+
+        if(p.y()<=bound1&&p.y()>=bound2)
+            return true;
+        else
+            return false;
+    }else if(!verticle&& p.y() == node1.getPosition().y()){
+        int bound1 = node1.getPosition().x();
+        int bound2 = node2.getPosition().x();
+        if(bound2>bound1)
+            std::swap(bound1,bound2);
+        if(p.x()<=bound1&&p.x()>=bound2)
+            return true;
+        else
+            return false;
+    }else{
+        return false;
+    }
+}
+bool NodeLine::on_the_line(const QPoint& p)
+{
+    if(verticle && p.x() == node1.getPosition().x()){
+        int bound1 = node1.getPosition().y();
+        int bound2 = node2.getPosition().y();
+        if(bound2>bound1)
+            std::swap(bound1,bound2);
+
+        if(p.y()<=bound1&&p.y()>=bound2)
+            return true;
+        else
+            return false;
+    }else if(!verticle&& p.y() == node1.getPosition().y()){
+        int bound1 = node1.getPosition().x();
+        int bound2 = node2.getPosition().x();
+        if(bound2>bound1)
+            std::swap(bound1,bound2);
+        if(p.x()<=bound1&&p.x()>=bound2)
+            return true;
+        else
+            return false;
+    }else{
+        return false;
+    }
+}
+QPair<Node,Node> NodeLine::getNode()const
+{
+    QPair<Node,Node> p(node1,node2);
+    return p;
+}
+bool NodeLine::line_and_line_connect(const NodeLine& l)
+{
+    return on_the_line(l.getNode().first)||on_the_line(l.getNode().second);
+}
+void NodeLine::setNodeindex(int n)
+{
+    node1.setNodeIndex(n);
+    node2.setNodeIndex(n);
+    node_num = n;
+}
+void NodeLine::resetNodeIndex()
+{
+    node1.setNodeIndex(-1);
+    node2.setNodeIndex(-1);
+    node_num = -1;
+}
+void NodeLine::Delete()
+{
+    deleted = true;
+}
+bool NodeLine::getDelete()
+{
+    return deleted;
+}
+int NodeLine::getNodeindex()
+{
+    return node_num;
+}
+NodeLine::~NodeLine()
+{
+
+}
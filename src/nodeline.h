@@ -0,0 +1,33 @@
+#ifndef NODELINE_H
+#define NODELINE_H
+
+#include <QPair>
+#include <QPoint>
+#include "node.h"
+
+//wire of the schematic as the connection analysis sees it, LineNodeitem draws it
+class NodeLine
+{
+protected:
+    Node node1;
+    Node node2;
+    int node_num;
+    bool deleted;
+    bool verticle;
+    void setEnds(const QPoint& p1,const QPoint& p2);
+public:
+    NodeLine();
+    NodeLine(const QPoint& p1,const QPoint& p2);
+    bool on_the_line(const Node& n);
+    bool on_the_line(const QPoint& p);
+    bool line_and_line_connect(const NodeLine& l);
+    QPair<Node,Node> getNode()const;
+    void setNodeindex(int n);
+    int getNodeindex();
+    void resetNodeIndex();
+    void Delete();
+    bool getDelete();
+    virtual ~NodeLine();
+};
+
+#endif // NODELINE_H
@@ -55,9 +55,46 @@ Oscilloscope::Oscilloscope(Circuit* c,QWidget *parent) :
     maxtimesteptext->setGeometry(200,240,130,25);
     maxtimestepline->setGeometry(350,240,130,25);
 
+    acsourcetext = new QLabel(this);
+    acsourceline = new QLineEdit(this);
+    acsourcetext->setText("AC source: ");
+    acsourcetext->setGeometry(200,330,130,25);
+    acsourceline->setGeometry(350,330,130,25);
+
+    acrangetext = new QLabel(this);
+    acstartline = new QLineEdit(this);
+    acstopline = new QLineEdit(this);
+    acpointsline = new QLineEdit(this);
+    acrangetext->setText("Freq / pts per dec: ");
+    acrangetext->setGeometry(200,365,150,25);
+    acstartline->setGeometry(350,365,60,25);
+    acstopline->setGeometry(415,365,60,25);
+    acpointsline->setGeometry(480,365,45,25);
+    acstartline->setPlaceholderText("start");
+    acstopline->setPlaceholderText("stop");
+    acpointsline->setPlaceholderText("10");
+    ac_mode = false;
+
+    steptext = new QLabel(this);
+    stepcomponentline = new QLineEdit(this);
+    stepstartline = new QLineEdit(this);
+    stepstopline = new QLineEdit(this);
+    steppointsline = new QLineEdit(this);
+    steptext->setText("Step / from / to / pts: ");
+    steptext->setGeometry(200,280,150,25);
+    stepcomponentline->setGeometry(350,280,60,25);
+    stepstartline->setGeometry(415,280,60,25);
+    stepstopline->setGeometry(480,280,60,25);
+    steppointsline->setGeometry(545,280,45,25);
+    stepcomponentline->setPlaceholderText("R1");
+    stepstartline->setPlaceholderText("from");
+    stepstopline->setPlaceholderText("to");
+    steppointsline->setPlaceholderText("5");
+    step_mode = false;
+
     warning = new QLabel(this);
     warning->setText("Time must be inputed a non-zero value");
-    warning->setGeometry(200,300,200,25);
+    warning->setGeometry(200,435,200,25);
     warning->hide();
 
     buttonOK = new QPushButton(this);
@@ -109,6 +146,17 @@ Oscilloscope::~Oscilloscope()
     delete timeline;
     delete maxtimesteptext;
     delete maxtimestepline;
+    delete acsourcetext;
+    delete acsourceline;
+    delete acrangetext;
+    delete acstartline;
+    delete acstopline;
+    delete acpointsline;
+    delete steptext;
+    delete stepcomponentline;
+    delete stepstartline;
+    delete stepstopline;
+    delete steppointsline;
     delete buttonOK;
     delete buttonCancel;
     delete buttonFullZoom;
@@ -157,7 +205,7 @@ void Oscilloscope::calculate()
 
 void Oscilloscope::add_series(int node)
 {
-    if(node == -1)
+    if(node == -1 || ac_mode || step_mode)
         return;
 
     QList<QPointF> points;
@@ -189,6 +237,13 @@ void Oscilloscope::add_series(int node)
 void Oscilloscope::customplot_calculate()
 {
     clearCustomPlotBeforeCalculate();
+    ac_mode = false;
+    step_mode = false;
+    ui->widget->xAxis->setScaleType(QCPAxis::stLinear);
+    ui->widget->xAxis->setTicker(QSharedPointer<QCPAxisTicker>(new QCPAxisTicker));
+    ui->widget->xAxis->setLabel("");
+    ui->widget->yAxis->setLabel("");
+    ui->widget->yAxis2->setVisible(false);
 
     circuit->analysis_circuit_connection();
     circuit->sort_the_allcomponent();
@@ -226,10 +281,212 @@ void Oscilloscope::customplot_calculate()
     ui->widget->yAxis->setRange(0,10);
 }
 
+void Oscilloscope::ac_calculate()
+{
+    clearCustomPlotBeforeCalculate();
+    ac_mode = true;
+    step_mode = false;
+
+    circuit->analysis_circuit_connection();
+    circuit->sort_the_allcomponent();
+    if(!circuit->ac_analysis(acsourceline->text(),ac_start,ac_stop,ac_points,ac_decade)){
+        qDebug()<<"ac analysis failed";
+        return;
+    }
+    //magnitude in dB on the left axis, phase in degrees on the right one
+    solutions = circuit->get_ac_magnitude();
+    ac_phase = circuit->get_ac_phase();
+    int num_of_data = solutions[0].first.get_row_num();
+    for(int i=0;i<solutions.size();i++){
+        for(int j=0;j<num_of_data;j++)
+            solutions[i].first.set_ij(j,0,20*log10(std::max(solutions[i].first(j,0),1e-15)));
+    }
+    for(int i=0;i<num_of_data;i++){
+        ui->widget->addGraph();
+        QPen pen(QColor(random.bounded(1,255),random.bounded(1,255),random.bounded(1,255)));
+        pen.setWidth(3);
+        ui->widget->graph(i)->setPen(pen);
+        all_yboundary.push_back(qMakePair(INT_MAX,INT_MIN));
+    }
+    for(int i=0;i<num_of_data;i++){
+        ui->widget->addGraph(ui->widget->xAxis,ui->widget->yAxis2);
+        QPen pen = ui->widget->graph(i)->pen();
+        pen.setStyle(Qt::DashLine);
+        ui->widget->graph(num_of_data+i)->setPen(pen);
+    }
+    for(int i=0;i<solutions.size();i++){
+        for(int j=0;j<num_of_data;j++){
+            all_yboundary[j].first = std::min(all_yboundary[j].first,solutions[i].first(j,0));
+            all_yboundary[j].second = std::max(all_yboundary[j].second,solutions[i].first(j,0));
+        }
+    }
+    for(int i=0;i<ui->widget->graphCount();i++)
+    {
+        ui->widget->graph(i)->setName("");
+        ui->widget->graph(i)->removeFromLegend();
+    }
+    nodesValue.resize(num_of_data);
+
+    ui->widget->xAxis->setScaleType(QCPAxis::stLogarithmic);
+    ui->widget->xAxis->setTicker(QSharedPointer<QCPAxisTickerLog>(new QCPAxisTickerLog));
+    ui->widget->xAxis->setLabel("Frequency (Hz)");
+    ui->widget->yAxis->setLabel("Magnitude (dB)");
+    ui->widget->yAxis2->setLabel("Phase (deg)");
+    ui->widget->yAxis2->setVisible(true);
+    ui->widget->yAxis2->setRange(-180,180);
+    ui->widget->xAxis->setRange(ac_start,ac_stop);
+    ui->widget->yAxis->setRange(-60,10);
+}
+
+void Oscilloscope::custom_add_ac_series(int node)
+{
+    QVector<double> x,y,phase;
+    for(int i=0;i<solutions.size();i++){
+        x.push_back(solutions[i].second);
+        y.push_back(solutions[i].first(node,0));
+        phase.push_back(ac_phase[i].first(node,0));
+        nowGraphingx.push_back(solutions[i].second);
+        nowGraphingy.push_back(solutions[i].first(node,0));
+    }
+    nodesValue[node] = y;
+
+    y_upperBound = std::max(y_upperBound,all_yboundary[node].second);
+    y_lowerBound = std::min(y_lowerBound,all_yboundary[node].first);
+
+    int num_of_data = solutions[0].first.get_row_num();
+    ui->widget->graph(node)->setData(x,y);
+    ui->widget->graph(node)->setName("Node" + QString::number(node+1) + " dB");
+    ui->widget->graph(node)->addToLegend();
+    ui->widget->graph(num_of_data+node)->setData(x,phase);
+    ui->widget->graph(num_of_data+node)->setName("Node" + QString::number(node+1) + " phase");
+    ui->widget->graph(num_of_data+node)->addToLegend();
+    ui->widget->legend->setVisible(true);
+
+    ui->objectComboBox->addItem("Node" + QString::number(node+1));
+
+    if(y_upperBound!=y_lowerBound)
+        ui->widget->yAxis->setRange(y_lowerBound,y_upperBound);
+    else
+        ui->widget->yAxis->setRange(y_lowerBound-10,y_upperBound);
+    ui->widget->xAxis->setRange(ac_start,ac_stop);
+
+    ui->widget->replot();
+}
+
+void Oscilloscope::step_calculate()
+{
+    clearCustomPlotBeforeCalculate();
+    ac_mode = false;
+    step_mode = true;
+    ui->widget->xAxis->setScaleType(QCPAxis::stLinear);
+    ui->widget->xAxis->setTicker(QSharedPointer<QCPAxisTicker>(new QCPAxisTicker));
+    ui->widget->xAxis->setLabel("");
+    ui->widget->yAxis->setLabel("");
+    ui->widget->yAxis2->setVisible(false);
+
+    circuit->analysis_circuit_connection();
+    circuit->sort_the_allcomponent();
+    QVector<step_parameter> steps;
+    step_parameter p;
+    p.component = stepcomponentline->text();
+    p.start = unit_transformer::transform(stepstartline->text());
+    p.stop = unit_transformer::transform(stepstopline->text());
+    p.points = steppointsline->text() != "" ? steppointsline->text().toInt() : 5;
+    steps.push_back(p);
+    step_component = p.component;
+    circuit->step_analysis(steps,time,maxtimestep!=0 ? maxtimestep : -1);
+    step_runs = circuit->get_step_runs();
+    //runs that failed are left out of the family
+    int first = -1;
+    for(int r=0;r<step_runs.size() && first<0;r++)
+        if(step_runs[r].completed)
+            first = r;
+    if(first<0){
+        qDebug()<<"step analysis failed";
+        step_mode = false;
+        return;
+    }
+    solutions = step_runs[first].solutions;
+    int num_of_data = solutions[0].first.get_row_num();
+    int runs = step_runs.size();
+    //one hue per run, so the family reads as a gradient from the first value to the last
+    for(int i=0;i<num_of_data;i++){
+        all_yboundary.push_back(qMakePair(INT_MAX,INT_MIN));
+        for(int r=0;r<runs;r++){
+            ui->widget->addGraph();
+            QPen pen(QColor::fromHsv(240*r/std::max(1,runs-1),255,200));
+            pen.setWidth(2);
+            ui->widget->graph(i*runs+r)->setPen(pen);
+            ui->widget->graph(i*runs+r)->setName("");
+            ui->widget->graph(i*runs+r)->removeFromLegend();
+        }
+    }
+    for(int r=0;r<runs;r++){
+        if(!step_runs[r].completed)
+            continue;
+        for(int i=1;i<step_runs[r].solutions.size();i++){
+            for(int j=0;j<num_of_data;j++){
+                all_yboundary[j].first = std::min(all_yboundary[j].first,step_runs[r].solutions[i].first(j,0));
+                all_yboundary[j].second = std::max(all_yboundary[j].second,step_runs[r].solutions[i].first(j,0));
+            }
+        }
+    }
+    nodesValue.resize(num_of_data);
+
+    ui->widget->xAxis->setRange(0,10);
+    ui->widget->yAxis->setRange(0,10);
+}
+
+void Oscilloscope::custom_add_step_series(int node)
+{
+    //measurements run over the whole family
+    QVector<double> family;
+    int runs = step_runs.size();
+    for(int r=0;r<runs;r++){
+        if(!step_runs[r].completed)
+            continue;
+        QVector<double> x,y;
+        const QVector< QPair<Matrix,double> > &run = step_runs[r].solutions;
+        for(int i=1;i<run.size();i++){
+            x.push_back(run[i].second);
+            y.push_back(run[i].first(node,0));
+            nowGraphingx.push_back(run[i].second);
+            nowGraphingy.push_back(run[i].first(node,0));
+        }
+        family += y;
+        ui->widget->graph(node*runs+r)->setData(x,y);
+        ui->widget->graph(node*runs+r)->setName("Node" + QString::number(node+1) + " " + step_component + "=" + QString::number(step_runs[r].values[0]));
+        ui->widget->graph(node*runs+r)->addToLegend();
+    }
+    nodesValue[node] = family;
+    ui->widget->legend->setVisible(true);
+
+    y_upperBound = std::max(y_upperBound,all_yboundary[node].second);
+    y_lowerBound = std::min(y_lowerBound,all_yboundary[node].first);
+
+    ui->objectComboBox->addItem("Node" + QString::number(node+1));
+
+    if(y_upperBound!=y_lowerBound)
+        ui->widget->yAxis->setRange(y_lowerBound,y_upperBound);
+    else
+        ui->widget->yAxis->setRange(y_lowerBound-10,y_upperBound);
+    ui->widget->xAxis->setRange(0,time);
+
+    ui->widget->replot();
+}
+
 void Oscilloscope::custom_add_series(int node)
 {
-    if(node == -1)
+    if(node == -1 || node >= nodesValue.size())
+        return;
+    if(ac_mode){
+        custom_add_ac_series(node);
+        return;
+    }
+    if(step_mode){
+        custom_add_step_series(node);
         return;
+    }
 /*    QString temp = "Node" + QString::number(node+1);
     for(int i=0;i<ui->objectComboBox->count();i++)
         if(ui->objectComboBox[i].accessibleName() == temp)
@@ -288,7 +545,19 @@ void Oscilloscope::pushButtonOK()
 {
 //    do
 //   {
-        if(timeline->text() != "" && timeline->text() != "0")
+        if(acsourceline->text() != "" && acstartline->text() != "" && acstopline->text() != "")
+        {
+            ac_start = unit_transformer::transform(acstartline->text());
+            ac_stop = unit_transformer::transform(acstopline->text());
+            ac_points = acpointsline->text() != "" ? acpointsline->text().toInt() : 10;
+            hideInput();
+            showOscilloscope();
+            ac_calculate();
+            y_upperBound = INT_MIN;
+            y_lowerBound = INT_MAX;
+            warning->hide();
+        }
+        else if(timeline->text() != "" && timeline->text() != "0")
         {
             time = unit_transformer::transform(timeline->text());
             if(maxtimestepline->text() != "")
@@ -299,8 +568,12 @@ void Oscilloscope::pushButtonOK()
             xAxis->setMax(time);
             hideInput();
             showOscilloscope();
-            calculate();
-            customplot_calculate();
+            if(stepcomponentline->text() != "" && stepstartline->text() != "" && stepstopline->text() != ""){
+                step_calculate();
+            }else{
+                calculate();
+                customplot_calculate();
+            }
             y_upperBound = INT_MIN;
             y_lowerBound = INT_MAX;
             warning->hide();
@@ -419,6 +692,17 @@ void Oscilloscope::showInput()
     timeline->show();
     maxtimesteptext->show();
     maxtimestepline->show();
+    acsourcetext->show();
+    acsourceline->show();
+    acrangetext->show();
+    acstartline->show();
+    acstopline->show();
+    acpointsline->show();
+    steptext->show();
+    stepcomponentline->show();
+    stepstartline->show();
+    stepstopline->show();
+    steppointsline->show();
     buttonOK->show();
     buttonCancel->show();
 }
@@ -429,6 +713,17 @@ void Oscilloscope::hideInput()
     timeline->hide();
     maxtimesteptext->hide();
     maxtimestepline->hide();
+    acsourcetext->hide();
+    acsourceline->hide();
+    acrangetext->hide();
+    acstartline->hide();
+    acstopline->hide();
+    acpointsline->hide();
+    steptext->hide();
+    stepcomponentline->hide();
+    stepstartline->hide();
+    stepstopline->hide();
+    steppointsline->hide();
     buttonOK->hide();
     buttonCancel->hide();
 }
@@ -50,6 +50,17 @@ private:
     QLineEdit *timeline;
     QLabel *maxtimesteptext;
     QLineEdit *maxtimestepline;
+    QLabel *acsourcetext;
+    QLineEdit *acsourceline;
+    QLabel *acrangetext;
+    QLineEdit *acstartline;
+    QLineEdit *acstopline;
+    QLineEdit *acpointsline;
+    QLabel *steptext;
+    QLineEdit *stepcomponentline;
+    QLineEdit *stepstartline;
+    QLineEdit *stepstopline;
+    QLineEdit *steppointsline;
     QLabel *warning;
     QPushButton *buttonOK;
     QPushButton *buttonCancel;
@@ -59,9 +70,21 @@ private:
     QRandomGenerator random;
     double time;
     double maxtimestep;
+    bool ac_mode;//solutions hold |x| in dB against frequency
+    double ac_start;
+    double ac_stop;
+    int ac_points;
+    QVector< QPair<Matrix,double> > ac_phase;
+    bool step_mode;//one graph per run and node, graph node*runs+run
+    QVector<step_run> step_runs;
+    QString step_component;
 
     void calculate();
     void customplot_calculate();
+    void ac_calculate();
+    void custom_add_ac_series(int node);
+    void step_calculate();
+    void custom_add_step_series(int node);
     QVector<double> nowGraphingx;
     QVector<double> nowGraphingy;
     QVector<QVector<double>> nodesValue;
@@ -2,10 +2,10 @@
 #include <unit_transformer.h>
 Resistor::Resistor()
 {
-    resistordialog = nullptr;
+
 }
 
-Resistor::Resistor(const QString &s, QRect &r,QGraphicsScene *sc):RLCComponent(s,r,sc)
+Resistor::Resistor(ComponentView *view,QRect &r):RLCComponent(view,r)
 {
     bool find = false;
     for(int i=0;i<num_list.size();i++){
@@ -23,19 +23,16 @@ Resistor::Resistor(const QString &s, QRect &r,QGraphicsScene *sc):RLCComponent(s
 
     setName(QString("R")+QString::number(num+1));
     image->setCharacteristic(QString("R"));
-    resistordialog = new Resistordialog();
-    resistordialog->setModal(true);
 }
 void Resistor::Delete()
 {
     num_list[num] = 0;
 }
-void Resistor::InputValue()
+void Resistor::setInputValue(const QString &input)
 {
-    resistordialog->exec();
-    resistance = unit_transformer::transform(resistordialog->getInput());
-    image->setCharacteristic(resistordialog->getInput());
-    image->setInput(false);
+    resistance = unit_transformer::transform(input);
+    if(image)
+        image->setCharacteristic(input);
     qDebug() << resistance;
 }
 bool Resistor::isDependant()
@@ -46,8 +43,21 @@ double Resistor::get_resistance()
 {
     return resistance;
 }
+void Resistor::set_resistance(double value)
+{
+    resistance = value;
+}
+Resistor* Resistor::solver_copy()const
+{
+    Resistor* c = new Resistor();
+    c->setName(getname());
+    c->resistance = resistance;
+    c->num = num;
+    for(int i=0;i<nodes.size();i++)
+        c->nodes[i]->setNodeIndex(nodes[i]->getNodeIndex());
+    return c;
+}
 Resistor::~Resistor()
 {
-    delete resistordialog;
 }
 QVector<bool> Resistor::num_list;
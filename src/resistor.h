@@ -3,7 +3,6 @@
 
 #include <QObject>
 #include "rlccomponent.h"
-#include "resistordialog.h"
 
 class Resistor:public RLCComponent
 {
@@ -11,15 +10,16 @@ private:
     double resistance;
     int num;
     static QVector<bool> num_list; //1 for exist 0 for not
-    Resistordialog *resistordialog;
 
 public:
     Resistor();
-    Resistor(const QString &s,QRect &r,QGraphicsScene *sc);
+    Resistor(ComponentView *view,QRect &r);
     void Delete();
-    void InputValue();
+    void setInputValue(const QString &input);//value as typed, unit suffixes allowed
     bool isDependant();
     double get_resistance();
+    void set_resistance(double value);
+    Resistor* solver_copy()const;//value and node indices only, for runs on another thread
     ~Resistor();
 
 
@@ -6,7 +6,7 @@ RLCComponent::RLCComponent()
     nodes.push_back(new Node());
 }
 
-RLCComponent::RLCComponent(const QString &s, QRect &r,QGraphicsScene *sc):Component(s,r,sc)
+RLCComponent::RLCComponent(ComponentView *view,QRect &r):Component(view)
 {
     rect = r;
     nodes.push_back(new Node());
@@ -28,13 +28,13 @@ int RLCComponent::getNodeindex2()
 int getNodeindex2();
 void RLCComponent::setPos(int x,int y)
 {
-    image->setPos(x,y);
+    image->moveTo(x,y);
     nodes[0]->setPosition(x,y+  rect.height()/2);
     nodes[1]->setPosition(x+rect.width(),y+rect.height()/2);
 }
 void RLCComponent::setPos(QPoint& p)
 {
-    image->setPos(p.x(),p.y());
+    image->moveTo(p.x(),p.y());
     nodes[0]->setPosition(p.x(),p.y() + rect.height()/2);
     nodes[1]->setPosition(p.x()+rect.width(),p.y()+rect.height()/2);
 }
@@ -11,7 +11,7 @@ class RLCComponent:public Component
         QRect rect;
     public:
         RLCComponent();
-        RLCComponent(const QString &s, QRect &r,QGraphicsScene *sc);
+        RLCComponent(ComponentView *view,QRect &r);
         const QPair<Node*,Node*> getNodePos();
         void setNodeindex(int,int);
         int getNodeindex1();//-
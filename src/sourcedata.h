@@ -0,0 +1,59 @@
+#ifndef SOURCEDATA_H
+#define SOURCEDATA_H
+
+struct voltageDCdata
+{
+    double voltage;
+};
+
+struct voltageSinedata
+{
+    double amplitude;
+    double offset;
+    double phase;
+};
+
+struct voltageSquaredata
+{
+    double Von;
+    double Voff;
+    double Tperiod;
+    double Ton;
+
+};
+
+union voltageSourcedata
+{
+    voltageDCdata dcData;
+    voltageSinedata sineData;
+    voltageSquaredata squareData;
+};
+
+struct currentDCdata
+{
+    double current;
+};
+
+struct currentSinedata
+{
+    double amplitude;
+    double offset;
+    double phase;
+};
+
+struct currentSquaredata
+{
+    double Ion;
+    double Ioff;
+    double Tperiod;
+    double Ton;
+};
+
+union currentSourcedata
+{
+    currentDCdata dcData;
+    currentSinedata sineData;
+    currentSquaredata squareData;
+};
+
+#endif // SOURCEDATA_H
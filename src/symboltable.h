@@ -0,0 +1,86 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+#include <vector>
+#include <functional>
+
+//interned names: every distinct name gets a dense id 0,1,2... in the order it is first seen
+//open addressing with linear probing, ids are never removed so per-name data can live in plain vectors
+template<class Key,class Hash = std::hash<Key> >
+class SymbolTable
+{
+    private:
+        std::vector<Key> names;//by id
+        std::vector<size_t> hashes;//by id, growing does not hash the names again
+        std::vector<int> buckets;//id or -1, a power of two and at most half full
+        Hash hasher;
+        size_t probe(const Key &name,size_t h)const;//slot of name, or the empty slot where it would go
+        void grow();
+    public:
+        int find(const Key &name)const;//-1 for a name never interned
+        int intern(const Key &name);//id of name, a new one the first time
+        const Key& name(int id)const;
+        int size()const;
+        void clear();
+};
+
+template<class Key,class Hash>
+size_t SymbolTable<Key,Hash>::probe(const Key &name,size_t h)const
+{
+    size_t mask = buckets.size()-1;
+    size_t i = h & mask;
+    while(buckets[i]>=0 && !(hashes[buckets[i]]==h && names[buckets[i]]==name))
+        i = (i+1) & mask;
+    return i;
+}
+template<class Key,class Hash>
+void SymbolTable<Key,Hash>::grow()
+{
+    buckets.assign(buckets.empty() ? 16 : 2*buckets.size(),-1);
+    size_t mask = buckets.size()-1;
+    for(int id=0;id<(int)names.size();id++){
+        size_t i = hashes[id] & mask;
+        while(buckets[i]>=0)
+            i = (i+1) & mask;
+        buckets[i] = id;
+    }
+}
+template<class Key,class Hash>
+int SymbolTable<Key,Hash>::find(const Key &name)const
+{
+    if(buckets.empty())
+        return -1;
+    return buckets[probe(name,hasher(name))];
+}
+template<class Key,class Hash>
+int SymbolTable<Key,Hash>::intern(const Key &name)
+{
+    if(2*(names.size()+1)>buckets.size())
+        grow();
+    size_t h = hasher(name);
+    size_t i = probe(name,h);
+    if(buckets[i]<0){
+        buckets[i] = names.size();
+        names.push_back(name);
+        hashes.push_back(h);
+    }
+    return buckets[i];
+}
+template<class Key,class Hash>
+const Key& SymbolTable<Key,Hash>::name(int id)const
+{
+    return names[id];
+}
+template<class Key,class Hash>
+int SymbolTable<Key,Hash>::size()const
+{
+    return names.size();
+}
+template<class Key,class Hash>
+void SymbolTable<Key,Hash>::clear()
+{
+    names.clear();
+    hashes.clear();
+    buckets.clear();
+}
+
+#endif // SYMBOLTABLE_H
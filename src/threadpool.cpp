@@ -0,0 +1,83 @@
+#include "threadpool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threads)
+{
+    job = nullptr;
+    job_size = 0;
+    job_grain = 1;
+    next_chunk = 0;
+    finished = 0;
+    generation = 0;
+    stop = false;
+    for(int i=1;i<threads;i++)
+        workers.push_back(std::thread(&ThreadPool::worker_loop,this));
+}
+int ThreadPool::size()const
+{
+    return workers.size()+1;
+}
+void ThreadPool::run_chunks()
+{
+    int chunks = (job_size+job_grain-1)/job_grain;
+    for(int c=next_chunk++;c<chunks;c=next_chunk++){
+        int begin = c*job_grain;
+        int end = std::min(job_size,begin+job_grain);
+        (*job)(begin,end);
+    }
+}
+void ThreadPool::worker_loop()
+{
+    long seen = 0;
+    while(true){
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard,[&]{return stop || generation!=seen;});
+            if(stop)
+                return;
+            seen = generation;
+        }
+        run_chunks();
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            finished++;
+            if(finished==int(workers.size()))
+                done.notify_all();
+        }
+    }
+}
+void ThreadPool::parallel_for(int n,int grain,const std::function<void(int,int)>& body)
+{
+    if(n<=0)
+        return;
+    if(workers.empty() || n<=grain){
+        for(int begin=0;begin<n;begin+=grain)
+            body(begin,std::min(n,begin+grain));
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        job = &body;
+        job_size = n;
+        job_grain = grain;
+        next_chunk = 0;
+        finished = 0;
+        generation++;
+    }
+    wake.notify_all();
+    run_chunks();
+    std::unique_lock<std::mutex> guard(lock);
+    //every worker has to check in, so none is left holding this job
+    done.wait(guard,[&]{return finished==int(workers.size());});
+    job = nullptr;
+}
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        stop = true;
+    }
+    wake.notify_all();
+    for(size_t i=0;i<workers.size();i++)
+        workers[i].join();
+}
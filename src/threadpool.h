@@ -0,0 +1,35 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+class ThreadPool
+{
+    private:
+        std::vector<std::thread> workers;
+        std::mutex lock;
+        std::condition_variable wake;
+        std::condition_variable done;
+        const std::function<void(int,int)>* job;
+        int job_size;
+        int job_grain;
+        std::atomic<int> next_chunk;
+        int finished;//workers done with the current generation
+        long generation;
+        bool stop;
+        void worker_loop();
+        void run_chunks();
+    public:
+        ThreadPool(int threads);
+        int size()const;//worker threads plus the calling thread
+        //body(begin,end) for fixed chunks of grain indices, the caller helps and waits
+        //chunk boundaries do not depend on the thread count
+        void parallel_for(int n,int grain,const std::function<void(int,int)>& body);
+        ~ThreadPool();
+};
+
+#endif // THREADPOOL_H
@@ -6,7 +6,7 @@ Voltage_control_current_source::Voltage_control_current_source()
     nodes.push_back(new Node());
 }
 
-Voltage_control_current_source::Voltage_control_current_source(const QString &s,QRect &r,QGraphicsScene *sc):Component(s,r,sc)
+Voltage_control_current_source::Voltage_control_current_source(ComponentView *view,QRect &r):Component(view)
 {
     nodes.push_back(new Node());
     nodes.push_back(new Node());
@@ -28,10 +28,6 @@ Voltage_control_current_source::Voltage_control_current_source(const QString &s,
     //setup components name
     setName(QString("VCIS")+QString::number(num+1));
     image->setCharacteristic(QString("IS"));
-
-    //setup dialog
-    voltage_control_current_source_dialog = new Voltage_control_current_source_dialog();
-    voltage_control_current_source_dialog->setModal(true);
 }
 void Voltage_control_current_source::Delete()
 {
@@ -50,19 +46,19 @@ bool Voltage_control_current_source::isDependant()
 double Voltage_control_current_source::getCoefficient(){
     return coefficient;
 }
-void Voltage_control_current_source::InputValue()
+void Voltage_control_current_source::setInputValue(double coefficient_value,const QString &node1,const QString &node2)
 {
-    voltage_control_current_source_dialog->exec();
-    voltage_control_current_source_dialog->getInput(coefficient,nameNode1,nameNode2);
+    coefficient = coefficient_value;
+    nameNode1 = node1;
+    nameNode2 = node2;
     qDebug() << coefficient;
     qDebug() << nameNode1;
     qDebug() << nameNode2;
-    image->setInput(false);
-    image->setCharacteristic(QString::number(coefficient) + "(" + nameNode2 + "-" + nameNode1 + ")");
+    if(image)
+        image->setCharacteristic(QString::number(coefficient) + "(" + nameNode2 + "-" + nameNode1 + ")");
 }
 Voltage_control_current_source::~Voltage_control_current_source()
 {
-    delete voltage_control_current_source_dialog;
 }
 const QPair<Node*,Node*> Voltage_control_current_source::getNodePos()
 {
@@ -90,13 +86,13 @@ QString Voltage_control_current_source::getDependantNode2()
 
 void Voltage_control_current_source::setPos(int x,int y)
 {
-    image->setPos(x,y);
+    image->moveTo(x,y);
     nodes[0]->setPosition(x,y+  rect.height()/2);
     nodes[1]->setPosition(x+rect.width(),y+rect.height()/2);
 }
 void Voltage_control_current_source::setPos(QPoint& p)
 {
-    image->setPos(p.x(),p.y());
+    image->moveTo(p.x(),p.y());
     nodes[0]->setPosition(p.x(),p.y() + rect.height()/2);
     nodes[1]->setPosition(p.x()+rect.width(),p.y()+rect.height()/2);
 }
@@ -3,7 +3,6 @@
 
 #include "component.h"
 #include "node.h"
-#include "voltage_control_current_source_dialog.h"
 #include "Constant.h"
 
 class Voltage_control_current_source : public Component
@@ -16,12 +15,11 @@ private:
     QRect rect;
     int num;
     static QVector<bool> num_list; //1 for exist 0 for not
-    Voltage_control_current_source_dialog *voltage_control_current_source_dialog;
     int mode;
     enum mode{DC,Sine,Square};
 public:
     Voltage_control_current_source();
-    Voltage_control_current_source(const QString &s,QRect &r,QGraphicsScene *sc);
+    Voltage_control_current_source(ComponentView *view,QRect &r);
     const QPair<Node*,Node*> getNodePos();
     int getNodeindex1();//-
     int getNodeindex2();//+
@@ -33,7 +31,7 @@ public:
     void setPos(QPoint& p);
     void setNodeRotation(int rotateA);
     void Delete();
-    void InputValue();
+    void setInputValue(double coefficient_value,const QString &node1,const QString &node2);//coefficient and the controlling node names
     bool isDCsource();
     bool isDependant();
     ~Voltage_control_current_source();
@@ -6,7 +6,7 @@ Voltage_control_voltage_source::Voltage_control_voltage_source()
     nodes.push_back(new Node());
 }
 
-Voltage_control_voltage_source::Voltage_control_voltage_source(const QString &s,QRect &r,QGraphicsScene *sc):Component(s,r,sc)
+Voltage_control_voltage_source::Voltage_control_voltage_source(ComponentView *view,QRect &r):Component(view)
 {
     nodes.push_back(new Node());
     nodes.push_back(new Node());
@@ -27,10 +27,6 @@ Voltage_control_voltage_source::Voltage_control_voltage_source(const QString &s,
     }
     setName(QString("VCVS")+QString::number(num+1));
     image->setCharacteristic(QString("IS"));
-
-    voltage_control_voltage_source_dialog = new Voltage_control_voltage_source_dialog();
-
-    voltage_control_voltage_source_dialog->setModal(true);
 }
 
 const QPair<Node*,Node*> Voltage_control_voltage_source::getNodePos()
@@ -81,14 +77,14 @@ double Voltage_control_voltage_source::get_voltage(double t)
 
 void Voltage_control_voltage_source::setPos(int x,int y)
 {
-    image->setPos(x,y);
+    image->moveTo(x,y);
     nodes[0]->setPosition(x,y+  rect.height()/2);
     nodes[1]->setPosition(x+rect.width(),y+rect.height()/2);
 }
 
 void Voltage_control_voltage_source::setPos(QPoint& p)
 {
-    image->setPos(p.x(),p.y());
+    image->moveTo(p.x(),p.y());
     nodes[0]->setPosition(p.x(),p.y() + rect.height()/2);
     nodes[1]->setPosition(p.x()+rect.width(),p.y()+rect.height()/2);
 }
@@ -124,18 +120,18 @@ void Voltage_control_voltage_source::Delete()
     num_list[num] = 0;
 }
 
-void Voltage_control_voltage_source::InputValue()
+void Voltage_control_voltage_source::setInputValue(double coefficient_value,const QString &node1,const QString &node2)
 {
-    voltage_control_voltage_source_dialog->exec();
-    voltage_control_voltage_source_dialog->getInput(coefficient,nameNode1,nameNode2);
-    image->setInput(false);
-    image->setCharacteristic(QString::number(coefficient) + "(" + nameNode2 + "-" + nameNode1 + ")");
+    coefficient = coefficient_value;
+    nameNode1 = node1;
+    nameNode2 = node2;
+    if(image)
+        image->setCharacteristic(QString::number(coefficient) + "(" + nameNode2 + "-" + nameNode1 + ")");
 }
 
 
 Voltage_control_voltage_source::~Voltage_control_voltage_source()
 {
-    delete voltage_control_voltage_source_dialog;
 }
 
 QVector<bool> Voltage_control_voltage_source::num_list;
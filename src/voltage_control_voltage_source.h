@@ -3,7 +3,6 @@
 
 #include "component.h"
 #include "node.h"
-#include "voltage_control_voltage_source_dialog.h"
 #include "Constant.h"
 
 class Voltage_control_voltage_source : public Component
@@ -18,10 +17,9 @@ private:
     static QVector<bool> num_list;
     enum mode{DC,Sine,Square};
     int mode;
-    Voltage_control_voltage_source_dialog *voltage_control_voltage_source_dialog;
 public:
     Voltage_control_voltage_source();
-    Voltage_control_voltage_source(const QString &s,QRect &r,QGraphicsScene *sc);
+    Voltage_control_voltage_source(ComponentView *view,QRect &r);
     const QPair<Node*,Node*> getNodePos();
     int getNodeindex1();//-
     int getNodeindex2();//+
@@ -33,7 +31,7 @@ public:
     void setPos(QPoint& p);
     void setNodeRotation(int rotateA);
     void Delete();
-    void InputValue();
+    void setInputValue(double coefficient_value,const QString &node1,const QString &node2);//coefficient and the controlling node names
     bool isDCsource();
     bool isDependant();
     ~Voltage_control_voltage_source();
@@ -2,10 +2,11 @@
 
 voltage_source::voltage_source()
 {
+    num = 0;
     nodes.push_back(new Node());
     nodes.push_back(new Node());
 }
-voltage_source::voltage_source(const QString &s,QRect &r,QGraphicsScene *sc):Component(s,r,sc)
+voltage_source::voltage_source(ComponentView *view,QRect &r):Component(view)
 {
     nodes.push_back(new Node());
     nodes.push_back(new Node());
@@ -26,8 +27,6 @@ voltage_source::voltage_source(const QString &s,QRect &r,QGraphicsScene *sc):Com
 
     setName(QString("VS")+QString::number(num+1));
     image->setCharacteristic(QString("VS"));
-    voltagesourcedialog = new Voltagesourcedialog();
-    voltagesourcedialog->setModal(true);
 
 
 
@@ -36,12 +35,36 @@ int voltage_source::get_num()
 {
     return num;
 }
+void voltage_source::set_num(int n)
+{
+    num = n;
+}
 bool voltage_source::isDCsource()
 {
     if(mode == DC)
         return true;
     return false;
 }
+bool voltage_source::isSquaresource()
+{
+    if(mode == Square)
+        return true;
+    return false;
+}
+double voltage_source::getNextBreakpoint(double t)
+{
+    if(mode != Square)
+        return INFINITY;
+    double period = voltagesourcedata.squareData.Tperiod;
+    double on = voltagesourcedata.squareData.Ton;
+    double start = floor(t/period)*period;
+    //each period starts with the on phase, same as get_voltage
+    if(start+on>t+1e-12*period)
+        return start+on;
+    if(start+period>t+1e-12*period)
+        return start+period;
+    return start+period+on;
+}
 bool voltage_source::isDependant()
 {
     return false;
@@ -78,15 +101,46 @@ double voltage_source::get_voltage(double t)
             break;
     }
 }
+double voltage_source::get_amplitude()
+{
+    if(mode == Sine)
+        return voltagesourcedata.sineData.amplitude;
+    else if(mode == Square)
+        return voltagesourcedata.squareData.Von;
+    return voltagesourcedata.dcData.voltage;
+}
+void voltage_source::set_amplitude(double value)
+{
+    if(mode == Sine)
+        voltagesourcedata.sineData.amplitude = value;
+    else if(mode == Square)
+        voltagesourcedata.squareData.Von = value;
+    else
+        voltagesourcedata.dcData.voltage = value;
+}
+voltage_source* voltage_source::solver_copy()const
+{
+    voltage_source* c = new voltage_source();
+    c->setName(getname());
+    c->num = num;
+    c->voltagesourcedata = voltagesourcedata;
+    c->frequency = frequency;
+    c->mode = mode;
+    for(int i=0;i<nodes.size();i++)
+        c->nodes[i]->setNodeIndex(nodes[i]->getNodeIndex());
+    return c;
+}
 double voltage_source::getFrequency()
 {
     return frequency;
 }
-void voltage_source::InputValue()
+void voltage_source::setInputValue(const voltageSourcedata &data,double source_frequency,int source_mode)
 {
-    voltagesourcedialog->exec();
-    voltagesourcedialog->getInput(voltagesourcedata,frequency,mode);
-    image->setInput(false);
+    voltagesourcedata = data;
+    frequency = source_frequency;
+    mode = source_mode;
+    if(!image)
+        return;
     if(mode == DC){
         image->setCharacteristic(QString::number(voltagesourcedata.dcData.voltage));
     }else if(mode == Sine){
@@ -99,7 +153,6 @@ void voltage_source::InputValue()
 }
 voltage_source::~voltage_source()
 {
-    delete voltagesourcedialog;
 }
 const QPair<Node*,Node*> voltage_source::getNodePos()
 {
@@ -116,13 +169,13 @@ int voltage_source::getNodeindex2()
 }
 void voltage_source::setPos(int x,int y)
 {
-    image->setPos(x,y);
+    image->moveTo(x,y);
     nodes[0]->setPosition(x,y+  rect.height()/2);
     nodes[1]->setPosition(x+rect.width(),y+rect.height()/2);
 }
 void voltage_source::setPos(QPoint& p)
 {
-    image->setPos(p.x(),p.y());
+    image->moveTo(p.x(),p.y());
     nodes[0]->setPosition(p.x(),p.y() + rect.height()/2);
     nodes[1]->setPosition(p.x()+rect.width(),p.y()+rect.height()/2);
 }
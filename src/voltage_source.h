@@ -3,7 +3,7 @@
 
 #include "component.h"
 #include "node.h"
-#include "voltagesourcedialog.h"
+#include "sourcedata.h"
 #include "Constant.h"
 
 class voltage_source : public Component
@@ -12,26 +12,31 @@ class voltage_source : public Component
         QRect rect;
         int num;
         static QVector<bool> num_list; //1 for exist 0 for not
-        Voltagesourcedialog *voltagesourcedialog;
         voltageSourcedata voltagesourcedata;
         double frequency;
         int mode;
         enum mode{DC,Sine,Square};
     public:
         voltage_source();
-        voltage_source(const QString &s,QRect &r,QGraphicsScene *sc);
+        voltage_source(ComponentView *view,QRect &r);
         const QPair<Node*,Node*> getNodePos();
         int getNodeindex1();//-
         int getNodeindex2();//+
         int get_num();
+        void set_num(int n);//row among the voltage source currents, netlists number them in order
         double get_voltage(double t);
+        double get_amplitude();//dc value, sine amplitude or square on level
+        void set_amplitude(double value);
+        voltage_source* solver_copy()const;//waveform and node indices only, for runs on another thread
         double getFrequency();
         void setPos(int x,int y);
         void setPos(QPoint& p);
         void setNodeRotation(int rotateA);
         void Delete();
-        void InputValue();
+        void setInputValue(const voltageSourcedata &data,double source_frequency,int source_mode);//what the source dialog returns
         bool isDCsource();
+        bool isSquaresource();
+        double getNextBreakpoint(double t);//next switching time after t, INFINITY if none
         bool isDependant();
         ~voltage_source();
 };
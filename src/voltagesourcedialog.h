@@ -4,35 +4,7 @@
 #include <QDialog>
 #include <QLineEdit>
 #include <QLabel>
-
-
-struct voltageDCdata
-{
-    double voltage;
-};
-
-struct voltageSinedata
-{
-    double amplitude;
-    double offset;
-    double phase;
-};
-
-struct voltageSquaredata
-{
-    double Von;
-    double Voff;
-    double Tperiod;
-    double Ton;
-
-};
-
-union voltageSourcedata
-{
-    voltageDCdata dcData;
-    voltageSinedata sineData;
-    voltageSquaredata squareData;
-};
+#include "sourcedata.h"
 
 namespace Ui {
 class Voltagesourcedialog;
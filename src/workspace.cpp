@@ -690,7 +690,8 @@ void Workspace::mouseReleaseEvent(QMouseEvent* e)
                 }
             }
         }
-        circuit->Input();
+        for(Component *c : circuit->getAllComponent())
+            ComponentEditor::edit(c);
     }
         selecting_rect.setRect(-1,-1,-1,-1);
     //qDebug()<<"release!";
@@ -815,7 +816,7 @@ void Workspace::new_component(int component,int x,int y)
             //QRect rect(0,0,80,48);
             QRect rect(0,0,resistorImageWidth,resistorImageHeight);
             //qDebug()<<resistorImageHeight<<" "<<resistorImageHeight;
-            current_component = new Resistor("image/resistor.png",rect,scene);
+            current_component = new Resistor(symbol("image/resistor.png",rect),rect);
             circuit->push_backComponent(current_component);
         //    qDebug() << "x = " << x << "y = " << y;
             current_component->setPos(x,y);
@@ -825,7 +826,7 @@ void Workspace::new_component(int component,int x,int y)
         {
             //QRect rect(0,0,80,48);
             QRect rect(0,0,capacitorImageWidth,capacitorImageHeight);
-            current_component = new Capacitor("image/capacitor.png",rect,scene);
+            current_component = new Capacitor(symbol("image/capacitor.png",rect),rect);
             circuit->push_backComponent(current_component);
             current_component->setPos(x,y);
             break;
@@ -834,7 +835,7 @@ void Workspace::new_component(int component,int x,int y)
         {
             //QRect rect(0,0,80,48);
             QRect rect(0,0,inductorImageWidth,inductorImageHeight);
-            current_component = new Inductor("image/inductor.png",rect,scene);
+            current_component = new Inductor(symbol("image/inductor.png",rect),rect);
             circuit->push_backComponent(current_component);
             current_component->setPos(x,y);
             break;
@@ -842,7 +843,7 @@ void Workspace::new_component(int component,int x,int y)
         case diode:
         {
             QRect rect(0,0,diodeImageWidth,diodeImageHeight);
-            current_component = new Diode("image/diode.png",rect,scene);
+            current_component = new Diode(symbol("image/diode.png",rect),rect);
             circuit->push_backComponent(current_component);
             current_component->setPos(x,y);
             break;
@@ -851,7 +852,7 @@ void Workspace::new_component(int component,int x,int y)
         {
             //QRect rect(0,0,80,48);
             QRect rect(0,0,sourceImageWidth,sourceImageHeight);
-            current_component = new voltage_source("image/voltage_supply.png",rect,scene);
+            current_component = new voltage_source(symbol("image/voltage_supply.png",rect),rect);
             circuit->push_backComponent(current_component);
             current_component->setPos(x,y);
             break;
@@ -859,7 +860,7 @@ void Workspace::new_component(int component,int x,int y)
         case currentSource:
         {
             QRect rect(0,0,sourceImageWidth,sourceImageHeight);
-            current_component = new current_source("image/current_supply.png",rect,scene);
+            current_component = new current_source(symbol("image/current_supply.png",rect),rect);
             circuit->push_backComponent(current_component);
             current_component->setPos(x,y);
             break;
@@ -867,7 +868,7 @@ void Workspace::new_component(int component,int x,int y)
         case CurrentcontrolCurrentSource:
         {
             QRect rect(0,0,sourceImageWidth,sourceImageHeight);
-            current_component = new Current_control_current_source("image/control_current_supply.png",rect,scene);
+            current_component = new Current_control_current_source(symbol("image/control_current_supply.png",rect),rect);
             circuit->push_backComponent(current_component);
             current_component->setPos(x,y);
             break;
@@ -875,7 +876,7 @@ void Workspace::new_component(int component,int x,int y)
         case CurrentcontrolVoltageSource:
         {
             QRect rect(0,0,sourceImageWidth,sourceImageHeight);
-            current_component = new Current_control_voltage_source("image/control_voltage_supply.png",rect,scene);
+            current_component = new Current_control_voltage_source(symbol("image/control_voltage_supply.png",rect),rect);
             circuit->push_backComponent(current_component);
             current_component->setPos(x,y);
             break;
@@ -883,7 +884,7 @@ void Workspace::new_component(int component,int x,int y)
         case VoltagecontrolCurrentSource:
         {
             QRect rect(0,0,sourceImageWidth,sourceImageHeight);
-            current_component = new Voltage_control_current_source("image/control_current_supply.png",rect,scene);
+            current_component = new Voltage_control_current_source(symbol("image/control_current_supply.png",rect),rect);
             circuit->push_backComponent(current_component);
             current_component->setPos(x,y);
             break;
@@ -891,7 +892,7 @@ void Workspace::new_component(int component,int x,int y)
         case VoltagecontrolVoltageSource:
         {
             QRect rect(0,0,sourceImageWidth,sourceImageHeight);
-            current_component = new Voltage_control_voltage_source("image/control_voltage_supply.png",rect,scene);
+            current_component = new Voltage_control_voltage_source(symbol("image/control_voltage_supply.png",rect),rect);
             circuit->push_backComponent(current_component);
             current_component->setPos(x,y);
             break;
@@ -900,7 +901,7 @@ void Workspace::new_component(int component,int x,int y)
         {
        //    QRect rect(0,0,80,48);
             QRect rect(0,0,groundImageWidth,groundImageHeight);
-            current_ground = new Ground("image/ground.png",rect,scene);
+            current_ground = new Ground(symbol("image/ground.png",rect),rect);
             circuit->push_backGround(current_ground);
             current_ground->setPos(x,y);
             break;
@@ -910,6 +911,12 @@ void Workspace::new_component(int component,int x,int y)
     }
 
 }
+ImageItem* Workspace::symbol(const QString &s,QRect &r)
+{
+    ImageItem *image = new ImageItem(s,r);
+    scene->addItem(image);
+    return image;
+}
 void Workspace::delete_mouse_line()
 {
     if(items().contains(mouseLine1)&&items().contains(mouseLine2)){
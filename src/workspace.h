@@ -11,6 +11,7 @@
 #include <QApplication>
 #include <QGraphicsSceneMouseEvent>
 #include <linenodeitem.h>
+#include "imageItem.h"
 #include "circuit.h"
 #include "resistor.h"
 #include "capacitor.h"
@@ -25,6 +26,7 @@
 #include "diode.h"
 #include <matrix.h>
 #include "oscilloscope.h"
+#include "componenteditor.h"
 
 
 
@@ -61,6 +63,7 @@ class Workspace : public QGraphicsView
 
         void delete_current_component();
         void new_component(int component,int x,int y);
+        ImageItem* symbol(const QString &s,QRect &r);//schematic item of a new component, already in the scene
         void setCursorShape(Qt::CursorShape );
         void delete_mouse_line();
 
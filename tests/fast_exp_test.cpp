@@ -0,0 +1,83 @@
+//fast_exp against the scalar diode model Isat*(exp(40*Vd)-1), G = 40*Isat*exp(40*Vd)
+//exits with 1 and prints the first mismatch
+#include "fast_exp.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static int failures = 0;
+static void check(bool ok,const char* what,double x,double got,double want)
+{
+    if(!ok && failures++<10)
+        std::printf("%s: x = %.17g got %.17g want %.17g\n",what,x,got,want);
+}
+static bool close(double got,double want,double tolerance)
+{
+    if(std::isnan(want))
+        return std::isnan(got);
+    if(std::isinf(want) || want==0)
+        return got==want;
+    return std::fabs(got-want)<=tolerance*std::fabs(want);
+}
+
+int main()
+{
+    const double tolerance = 1e-15;//a few ulp: the kernel is within 2.3e-16 of exact exp, libm within half an ulp
+    std::mt19937_64 random(2024);
+
+    //whole range, with the clamps at both ends
+    std::uniform_real_distribution<double> wide(-760,760);
+    std::vector<double> x(100003),y(x.size());
+    for(auto &v:x)
+        v = wide(random);
+    fast_exp::evaluate(x.data(),y.data(),x.size());
+    for(size_t i=0;i<x.size();i++)
+        check(x[i]<-708 ? y[i]==0 : close(y[i],std::exp(x[i]),tolerance),"exp",x[i],y[i],std::exp(x[i]));
+
+    //diode junctions, current and conductance as the batch computes them
+    const double Isat = 1e-12;
+    std::uniform_real_distribution<double> junction(0,1.2);
+    std::vector<double> vd(4099),arg(vd.size()),ex(vd.size());
+    for(size_t i=0;i<vd.size();i++){
+        vd[i] = junction(random);
+        arg[i] = 40*vd[i];
+    }
+    fast_exp::evaluate(arg.data(),ex.data(),arg.size());
+    for(size_t i=0;i<vd.size();i++){
+        double e = std::exp(40*vd[i]);
+        check(close(Isat*(ex[i]-1),Isat*(e-1),1e-12),"diode current",vd[i],Isat*(ex[i]-1),Isat*(e-1));
+        check(close(40*Isat*ex[i],40*Isat*e,tolerance),"diode conductance",vd[i],40*Isat*ex[i],40*Isat*e);
+    }
+
+    //a diverging newton iterate has to come back as nan in every lane and in the tail
+    for(int n=1;n<=9;n++){
+        for(int k=0;k<n;k++){
+            std::vector<double> in(n,0.5),out(n);
+            in[k] = NAN;
+            fast_exp::evaluate(in.data(),out.data(),n);
+            for(int i=0;i<n;i++)
+                check(i==k ? std::isnan(out[i]) : close(out[i],std::exp(0.5),tolerance),"nan lane",in[i],out[i],std::exp(in[i]));
+        }
+    }
+    //an element rounds the same in a full block as in the tail
+    std::vector<double> block(8),full(8),part(8);
+    for(int k=0;k<2000;k++){
+        for(auto &v:block)
+            v = wide(random);
+        fast_exp::evaluate(block.data(),full.data(),8);
+        for(int n=1;n<8;n++){
+            fast_exp::evaluate(block.data(),part.data(),n);
+            for(int i=0;i<n;i++)
+                check(part[i]==full[i],"tail rounding",block[i],part[i],full[i]);
+        }
+    }
+    double edges[] = {-INFINITY,-708.5,-708,0,709.78,709.79,INFINITY,1e-300};
+    double out[8];
+    fast_exp::evaluate(edges,out,8);
+    for(int i=0;i<8;i++)
+        check(edges[i]<-708 ? out[i]==0 : close(out[i],std::exp(edges[i]),tolerance),"edge",edges[i],out[i],std::exp(edges[i]));
+
+    std::printf("fast_exp (%s): %d failures\n",fast_exp::simd() ? "avx2" : "libm",failures);
+    return failures ? 1 : 0;
+}